@@ -9,6 +9,11 @@
 #include <any>
 #include <typeindex>
 #include <map>
+#include <mutex>
+#include <unordered_map>
+#include <string_view>
+#include <cstring>
+#include "FlatHashMap.h"
 
 static std::random_device random_device_seed_generator;
 static XoshiroCpp::Xoshiro256PlusPlus generator(random_device_seed_generator());
@@ -34,6 +39,38 @@ private:
 	std::vector<unsigned int> unusedEntityIDs;
 };
 
+//32 bit asset handle, the low bits index the registry's dense slot table and the high bits hold the slot's generation
+//a handle whose slot was released and reused no longer resolves
+typedef uint32_t AssetHandle;
+static const AssetHandle invalidAssetHandle = 0;
+
+struct UUIDHash
+{
+	size_t operator()(const uuids::uuid& id) const
+	{
+		auto bytes = id.as_bytes();
+		uint64_t low, high;
+		memcpy(&low, bytes.data(), sizeof(low));
+		memcpy(&high, bytes.data() + sizeof(low), sizeof(high));
+		return MixBits(low ^ high);
+	}
+	static size_t MixBits(uint64_t x)
+	{
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdull;
+		x ^= x >> 33;
+		return (size_t)x;
+	}
+};
+
+struct PointerHash
+{
+	size_t operator()(const void* pointer) const
+	{
+		return UUIDHash::MixBits((uint64_t)(uintptr_t)pointer);
+	}
+};
+
 class AssetRegistry
 {
 public:
@@ -79,9 +116,10 @@ public:
 	}
 
 	template <typename T, int chunkSize = 1000>
-	bool PoolPartyCount()
+	int PoolPartyCount()
 	{
-		return registry[typeid(T)].GetCount();
+		auto* pool = GetPool<T, chunkSize>();
+		return pool != nullptr ? pool->GetCount() : 0;
 	}
 
 	template <typename T, int chunkSize = 1000>
@@ -95,6 +133,40 @@ public:
 		return nullptr;
 	}
 
+	template <typename T, int chunkSize = 1000>
+	void ReserveType(int count)
+	{
+		std::scoped_lock<std::recursive_mutex> lock(allocationMutex);
+		RegisterType<T, chunkSize>()->Reserve(count);
+	}
+
+	//packs the live assets of a type and moves their ids along
+	//returns old to new address of the moved assets so other holders of their pointers can be patched
+	template <typename T, int chunkSize = 1000>
+	std::unordered_map<T*, T*> CompactType()
+	{
+		std::scoped_lock<std::recursive_mutex> lock(allocationMutex);
+		std::unordered_map<T*, T*> remap;
+		auto* pool = GetPool<T, chunkSize>();
+		if (pool == nullptr) return remap;
+		remap = pool->Compact();
+		std::vector<std::pair<T*, AssetHandle>> moved;
+		moved.reserve(remap.size());
+		for (auto& [oldAsset, newAsset] : remap)
+		{
+			AssetHandle handle = GetHandle(oldAsset);
+			if (handle == invalidAssetHandle) continue;
+			moved.push_back({ newAsset, handle });
+			handlesByAsset.Erase(oldAsset);
+		}
+		for (auto& [newAsset, handle] : moved)
+		{
+			assetSlots[handle & handleIndexMask].asset = newAsset;
+			handlesByAsset.Insert(newAsset, handle);
+		}
+		return remap;
+	}
+
 	/*
 	template <typename T, int chunkSize = 1000>
 	PoolParty<T, chunkSize>* GetFactory()
@@ -116,6 +188,7 @@ public:
 	template<typename T, int chunkSize = 1000, typename... ArgTypes>
 	T* AllocAsset(ArgTypes... args)
 	{
+		std::scoped_lock<std::recursive_mutex> lock(allocationMutex);
 		auto& type = typeid(T);
 		auto result = registry.find(type);
 		T* asset = nullptr;
@@ -128,23 +201,19 @@ public:
 		{
 			asset = std::any_cast<PoolParty<T, chunkSize>&>(result->second).Alloc(std::forward<ArgTypes>(args)...);
 		}
-		uuids::uuid generatedID = gen();
-		entitiesIds[asset] = generatedID;
-		iDsEntities[generatedID] = asset;
+		RegisterAsset(asset, gen());
 		return asset;
 	}
 
 	template<typename T, int chunkSize = 1000>
 	void DeallocAsset(T* asset)
 	{
-		auto res = entitiesIds.find(asset);
-		if (res != entitiesIds.end())
+		std::scoped_lock<std::recursive_mutex> lock(allocationMutex);
+		AssetHandle handle = GetHandle(asset);
+		if (handle != invalidAssetHandle)
 		{
-			uuids::uuid id = res->second;
-			entitiesIds.erase(res);
 			std::any_cast<PoolParty<T, chunkSize>&>(registry[typeid(T)]).Dealloc(asset);
-			auto res2 = iDsEntities.find(id);
-			iDsEntities.erase(res2);
+			ReleaseHandle(handle);
 		}
 	}
 
@@ -180,6 +249,7 @@ public:
 	template<typename T, int chunkSize = 1000, typename... ArgTypes>
 	T* AllocAssetWithUUID(const uuids::uuid& id, ArgTypes... args)
 	{
+		std::scoped_lock<std::recursive_mutex> lock(allocationMutex);
 		auto asset = (T*)GetAssetByID(id);
 		if (asset == nullptr)
 		{
@@ -195,8 +265,7 @@ public:
 			{
 				asset = std::any_cast<PoolParty<T, chunkSize>&>(result->second).Alloc(std::forward<ArgTypes>(args)...);
 			}
-			entitiesIds[asset] = id;
-			iDsEntities[id] = asset;
+			RegisterAsset(asset, id);
 			return asset;
 		}
 		else
@@ -206,7 +275,7 @@ public:
 	}
 
 	template<typename T, int chunkSize = 1000, typename... ArgTypes>
-	T* AllocAssetWithStrUUID(const std::string& strId, ArgTypes... args)
+	T* AllocAssetWithStrUUID(std::string_view strId, ArgTypes... args)
 	{
 		auto id = uuids::uuid::from_string(strId);
 		if (id.has_value())
@@ -221,48 +290,60 @@ public:
 
 	void* GetAssetByID(const uuids::uuid& id)
 	{
-		auto res = iDsEntities.find(id);
-		if (res != iDsEntities.end())
-			return res->second;
+		const uint32_t* handle = handlesByID.Find(id);
+		if (handle != nullptr)
+			return assetSlots[*handle & handleIndexMask].asset;
 		else
 			return nullptr;
 	}
 
-	void* GetAssetByStringID(const std::string& stringId)
+	void* GetAssetByStringID(std::string_view stringId)
 	{
 		auto id = uuids::uuid::from_string(stringId);
 		if (id.has_value())
-		{
-			auto res = iDsEntities.find(id.value());
-			if (res != iDsEntities.end())
-				return res->second;
-			else
-				return nullptr;
-		}
+			return GetAssetByID(id.value());
 		else
-		{
 			return nullptr;
-		}
 	}
 
-	uuids::uuid GetAssetID(void* asset)
+	uuids::uuid GetAssetID(const void* asset)
 	{
-		auto res = entitiesIds.find(asset);
-		if (res != entitiesIds.end())
-			return res->second;
+		const uint32_t* handle = handlesByAsset.Find(asset);
+		if (handle != nullptr)
+			return assetSlots[*handle & handleIndexMask].id;
 		else
 			return uuids::uuid();
 	}
 
-	std::string GetAssetIDAsString(void* asset)
+	std::string GetAssetIDAsString(const void* asset)
 	{
-		auto res = entitiesIds.find(asset);
-		if (res != entitiesIds.end())
-			return uuids::to_string(res->second);
+		const uint32_t* handle = handlesByAsset.Find(asset);
+		if (handle != nullptr)
+			return uuids::to_string(assetSlots[*handle & handleIndexMask].id);
 		else
 			return std::string();
 	}
 
+	AssetHandle GetHandle(const void* asset)
+	{
+		const uint32_t* handle = handlesByAsset.Find(asset);
+		return handle != nullptr ? *handle : invalidAssetHandle;
+	}
+
+	AssetHandle GetHandleByID(const uuids::uuid& id)
+	{
+		const uint32_t* handle = handlesByID.Find(id);
+		return handle != nullptr ? *handle : invalidAssetHandle;
+	}
+
+	//nullptr when the asset the handle was made for has been deallocated
+	void* GetAsset(AssetHandle handle)
+	{
+		uint32_t index = handle & handleIndexMask;
+		if (index >= assetSlots.size() || assetSlots[index].generation != handle >> handleIndexBits) return nullptr;
+		return assetSlots[index].asset;
+	}
+
 	//still accessible via pool
 	//typename PoolParty<T, chunkSize>::iterator begin() { return pool.begin(); }
 	//typename PoolParty<T, chunkSize>::iterator end() { return pool.end(); }
@@ -272,6 +353,59 @@ public:
 	//typename AssetType::iterator end() { return iDsEntities.end(); }
 
 private:
-	std::map<void*, uuids::uuid> entitiesIds;
-	std::map<uuids::uuid, void*> iDsEntities;
+	//allocation is serialized but lookups are not, so assets are allocated and looked up on the main thread
+	//loading jobs parse into assets allocated before they are submitted
+	//recursive because asset constructors may allocate other assets
+	std::recursive_mutex allocationMutex;
+
+	static const uint32_t handleIndexBits = 24;
+	static const uint32_t handleIndexMask = (1u << handleIndexBits) - 1;
+	static const uint32_t handleGenerationMask = (1u << (32 - handleIndexBits)) - 1;
+
+	struct AssetSlot
+	{
+		void* asset = nullptr;
+		uuids::uuid id;
+		//never 0 so no live handle equals invalidAssetHandle
+		uint32_t generation = 1;
+	};
+
+	AssetHandle RegisterAsset(void* asset, const uuids::uuid& id)
+	{
+		uint32_t index;
+		if (freeAssetSlots.size() > 0)
+		{
+			index = freeAssetSlots.back();
+			freeAssetSlots.pop_back();
+		}
+		else
+		{
+			index = (uint32_t)assetSlots.size();
+			assetSlots.emplace_back();
+		}
+		AssetSlot& slot = assetSlots[index];
+		slot.asset = asset;
+		slot.id = id;
+		AssetHandle handle = (slot.generation << handleIndexBits) | index;
+		handlesByAsset.Insert(asset, handle);
+		handlesByID.Insert(id, handle);
+		return handle;
+	}
+
+	void ReleaseHandle(AssetHandle handle)
+	{
+		uint32_t index = handle & handleIndexMask;
+		AssetSlot& slot = assetSlots[index];
+		handlesByAsset.Erase(slot.asset);
+		handlesByID.Erase(slot.id);
+		slot.asset = nullptr;
+		slot.generation = (slot.generation + 1) & handleGenerationMask;
+		if (slot.generation == 0) slot.generation = 1;
+		freeAssetSlots.push_back(index);
+	}
+
+	std::vector<AssetSlot> assetSlots;
+	std::vector<uint32_t> freeAssetSlots;
+	FlatHashMap<const void*, PointerHash> handlesByAsset;
+	FlatHashMap<uuids::uuid, UUIDHash> handlesByID;
 };
\ No newline at end of file
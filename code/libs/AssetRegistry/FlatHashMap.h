@@ -0,0 +1,107 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+//open addressing hash from a key to a 32 bit value, linear probing in one flat array
+//erase shifts the following entries back so lookups never walk over tombstones
+template <typename Key, typename Hash>
+class FlatHashMap
+{
+public:
+	FlatHashMap() { count = 0; mask = 0; }
+	~FlatHashMap() {}
+
+	//returns nullptr when the key is not present
+	const uint32_t* Find(const Key& key) const
+	{
+		if (count == 0) return nullptr;
+		for (size_t i = Hash()(key) & mask; ; i = (i + 1) & mask)
+		{
+			const Entry& entry = entries[i];
+			if (!entry.used) return nullptr;
+			if (entry.key == key) return &entry.value;
+		}
+	}
+
+	void Insert(const Key& key, uint32_t value)
+	{
+		if ((count + 1) * 4 > entries.size() * 3) Rehash(entries.size() < 16 ? 32 : entries.size() * 2);
+		size_t i = Hash()(key) & mask;
+		for (; entries[i].used; i = (i + 1) & mask)
+		{
+			if (entries[i].key == key)
+			{
+				entries[i].value = value;
+				return;
+			}
+		}
+		entries[i].key = key;
+		entries[i].value = value;
+		entries[i].used = true;
+		count++;
+	}
+
+	bool Erase(const Key& key)
+	{
+		if (count == 0) return false;
+		size_t i = Hash()(key) & mask;
+		for (; ; i = (i + 1) & mask)
+		{
+			if (!entries[i].used) return false;
+			if (entries[i].key == key) break;
+		}
+		//pull back every entry of the run that would not be found past the new hole
+		size_t hole = i;
+		for (size_t j = (hole + 1) & mask; entries[j].used; j = (j + 1) & mask)
+		{
+			size_t home = Hash()(entries[j].key) & mask;
+			if (((j - home) & mask) >= ((j - hole) & mask))
+			{
+				entries[hole] = entries[j];
+				hole = j;
+			}
+		}
+		entries[hole].used = false;
+		count--;
+		return true;
+	}
+
+	void Reserve(size_t elementCount)
+	{
+		size_t capacity = 32;
+		while (capacity * 3 < elementCount * 4) capacity *= 2;
+		if (capacity > entries.size()) Rehash(capacity);
+	}
+
+	void Clear()
+	{
+		entries.clear();
+		count = 0;
+		mask = 0;
+	}
+
+	size_t GetCount() const { return count; }
+private:
+	struct Entry
+	{
+		Key key;
+		uint32_t value;
+		bool used = false;
+	};
+
+	void Rehash(size_t capacity)
+	{
+		std::vector<Entry> oldEntries(capacity);
+		oldEntries.swap(entries);
+		mask = capacity - 1;
+		count = 0;
+		for (auto& entry : oldEntries)
+		{
+			if (entry.used) Insert(entry.key, entry.value);
+		}
+	}
+
+	std::vector<Entry> entries;
+	size_t count;
+	size_t mask;
+};
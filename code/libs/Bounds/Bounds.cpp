@@ -15,8 +15,8 @@ const glm::vec3 Bounds::vertices[8] = {
 	glm::vec3(-0.5, 0.5, -0.5)
 };
 
-double Bounds::updateBoundsTime;
-double Bounds::updateMinMaxTime;
+std::atomic<double> Bounds::updateBoundsTime;
+std::atomic<double> Bounds::updateMinMaxTime;
 
 Bounds::Bounds()
 {
@@ -30,6 +30,9 @@ Bounds::Bounds()
 	aabb.color = glm::vec3(1.f, 0.54f, 0.f);
 	centeredPosition = glm::vec3(0);
 	CenteredTopDownTransform = glm::mat4(1);
+	dirty = true;
+	nodeVersion = 0;
+	version = 0;
 }
 
 Bounds::Bounds(const glm::vec3& Center, const glm::vec3& Dimensions, const std::string& Name){
@@ -43,6 +46,9 @@ Bounds::Bounds(const glm::vec3& Center, const glm::vec3& Dimensions, const std::
 	aabb.color = glm::vec3(1.f, 0.54f, 0.f);
 	centeredPosition = glm::vec3(0);
 	CenteredTopDownTransform = glm::mat4(1);
+	dirty = true;
+	nodeVersion = 0;
+	version = 0;
 }
 
 void Bounds::Init(Object * parent)
@@ -52,8 +58,18 @@ void Bounds::Init(Object * parent)
 	parent->bounds = this;
 }
 
+bool Bounds::IsThreadSafe()
+{
+	return true;
+}
+
 void Bounds::Update()
 {
+	if (!dirty && nodeVersion == object->node->worldVersion) return;
+	dirty = false;
+	nodeVersion = object->node->worldVersion;
+	version++;
+
 	std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
 	std::chrono::duration<double> elapsed_seconds;
 
@@ -79,7 +95,7 @@ void Bounds::Update()
 
 	endMinMax = std::chrono::high_resolution_clock::now();
 	elapsed_seconds = endMinMax - startMinMax;
-	updateMinMaxTime += elapsed_seconds.count();
+	updateMinMaxTime.fetch_add(elapsed_seconds.count(), std::memory_order_relaxed);
 
 	aabb.extents = obb.mm.max - obb.mm.min;
 	MathUtils::SetScale(aabb.model, aabb.extents);
@@ -87,18 +103,20 @@ void Bounds::Update()
 
 	end = std::chrono::high_resolution_clock::now();
 	elapsed_seconds = end - start;
-	updateBoundsTime += elapsed_seconds.count();
+	updateBoundsTime.fetch_add(elapsed_seconds.count(), std::memory_order_relaxed);
 }
 
 void Bounds::SetBoundsCenter(const glm::vec3& center)
 {
 	MathUtils::SetPosition(MeshCenterM, center);
 	centerOfMesh = center;
+	dirty = true;
 }
 
 void Bounds::SetBoundsDimensions(const glm::vec3& newDimensions)
 {
 	dimensions = newDimensions;
+	dirty = true;
 }
 
 glm::vec3 Bounds::GetBoundsCenter()
@@ -127,6 +145,7 @@ void Bounds::SetUp(const glm::vec3& newCenter, const glm::vec3& newDimensions, c
 	centerOfMesh = newCenter;
 	dimensions = newDimensions;
 	name = newName;
+	dirty = true;
 }
 
 void Bounds::UpdateMinMax(const glm::mat3& modelM, const glm::vec3& position)
@@ -2,6 +2,7 @@
 #include "MyMathLib.h"
 #include "OBBAABB.h"
 #include <string>
+#include <atomic>
 #include "Component.h"
 
 class Bounds : public Component
@@ -12,6 +13,7 @@ public:
 	Bounds(const glm::vec3& Center, const glm::vec3& Dimensions, const std::string& Name);
 
 	void Update();
+	bool IsThreadSafe();
 	void Init(Object* parent);
 	glm::mat4 CenteredTopDownTransform;
 	glm::mat4 MeshCenterM;
@@ -34,7 +36,12 @@ public:
 	void UpdateMinMax(const glm::mat4& modelMatrix, const glm::vec3& position);
 	Component* Clone();
 	static const glm::vec3 vertices[8];
-	static double updateBoundsTime;
-	static double updateMinMaxTime;
+	static std::atomic<double> updateBoundsTime;
+	static std::atomic<double> updateMinMaxTime;
 	glm::vec3 currentVertex;
+	//Update skips the recompute unless the node moved or the bounds were changed through the setters
+	bool dirty;
+	unsigned int nodeVersion;
+	//incremented every time the bounds are recomputed
+	unsigned int version;
 };
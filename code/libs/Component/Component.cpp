@@ -3,6 +3,7 @@
 #include <string>
 Component::Component()
 {
+	object = nullptr;
 }
 
 Component::~Component()
@@ -18,6 +19,11 @@ void Component::Update()
 {
 }
 
+bool Component::IsThreadSafe()
+{
+	return false;
+}
+
 Component* Component::Clone()
 {
 	return new Component(*this);
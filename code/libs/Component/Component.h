@@ -8,6 +8,8 @@ public:
 	virtual ~Component();
 	virtual void Init(Object* parent);
 	virtual void Update();
+	//thread safe components only touch their own object and may be updated from the job system workers
+	virtual bool IsThreadSafe();
 	virtual Component* Clone();
 	Object* object;
 protected:
@@ -14,41 +14,40 @@
 FastInstanceSystem::FastInstanceSystem()
 {
 	ActiveCount = 0;
+	MaxCount = 0;
+	firstID = 0;
 	paused = false;
-	objectContainer = nullptr;
+	view.node = &viewNode;
 }
 
 FastInstanceSystem::FastInstanceSystem(int maxCount, OBJ* object)
 {
-	MaxCount = maxCount;
-	ActiveCount = 0;
-	objectContainer = new Object[maxCount];
-	paused = false;
-	indexMap.reserve(maxCount);
-	gpuOrderedObjects.reserve(maxCount);
-	objectsToUpdate.reserve(maxCount);
-	objectsToReturn.reserve(maxCount);
-	GraphicsManager::LoadOBJToVAO(object, &vao);
-	SetUpGPUBuffers();
-	///mat.AssignTexture(GraphicsStorage::textures.at(0));
+	view.node = &viewNode;
+	SetUp(maxCount, object);
 }
 
 FastInstanceSystem::~FastInstanceSystem()
 {
-	delete[] objectContainer;
 }
 
 void FastInstanceSystem::SetUp(int maxCount, OBJ* object)
 {
 	MaxCount = maxCount;
 	ActiveCount = 0;
-	objectContainer = new Object[maxCount];
 	paused = false;
-	indexMap.reserve(maxCount);
-	gpuOrderedObjects.reserve(maxCount);
-	objectsToUpdate.reserve(maxCount);
-	objectsToReturn.reserve(maxCount);
+	instances.Resize(maxCount);
+	firstID = Object::ReserveIDs(maxCount);
+	denseIndexOfHandle.assign(maxCount, -1);
+	handleOfDenseIndex.assign(maxCount, -1);
+	freeHandles.clear();
+	freeHandles.reserve(maxCount);
+	for (int handle = maxCount - 1; handle >= 0; handle--)
+	{
+		freeHandles.push_back(handle);
+	}
 	GraphicsManager::LoadOBJToVAO(object, &vao);
+	instances.meshCenter = vao.center;
+	instances.meshDimensions = vao.dimensions;
 	SetUpGPUBuffers();
 	///mat.AssignTexture(GraphicsStorage::textures.at(0));
 }
@@ -73,14 +72,18 @@ void FastInstanceSystem::SetUpGPUBuffers()
 	color = &materialColorBuffer->layout.locations[0];
 }
 
+void FastInstanceSystem::UpdateGPUBuffers()
+{
+	modelBuffer->Update();
+	objectIDBuffer->Update();
+	materialColorBuffer->Update();
+}
+
 int FastInstanceSystem::Draw()
 {
 	if (dirty)
 	{
-		//UpdateCPUBuffers();
-		//UpdateGPUBuffers();
-		UpdateObjects();
-		ReturnObjects();
+		UpdateGPUBuffers();
 		dirty = false;
 	}
 	
@@ -92,89 +95,95 @@ int FastInstanceSystem::Draw()
 }
 
 //this is for runtime
-Object* FastInstanceSystem::GetObject()
+int FastInstanceSystem::GetInstance()
 {
-	if (ActiveCount < MaxCount)
-	{
-		Object* object = &objectContainer[ActiveCount];
-		indexMap[object] = ActiveCount;
-		objectsToUpdate.push_back(object);
-		gpuOrderedObjects.push_back(object);
-		dirty = true;
-		modelBuffer->IncreaseInstanceCount();
-		objectIDBuffer->IncreaseInstanceCount();
-		return object;
-	}
-	else
-	{
-		Object* object = &objectContainer[MaxCount - 1];
-		objectsToUpdate.push_back(object);
-		dirty = true;
-		return object;
-	}
+	if (freeHandles.empty()) return -1;
+	int handle = freeHandles.back();
+	freeHandles.pop_back();
+	int denseIndex = ActiveCount++;
+	denseIndexOfHandle[handle] = denseIndex;
+	handleOfDenseIndex[denseIndex] = handle;
+	instances.ids[denseIndex] = firstID + handle;
+	instances.colors[denseIndex] = glm::vec4(1.f);
+	instances.drawFlags[denseIndex] = InstanceDraw | InstanceDrawAlways;
+	PackInstance(denseIndex);
+	modelBuffer->activeCount = ActiveCount;
+	objectIDBuffer->activeCount = ActiveCount;
+	materialColorBuffer->activeCount = ActiveCount;
+	return handle;
 }
 
 //this is for runtime
-void FastInstanceSystem::ReturnObject(Object* object)
+void FastInstanceSystem::ReturnInstance(int handle)
 {
-	objectsToReturn.push_back(object);
+	if (handle < 0 || handle >= (int)MaxCount || denseIndexOfHandle[handle] == -1) return;
+	int denseIndex = denseIndexOfHandle[handle];
+	int lastIndex = --ActiveCount;
+	if (denseIndex != lastIndex)
+	{
+		int lastHandle = handleOfDenseIndex[lastIndex];
+		instances.Move(lastIndex, denseIndex);
+		denseIndexOfHandle[lastHandle] = denseIndex;
+		handleOfDenseIndex[denseIndex] = lastHandle;
+		PackInstance(denseIndex);
+	}
+	denseIndexOfHandle[handle] = -1;
+	handleOfDenseIndex[lastIndex] = -1;
+	instances.drawFlags[lastIndex] = 0;
+	freeHandles.push_back(handle);
+	modelBuffer->activeCount = ActiveCount;
+	objectIDBuffer->activeCount = ActiveCount;
+	materialColorBuffer->activeCount = ActiveCount;
 	dirty = true;
 }
 
 //this is for runtime
-void FastInstanceSystem::UpdateObject(Object* object)
+void FastInstanceSystem::SetInstanceTransform(int handle, const glm::mat4& world)
 {
-	objectsToUpdate.push_back(object);
-	dirty = true;
+	int denseIndex = denseIndexOfHandle[handle];
+	if (denseIndex == -1) return;
+	instances.SetWorld(denseIndex, world);
+	PackInstance(denseIndex);
 }
 
 //this is for runtime
-void FastInstanceSystem::UpdateObjects()
+void FastInstanceSystem::SetInstanceColor(int handle, const glm::vec4& color)
 {
-	for (auto object : objectsToUpdate)
-	{
-		std::unordered_map<Object*, int>::iterator it = indexMap.find(object);
-		if (it == indexMap.end()) continue;
-
-		int index = it->second;
-
-		modelBuffer->SetData(index, *model, &object->node->TopDownTransformF);
-		objectIDBuffer->SetData(index, *id, &object->ID);
-		//glNamedBufferSubData(materialColorBuffer, index * sizeof(Vector4F), sizeof(Vector4F), &object->mat->colorShininess);
-	}
-	objectsToUpdate.clear();
+	int denseIndex = denseIndexOfHandle[handle];
+	if (denseIndex == -1) return;
+	instances.colors[denseIndex] = color;
+	PackInstance(denseIndex);
 }
 
-//this is for runtime
-void FastInstanceSystem::ReturnObjects()
+int FastInstanceSystem::FindInstance(unsigned int id)
 {
-	for (auto object : objectsToReturn)
-	{
-		std::unordered_map<Object*, int>::iterator it = indexMap.find(object);
-
-		if (it == indexMap.end()) continue;
-
-		int index = it->second;
-
-		ActiveCount--;
+	if (id < firstID || id - firstID >= MaxCount) return -1;
+	int handle = (int)(id - firstID);
+	return denseIndexOfHandle[handle] != -1 ? handle : -1;
+}
 
-		//if (index == ActiveCount) continue;
+Object* FastInstanceSystem::GetView(int handle)
+{
+	viewHandle = handle;
+	instances.ToView(denseIndexOfHandle[handle], view);
+	return &view;
+}
 
-		//Scene::Instance()->unregisterForPicking(object);
-		indexMap[object] = ActiveCount;
-		Object* lastObject = gpuOrderedObjects[ActiveCount];
-		indexMap[lastObject] = index; //we have no good way of knowing the last object, i know the order via map
+void FastInstanceSystem::CommitView()
+{
+	if (viewHandle < 0 || denseIndexOfHandle[viewHandle] == -1) return;
+	int denseIndex = denseIndexOfHandle[viewHandle];
+	instances.FromView(denseIndex, view);
+	PackInstance(denseIndex);
+}
 
-		modelBuffer->SetData(index, *model, &lastObject->node->TopDownTransformF);
-		objectIDBuffer->SetData(index, *id, &lastObject->ID);
-		modelBuffer->activeCount--;
-		objectIDBuffer->activeCount--;
-		//glNamedBufferSubData(materialColorBuffer, index * sizeof(Vector4F), sizeof(Vector4F), &lastObject->mat->colorShininess);
-	
-		gpuOrderedObjects[ActiveCount] = object;
-		gpuOrderedObjects[index] = lastObject;
-	}
-	objectsToReturn.clear();
+void FastInstanceSystem::PackInstance(int denseIndex)
+{
+	instances.Pack(denseIndex, denseIndex, modelBuffer, objectIDBuffer, materialColorBuffer);
+	modelBuffer->MarkDirty(denseIndex, 1);
+	objectIDBuffer->MarkDirty(denseIndex, 1);
+	materialColorBuffer->MarkDirty(denseIndex, 1);
+	dirty = true;
 }
 
 void FastInstanceSystem::Update()
@@ -191,26 +200,23 @@ void FastInstanceSystem::Update()
 void FastInstanceSystem::Init(Object * parent)
 {
 	Component::Init(parent);
+	SceneGraph::Instance()->registerForPicking(this);
 
-	for (size_t i = 0; i < MaxCount; i++)
-	{
-		Material* newMaterial = GraphicsStorage::assetRegistry.AllocAsset<Material>();
-		newMaterial->name = "fastInsSysMat";
-		*newMaterial = mat;
-		objectContainer[i].AssignMaterial(newMaterial);
-		objectContainer[i].node->SetScale(SceneGraph::Instance()->generateRandomIntervallVectorSpherical(1, 15));
-		objectContainer[i].node->SetPosition(SceneGraph::Instance()->generateRandomIntervallVectorSpherical(2, 15));
-		objectContainer[i].bounds->SetUp(parent->bounds->centerOfMesh, parent->bounds->dimensions, parent->bounds->name);
-		objectContainer[i].node->UpdateNode(*parent->node);
-		SceneGraph::Instance()->registerForPicking(&objectContainer[i]);
-	}
+	instances.meshCenter = parent->bounds->centerOfMesh;
+	instances.meshDimensions = parent->bounds->dimensions;
 	for (size_t i = 0; i < MaxCount/10; i++)
 	{
-		GetObject();
+		glm::vec3 scale = SceneGraph::Instance()->generateRandomIntervallVectorSpherical(1, 15);
+		glm::vec3 position = SceneGraph::Instance()->generateRandomIntervallVectorSpherical(2, 15);
+		glm::mat4 world;
+		Node::ComposeTransform(position, glm::mat3(glm::scale(glm::mat4(1.f), scale)), parent->node->TopDownTransform, world);
+		SetInstanceTransform(GetInstance(), world);
 	}
 }
 
 Component* FastInstanceSystem::Clone()
 {
-	return new FastInstanceSystem(*this);
+	FastInstanceSystem* clone = new FastInstanceSystem(*this);
+	clone->view.node = &clone->viewNode;
+	return clone;
 }
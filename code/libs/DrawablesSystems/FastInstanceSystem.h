@@ -3,9 +3,10 @@
 #include "Component.h"
 #include "Node.h"
 #include "MinMax.h"
-#include <unordered_map>
 #include "Vao.h"
 #include "Material.h"
+#include "Object.h"
+#include "InstanceRecords.h"
 
 class OBJ;
 class LocationLayout;
@@ -19,12 +20,19 @@ public:
 	~FastInstanceSystem();
 	void SetUp(int maxCount, OBJ* object);
 	void SetUpGPUBuffers();
+	void UpdateGPUBuffers();
 	int Draw();
-	Object* GetObject();
-	void ReturnObject(Object* object);
-	void UpdateObject(Object* object);
-	void UpdateObjects();
-	void ReturnObjects();
+	//returns a handle that stays valid until it's returned, -1 when the system is full
+	int GetInstance();
+	//the last active instance is moved into the hole so the active ones stay packed
+	void ReturnInstance(int handle);
+	void SetInstanceTransform(int handle, const glm::mat4& world);
+	void SetInstanceColor(int handle, const glm::vec4& color);
+	//handle of the instance with a picked id, -1 when it's not one of ours
+	int FindInstance(unsigned int id);
+	//object standing in for an instance when the editor needs one, it's shared so commit before viewing another
+	Object* GetView(int handle);
+	void CommitView();
 	void Update();
 	void Init(Object* parent);
 	Component* Clone();
@@ -34,11 +42,12 @@ public:
 	VertexArray vao;
 	Material mat;
 
-	Object* objectContainer;
-	std::unordered_map<Object*, int> indexMap;
-	std::vector<Object*> gpuOrderedObjects;
-	std::vector<Object*> objectsToReturn;
-	std::vector<Object*> objectsToUpdate;
+	//active instances in gpu order
+	InstanceRecords instances;
+	std::vector<int> denseIndexOfHandle;
+	std::vector<int> handleOfDenseIndex;
+	std::vector<int> freeHandles;
+	unsigned int firstID;
 
 	VertexBufferDynamic* modelBuffer;
 	VertexBufferDynamic* objectIDBuffer;
@@ -48,4 +57,9 @@ public:
 	LocationLayout* color;
 	bool dirty = false;
 	bool paused = true;
+private:
+	void PackInstance(int denseIndex);
+	Object view;
+	Node viewNode;
+	int viewHandle = -1;
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "InstanceRecords.h"
+#include <cstring>
+#include "Object.h"
+#include "Frustum.h"
+#include "Vbo.h"
+
+void InstanceRecords::Resize(unsigned int count)
+{
+	world.resize(count, glm::mat4(1.f));
+	//padded to whole groups of four for the sphere tests, the padding is never drawn
+	unsigned int paddedCount = (count + 3) & ~3u;
+	sphereX.resize(paddedCount, 0.f);
+	sphereY.resize(paddedCount, 0.f);
+	sphereZ.resize(paddedCount, 0.f);
+	sphereRadius.resize(paddedCount, 0.f);
+	ids.resize(count, 0);
+	colors.resize(count, glm::vec4(1.f));
+	drawFlags.resize(count, 0);
+}
+
+void InstanceRecords::SetWorld(unsigned int index, const glm::mat4& worldMatrix)
+{
+	world[index] = worldMatrix;
+	//same sphere Bounds computes, centered on the mesh and around the scaled box
+	glm::vec3 center = glm::vec3(worldMatrix * glm::vec4(meshCenter, 1.f));
+	glm::vec3 halfExtents = meshDimensions * MathUtils::ExtractScale(worldMatrix) * 0.5f;
+	sphereX[index] = center.x;
+	sphereY[index] = center.y;
+	sphereZ[index] = center.z;
+	sphereRadius[index] = glm::length(halfExtents);
+}
+
+void InstanceRecords::Move(unsigned int from, unsigned int to)
+{
+	world[to] = world[from];
+	sphereX[to] = sphereX[from];
+	sphereY[to] = sphereY[from];
+	sphereZ[to] = sphereZ[from];
+	sphereRadius[to] = sphereRadius[from];
+	ids[to] = ids[from];
+	colors[to] = colors[from];
+	drawFlags[to] = drawFlags[from];
+}
+
+unsigned int InstanceRecords::CullAndPack(unsigned int count, Frustum* frustum, VertexBufferDynamic* modelBuffer, VertexBufferDynamic* idBuffer, VertexBufferDynamic* colorBuffer)
+{
+	modelBuffer->Resize(count);
+	idBuffer->Resize(count);
+	colorBuffer->Resize(count);
+
+	unsigned int written = 0;
+	for (unsigned int i = 0; i < count; i += 4)
+	{
+		unsigned int inView = frustum != nullptr ? frustum->AreSpheresInView4(&sphereX[i], &sphereY[i], &sphereZ[i], &sphereRadius[i], Frustum::allPlanes) : 0xF;
+		if (count - i < 4) inView &= (1u << (count - i)) - 1;
+		while (inView != 0)
+		{
+			unsigned int lane = 0;
+			while (!(inView & (1u << lane))) lane++;
+			inView &= ~(1u << lane);
+			unsigned int index = i + lane;
+			unsigned char flags = drawFlags[index];
+			if (!(flags & InstanceDraw)) continue;
+			Pack(index, written++, modelBuffer, idBuffer, colorBuffer);
+			if (!(flags & InstanceDrawAlways)) drawFlags[index] = 0;
+		}
+	}
+
+	modelBuffer->MarkDirty(0, written);
+	idBuffer->MarkDirty(0, written);
+	colorBuffer->MarkDirty(0, written);
+	modelBuffer->activeCount = written;
+	idBuffer->activeCount = written;
+	colorBuffer->activeCount = written;
+	return written;
+}
+
+void InstanceRecords::Pack(unsigned int index, unsigned int element, VertexBufferDynamic* modelBuffer, VertexBufferDynamic* idBuffer, VertexBufferDynamic* colorBuffer) const
+{
+	memcpy(&modelBuffer->cpuData[modelBuffer->layout.GetStride() * element], &world[index], sizeof(glm::mat4));
+	memcpy(&idBuffer->cpuData[idBuffer->layout.GetStride() * element], &ids[index], sizeof(unsigned int));
+	memcpy(&colorBuffer->cpuData[colorBuffer->layout.GetStride() * element], &colors[index], sizeof(glm::vec4));
+}
+
+void InstanceRecords::ToView(unsigned int index, Object& view) const
+{
+	const glm::mat4& worldMatrix = world[index];
+	view.ID = ids[index];
+	view.node->SetPosition(MathUtils::GetPosition(worldMatrix));
+	view.node->SetScale(MathUtils::ExtractScale(worldMatrix));
+	view.node->SetOrientation(glm::quat_cast(MathUtils::ExtractRotation(worldMatrix)));
+	view.node->UpdateNode(Node());
+}
+
+void InstanceRecords::FromView(unsigned int index, Object& view)
+{
+	view.node->UpdateNode(Node());
+	SetWorld(index, view.node->TopDownTransform);
+}
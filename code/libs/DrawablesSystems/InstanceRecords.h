@@ -0,0 +1,43 @@
+#pragma once
+#include "MyMathLib.h"
+#include <vector>
+
+class Object;
+class VertexBufferDynamic;
+class Frustum;
+
+enum InstanceDrawFlags : unsigned char
+{
+	InstanceDraw = 1,
+	InstanceDrawAlways = 2
+};
+
+//per instance state of the instance systems kept as one array per field, no heap objects per instance
+//bounding spheres are split in float streams so the frustum tests four at a time
+struct InstanceRecords
+{
+	std::vector<glm::mat4> world;
+	std::vector<float> sphereX, sphereY, sphereZ, sphereRadius;
+	std::vector<unsigned int> ids;
+	std::vector<glm::vec4> colors;
+	std::vector<unsigned char> drawFlags;
+	//mesh bounds the spheres are derived from
+	glm::vec3 meshCenter = glm::vec3(0.f);
+	glm::vec3 meshDimensions = glm::vec3(1.f);
+
+	void Resize(unsigned int count);
+	unsigned int Count() const { return (unsigned int)world.size(); }
+	void SetWorld(unsigned int index, const glm::mat4& worldMatrix);
+	void Move(unsigned int from, unsigned int to);
+
+	//writes the instances of the first count records that pass the frustum and draw flags straight into the buffers' cpu data
+	//draw once instances are cleared as they are written, returns how many were written
+	unsigned int CullAndPack(unsigned int count, Frustum* frustum, VertexBufferDynamic* modelBuffer, VertexBufferDynamic* idBuffer, VertexBufferDynamic* colorBuffer);
+	//writes record index to buffer element element
+	void Pack(unsigned int index, unsigned int element, VertexBufferDynamic* modelBuffer, VertexBufferDynamic* idBuffer, VertexBufferDynamic* colorBuffer) const;
+
+	//objects are only built on demand, the view gets the record's id and a parentless node with its world transform
+	void ToView(unsigned int index, Object& view) const;
+	//takes the transform of a view edited through its node back into the record
+	void FromView(unsigned int index, Object& view);
+};
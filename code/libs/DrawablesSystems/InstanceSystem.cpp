@@ -11,46 +11,50 @@
 InstanceSystem::InstanceSystem()
 {
 	LastUsed = 0;
+	MaxCount = 0;
+	firstID = 0;
 	paused = true;
-	objectContainer = nullptr;
+	view.node = &viewNode;
 }
 
 InstanceSystem::InstanceSystem(int maxCount, OBJ* object)
 {
-	MaxCount = maxCount;
-	LastUsed = 0;
-	objectContainer = new Object[maxCount];
-	paused = true;
-	GraphicsManager::LoadOBJToVAO(object, &vao);
-	SetUpGPUBuffers();
+	view.node = &viewNode;
+	SetUp(maxCount, object);
 }
 
 InstanceSystem::~InstanceSystem()
 {
-	delete[] objectContainer;
 }
 
 void InstanceSystem::SetUp(int maxCount, OBJ* object)
 {
 	MaxCount = maxCount;
 	LastUsed = 0;
-	objectContainer = new Object[maxCount];
+	instances.Resize(maxCount);
+	firstID = Object::ReserveIDs(maxCount);
+	for (unsigned int i = 0; i < MaxCount; i++)
+	{
+		instances.ids[i] = firstID + i;
+	}
 	paused = true;
 	GraphicsManager::LoadOBJToVAO(object, &vao);
+	instances.meshCenter = vao.center;
+	instances.meshDimensions = vao.dimensions;
 	SetUpGPUBuffers();
 }
 
 int InstanceSystem::FindUnused()
 {
 	for (int i = LastUsed; i < MaxCount; i++){
-		if (objectContainer[i].CanDraw() == false){
+		if (!(instances.drawFlags[i] & InstanceDraw)){
 			LastUsed = i;
 			return i;
 		}
 	}
 
 	for (int i = 0; i < LastUsed; i++){
-		if (objectContainer[i].CanDraw() == false){
+		if (!(instances.drawFlags[i] & InstanceDraw)){
 			LastUsed = i;
 			return i;
 		}
@@ -61,43 +65,12 @@ int InstanceSystem::FindUnused()
 
 void InstanceSystem::UpdateCPUBuffers()
 {
-	modelBuffer->activeCount = 0;
-	objectIDBuffer->activeCount = 0;
-	for (int i = 0; i < MaxCount; i++)
-	{
-		Object& object = objectContainer[i];
-
-		if (object.CanDraw() && SceneGraph::Instance()->frustum.isBoundingSphereInView(object.bounds->centeredPosition, object.bounds->circumRadius))
-		{
-			//object.node->UpdateNode(this->object->node);
-			modelBuffer->SetData(modelBuffer->activeCount, *model, &object.node->TopDownTransformF);
-			modelBuffer->SetData(objectIDBuffer->activeCount, *id, &object.ID);
-			//materialColorShininess[ActiveCount] = object.mat->colorShininess;
-			modelBuffer->IncreaseInstanceCount();
-			objectIDBuffer->IncreaseInstanceCount();
-
-			object.UpdateDrawState();
-		}
-	}
+	instances.CullAndPack(MaxCount, &SceneGraph::Instance()->frustum, modelBuffer, objectIDBuffer, materialColorBuffer);
 }
 
 void InstanceSystem::UpdateCPUBuffersNoCulling()
 {
-	modelBuffer->activeCount = 0;
-	objectIDBuffer->activeCount = 0;
-	for (int i = 0; i < MaxCount; i++)
-	{
-		Object& object = objectContainer[i];
-
-		//object.node->UpdateNode(this->object->node);
-		modelBuffer->SetData(modelBuffer->activeCount, *model, &object.node->TopDownTransformF);
-		modelBuffer->SetData(objectIDBuffer->activeCount, *id, &object.ID);
-		//materialColorShininess[ActiveCount] = object.mat->colorShininess;
-		modelBuffer->IncreaseInstanceCount();
-		objectIDBuffer->IncreaseInstanceCount();
-
-		object.UpdateDrawState();
-	}
+	instances.CullAndPack(MaxCount, nullptr, modelBuffer, objectIDBuffer, materialColorBuffer);
 }
 
 void InstanceSystem::SetUpGPUBuffers()
@@ -123,7 +96,7 @@ void InstanceSystem::UpdateGPUBuffers()
 {
 	modelBuffer->Update();
 	objectIDBuffer->Update();
-	//glNamedBufferSubData(materialColorBuffer, 0, ActiveCount * sizeof(Vector4F), materialColorShininess);
+	materialColorBuffer->Update();
 }
 
 int InstanceSystem::Draw()
@@ -141,20 +114,57 @@ int InstanceSystem::Draw()
 	return modelBuffer->activeCount;
 }
 
-Object* InstanceSystem::GetObject()
+int InstanceSystem::GetInstance()
+{
+	int index = FindUnused();
+	instances.drawFlags[index] = InstanceDraw | InstanceDrawAlways;
+	dirty = true;
+	return index;
+}
+
+int InstanceSystem::GetInstanceOnce()
 {
-	Object* bb = &objectContainer[FindUnused()];
-	bb->DrawAlways();
+	int index = FindUnused();
+	instances.drawFlags[index] = InstanceDraw;
 	dirty = true;
-	return bb;
+	return index;
+}
+
+void InstanceSystem::StopInstance(int index)
+{
+	instances.drawFlags[index] = 0;
+	dirty = true;
+}
+
+void InstanceSystem::SetInstanceTransform(int index, const glm::mat4& world)
+{
+	instances.SetWorld(index, world);
+	dirty = true;
+}
+
+void InstanceSystem::SetInstanceColor(int index, const glm::vec4& color)
+{
+	instances.colors[index] = color;
+	dirty = true;
+}
+
+int InstanceSystem::FindInstance(unsigned int id)
+{
+	return id >= firstID && id - firstID < MaxCount ? (int)(id - firstID) : -1;
+}
+
+Object* InstanceSystem::GetView(int index)
+{
+	viewIndex = index;
+	instances.ToView(index, view);
+	return &view;
 }
 
-Object* InstanceSystem::GetObjectOnce()
+void InstanceSystem::CommitView()
 {
-	Object* bb = &objectContainer[FindUnused()];
-	bb->DrawOnce();
+	if (viewIndex < 0) return;
+	instances.FromView(viewIndex, view);
 	dirty = true;
-	return bb;
 }
 
 void InstanceSystem::Update()
@@ -169,19 +179,18 @@ void InstanceSystem::Update()
 void InstanceSystem::Init(Object * parent)
 {
 	Component::Init(parent);
+	SceneGraph::Instance()->registerForPicking(this);
 
+	instances.meshCenter = parent->bounds->centerOfMesh;
+	instances.meshDimensions = parent->bounds->dimensions;
 	for (size_t i = 0; i < MaxCount; i++)
 	{
-		Material* newMaterial = GraphicsStorage::assetRegistry.AllocAsset<Material>();
-		newMaterial->name = "instSysMat";
-		*newMaterial = mat;
-		objectContainer[i].AssignMaterial(newMaterial);
-		objectContainer[i].node->SetScale(SceneGraph::Instance()->generateRandomIntervallVectorSpherical(5, 15));
-		objectContainer[i].DrawAlways();
-		objectContainer[i].node->SetPosition(SceneGraph::Instance()->generateRandomIntervallVectorSpherical(20, 1000));
-		objectContainer[i].bounds->SetUp(parent->bounds->centerOfMesh, parent->bounds->dimensions, parent->bounds->name);
-		objectContainer[i].node->UpdateNode(*parent->node);
-		SceneGraph::Instance()->registerForPicking(&objectContainer[i]);
+		glm::vec3 scale = SceneGraph::Instance()->generateRandomIntervallVectorSpherical(5, 15);
+		glm::vec3 position = SceneGraph::Instance()->generateRandomIntervallVectorSpherical(20, 1000);
+		glm::mat4 world;
+		Node::ComposeTransform(position, glm::mat3(glm::scale(glm::mat4(1.f), scale)), parent->node->TopDownTransform, world);
+		instances.SetWorld((unsigned int)i, world);
+		instances.drawFlags[i] = InstanceDraw | InstanceDrawAlways;
 	}
 	UpdateCPUBuffersNoCulling();
 	UpdateGPUBuffers();
@@ -189,5 +198,7 @@ void InstanceSystem::Init(Object * parent)
 
 Component* InstanceSystem::Clone()
 {
-	return new InstanceSystem(*this);
+	InstanceSystem* clone = new InstanceSystem(*this);
+	clone->view.node = &clone->viewNode;
+	return clone;
 }
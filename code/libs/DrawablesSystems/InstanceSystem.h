@@ -5,6 +5,8 @@
 #include "MinMax.h"
 #include "Vao.h"
 #include "Material.h"
+#include "Object.h"
+#include "InstanceRecords.h"
 
 class OBJ;
 class LocationLayout;
@@ -21,8 +23,17 @@ public:
 	void SetUpGPUBuffers();
 	void UpdateGPUBuffers();
 	int Draw();
-	Object* GetObject();
-	Object* GetObjectOnce();
+	//returns the index of an instance drawn until it's stopped or only on the next draw
+	int GetInstance();
+	int GetInstanceOnce();
+	void StopInstance(int index);
+	void SetInstanceTransform(int index, const glm::mat4& world);
+	void SetInstanceColor(int index, const glm::vec4& color);
+	//index of the instance with a picked id, -1 when it's not one of ours
+	int FindInstance(unsigned int id);
+	//object standing in for an instance when the editor needs one, it's shared so commit before viewing another
+	Object* GetView(int index);
+	void CommitView();
 	void UpdateCPUBuffers();
 	void UpdateCPUBuffersNoCulling();
 	void Update();
@@ -34,7 +45,8 @@ public:
 	VertexArray vao;
 	Material mat;
 
-	Object* objectContainer;
+	InstanceRecords instances;
+	unsigned int firstID;
 
 	VertexBufferDynamic* modelBuffer;
 	VertexBufferDynamic* objectIDBuffer;
@@ -44,4 +56,8 @@ public:
 	LocationLayout* color;
 	bool dirty = false;
 	bool paused = true;
+private:
+	Object view;
+	Node viewNode;
+	int viewIndex = -1;
 };
\ No newline at end of file
@@ -772,24 +772,27 @@ extern "C" {
 
 #pragma endregion
 #pragma region script
+	//these are called from lua, when the caller runs in the shared state the work waits until its call returns
 	__declspec(dllexport) void Script_LoadLuaFile(Script* self, const char * fileName)
 	{
-		self->LoadLuaFile(fileName);
+		std::string path = fileName;
+		Script::RunWhenIdle([self, path]() { self->LoadLuaFile(path.c_str()); });
 	}
 
 	__declspec(dllexport) void Script_Call(Script* self, const char * functionName)
 	{
-		self->Call(functionName);
+		std::string name = functionName;
+		Script::RunWhenIdle([self, name]() { self->Call(name.c_str()); });
 	}
 
 	__declspec(dllexport) void Script_Reload(Script* self)
 	{
-		self->Reload();
+		Script::RunWhenIdle([self]() { self->Reload(); });
 	}
 
 	__declspec(dllexport) void Script_Unload(Script* self)
 	{
-		self->Unload();
+		Script::RunWhenIdle([self]() { self->Unload(); });
 	}
 
 	__declspec(dllexport) const char* Script_GetName(Script* self)
@@ -1154,6 +1157,11 @@ extern "C" {
 	{
 		SceneGraph::Instance()->UnparentInPlace(self, newParent);
 	}
+
+	__declspec(dllexport) Object* SceneGraph_FindPickedObject(SceneGraph* self, unsigned int id)
+	{
+		return self->findPickedObject(id);
+	}
 #pragma endregion
 #pragma region object
 	__declspec(dllexport) Object* Object_new(const char* guid)
@@ -1235,6 +1243,7 @@ extern "C" {
 
 	__declspec(dllexport) void Object_RemoveComponent(Object* self, Component* newComponent)
 	{
+		SceneGraph::Instance()->unregisterComponentForPicking(newComponent);
 		self->RemoveComponent(newComponent);
 	}
 
@@ -1383,7 +1392,7 @@ extern "C" {
 	__declspec(dllexport) void* Object_Transform_Data(Object* self)
 	{
 		Node* node = self->GetComponent<Node>();
-		return node != nullptr ? &node->TopDownTransformF : nullptr;
+		return node != nullptr ? &node->TopDownTransform : nullptr;
 	}
 
 	__declspec(dllexport) Node* Object_GetNode(Object* self)
@@ -1815,6 +1824,7 @@ extern "C" {
 	__declspec(dllexport) void Material_SetUnbound(Material* self, bool unbound)
 	{
 		self->unbound = unbound;
+		Material::elementsVersion++;
 	}
 #pragma endregion
 #pragma region node
@@ -2335,6 +2345,12 @@ extern "C" {
 	__declspec(dllexport) void Bounds_SetUp(Bounds* self, const char* meshName, Vector3F& dimensions, Vector3F& center)
 	{
 		self->SetUp((glm::vec3&)center, (glm::vec3&)dimensions, meshName);
+		//static objects are never refit, the tree has to be rebuilt to see the new bounds
+		if (self->object != nullptr)
+		{
+			self->Update();
+			SceneGraph::Instance()->RebuildBoundsTree();
+		}
 	}
 
 	__declspec(dllexport) const char* Bounds_GetMeshName(Bounds* self)
@@ -2487,12 +2503,13 @@ extern "C" {
 
 	__declspec(dllexport) void ScriptsComponent_AddScript(ScriptsComponent* self, const char* pathToScript)
 	{
-		self->AddScript(pathToScript);
+		std::string path = pathToScript;
+		Script::RunWhenIdle([self, path]() { self->AddScript(path.c_str()); });
 	}
 
 	__declspec(dllexport) void ScriptsComponent_RemoveScript(ScriptsComponent* self, Script* script)
 	{
-		self->RemoveScript(script);
+		Script::RunWhenIdle([self, script]() { self->RemoveScript(script); });
 	}
 
 	__declspec(dllexport) Script** ScriptsComponent_GetScripts(ScriptsComponent* self)
@@ -2951,22 +2968,27 @@ extern "C" {
 	}
 
 	__declspec(dllexport) int OBJ_GetPositionCount(OBJ* self) {
+		GraphicsManager::LoadOBJStreams(self);
 		return self->indexed_vertices.size();
 	}
 
 	__declspec(dllexport) int OBJ_GetUVCount(OBJ* self) {
+		GraphicsManager::LoadOBJStreams(self);
 		return self->indexed_uvs.size();
 	}
 	
 	__declspec(dllexport) int OBJ_GetNormalCount(OBJ* self) {
+		GraphicsManager::LoadOBJStreams(self);
 		return self->indexed_normals.size();
 	}
 
 	__declspec(dllexport) int OBJ_GetTangentCount(OBJ* self) {
+		GraphicsManager::LoadOBJStreams(self);
 		return self->indexed_tangents.size();
 	}
 
 	__declspec(dllexport) int OBJ_GetBitangentCount(OBJ* self) {
+		GraphicsManager::LoadOBJStreams(self);
 		return self->indexed_bitangents.size();
 	}
 
@@ -2975,27 +2997,32 @@ extern "C" {
 	}
 
 	__declspec(dllexport) Vector3F* OBJ_GetPositionData(OBJ* self) {
+		GraphicsManager::LoadOBJStreams(self);
 		return (Vector3F*)self->indexed_vertices.data();
 	}
 
 	__declspec(dllexport) Vector2F* OBJ_GetUVData(OBJ* self) {
+		GraphicsManager::LoadOBJStreams(self);
 		return (Vector2F*)self->indexed_uvs.data();
 	}
 
 	__declspec(dllexport) Vector3F* OBJ_GetNormalData(OBJ* self) {
+		GraphicsManager::LoadOBJStreams(self);
 		return (Vector3F*)self->indexed_normals.data();
 	}
 
 	__declspec(dllexport) Vector3F* OBJ_GetTangentData(OBJ* self) {
+		GraphicsManager::LoadOBJStreams(self);
 		return (Vector3F*)self->indexed_tangents.data();
 	}
 
 	__declspec(dllexport) Vector3F* OBJ_GetBitangentData(OBJ* self) {
+		GraphicsManager::LoadOBJStreams(self);
 		return (Vector3F*)self->indexed_bitangents.data();
 	}
 
 	__declspec(dllexport) void* OBJ_GetIndicesData(OBJ* self) {
-
+		GraphicsManager::LoadOBJStreams(self);
 		if (self->indicesCount <= UCHAR_MAX)
 		{
 			return self->indicesUB.data();
@@ -1,10 +1,17 @@
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <climits>
+#include <cstring>
+#include <cstdint>
 #include "HalfEdgeMesh.h"
 #include "OBJ.h"
 #include "Vertex.h"
 #include "Edge.h"
 #include "Face.h"
+#include "JobSystem.h"
+
+const unsigned int HalfEdgeMesh::noPair;
 
 HalfEdgeMesh::HalfEdgeMesh()
 {
@@ -17,10 +24,156 @@ HalfEdgeMesh::~HalfEdgeMesh()
 {
 }
 
+//flat open addressing table from an integer triple to an index, used for weld cells and for open half edges
+class KeyTable
+{
+public:
+	KeyTable()
+	{
+		slots.assign(1024, 0);
+		mask = slots.size() - 1;
+	}
+
+	void Reserve(size_t count)
+	{
+		size_t size = slots.size();
+		while (size < count * 2) size *= 2;
+		if (size > slots.size()) Rehash(size);
+		keys.reserve(count);
+		values.reserve(count);
+	}
+
+	//nullptr when the key was not inserted
+	unsigned int* Find(const glm::ivec3& key)
+	{
+		for (size_t slot = Hash(key) & mask; slots[slot] != 0; slot = (slot + 1) & mask)
+		{
+			if (keys[slots[slot] - 1] == key) return &values[slots[slot] - 1];
+		}
+		return nullptr;
+	}
+
+	//the key must not be in the table yet
+	void Insert(const glm::ivec3& key, unsigned int value)
+	{
+		size_t slot = Hash(key) & mask;
+		while (slots[slot] != 0) slot = (slot + 1) & mask;
+		keys.push_back(key);
+		values.push_back(value);
+		slots[slot] = (unsigned int)keys.size();
+		//keep load factor at or below one half so probe sequences stay short
+		if (keys.size() * 2 > slots.size()) Rehash(slots.size() * 2);
+	}
+private:
+	static size_t Hash(const glm::ivec3& key)
+	{
+		uint64_t hash = (uint64_t)(uint32_t)key.x * 0x9E3779B97F4A7C15ull;
+		hash ^= (uint64_t)(uint32_t)key.y * 0xC2B2AE3D27D4EB4Full;
+		hash ^= (uint64_t)(uint32_t)key.z * 0x165667B19E3779F9ull;
+		return (size_t)(hash ^ (hash >> 29));
+	}
+
+	void Rehash(size_t size)
+	{
+		slots.assign(size, 0);
+		mask = slots.size() - 1;
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			size_t slot = Hash(keys[i]) & mask;
+			while (slots[slot] != 0) slot = (slot + 1) & mask;
+			slots[slot] = (unsigned int)i + 1;
+		}
+	}
+
+	std::vector<unsigned int> slots; //entry index + 1, 0 is an empty slot
+	std::vector<glm::ivec3> keys;
+	std::vector<unsigned int> values;
+	size_t mask;
+};
+
+//gives positions closer than the tolerance the same weld index through a uniform grid of tolerance sized cells
+//with no tolerance the cell is the position's bit pattern so only exactly equal positions weld
+class PositionWelder
+{
+public:
+	PositionWelder(float tolerance, size_t count) : tolerance(tolerance)
+	{
+		cells.Reserve(count);
+		positions.reserve(count);
+		nextInCell.reserve(count);
+	}
+
+	unsigned int Weld(const glm::vec3& pos)
+	{
+		glm::ivec3 cell = GetCell(pos);
+		if (tolerance <= 0.f)
+		{
+			unsigned int* found = cells.Find(cell);
+			if (found != nullptr) return *found;
+			cells.Insert(cell, (unsigned int)positions.size());
+			positions.push_back(pos);
+			return (unsigned int)positions.size() - 1;
+		}
+		//a position within tolerance can only be in the same or a neighbouring cell
+		float toleranceSquared = tolerance * tolerance;
+		for (int z = -1; z <= 1; z++)
+		{
+			for (int y = -1; y <= 1; y++)
+			{
+				for (int x = -1; x <= 1; x++)
+				{
+					unsigned int* head = cells.Find(cell + glm::ivec3(x, y, z));
+					for (unsigned int i = head != nullptr ? *head : noWeld; i != noWeld; i = nextInCell[i])
+					{
+						glm::vec3 offset = positions[i] - pos;
+						if (glm::dot(offset, offset) <= toleranceSquared) return i;
+					}
+				}
+			}
+		}
+		unsigned int index = (unsigned int)positions.size();
+		positions.push_back(pos);
+		unsigned int* head = cells.Find(cell);
+		if (head != nullptr)
+		{
+			nextInCell.push_back(*head);
+			*head = index;
+		}
+		else
+		{
+			nextInCell.push_back(noWeld);
+			cells.Insert(cell, index);
+		}
+		return index;
+	}
+private:
+	static const unsigned int noWeld = 0xFFFFFFFF;
+
+	glm::ivec3 GetCell(const glm::vec3& pos) const
+	{
+		if (tolerance <= 0.f)
+		{
+			//adding zero turns -0 into 0 so both weld
+			glm::vec3 normalized = pos + glm::vec3(0.f);
+			glm::ivec3 bits;
+			memcpy(&bits, &normalized, sizeof(bits));
+			return bits;
+		}
+		return glm::ivec3(glm::floor(pos / tolerance));
+	}
+
+	float tolerance;
+	KeyTable cells;
+	std::vector<glm::vec3> positions;
+	std::vector<unsigned int> nextInCell;
+};
+
 template <typename Container>
-void CreateConnections(const Container& container, HalfEdgeMesh* mesh) {
+void CreateConnections(const Container& container, HalfEdgeMesh* mesh, std::vector<unsigned int>& edgeStarts) {
+	edgeStarts.reserve(container.size());
+	mesh->edges.reserve(container.size());
 	// Loop through the elements in the container
-	for (size_t i = 0; i < container.size(); i += 3)
+	for (size_t i = 0; i + 2 < container.size(); i += 3)
 	{
 		//get vertex index from element array containing indices
 		int vertexIndex = container.at(i);
@@ -55,14 +208,18 @@ void CreateConnections(const Container& container, HalfEdgeMesh* mesh) {
 		mesh->edges.push_back(newEdge1);
 		mesh->edges.push_back(newEdge2);
 		mesh->edges.push_back(newEdge3);
+		edgeStarts.push_back(vertexIndex);
+		edgeStarts.push_back(vertexIndex2);
+		edgeStarts.push_back(vertexIndex3);
 	}
 }
 
-void HalfEdgeMesh::Construct(OBJ &object)
+void HalfEdgeMesh::Construct(OBJ &object, float weldTolerance)
 {
 
 	//copy all data from vectors to half edge mesh vectors
 	//vertice data
+	vertices.reserve(object.indexed_vertices.size());
 	for (size_t i = 0; i < object.indexed_vertices.size(); i++)
 	{
 		Vertex* newVertex = vertexPool.Alloc();
@@ -73,29 +230,27 @@ void HalfEdgeMesh::Construct(OBJ &object)
 	}
 
 	//connecting
+	std::vector<unsigned int> edgeStarts;
 	if (object.indices.size() > 0)
 	{
-		CreateConnections(object.indices, this);
+		CreateConnections(object.indices, this, edgeStarts);
 	}
 	else if (object.indicesUB.size() > 0)
 	{
-		CreateConnections(object.indicesUB, this);
+		CreateConnections(object.indicesUB, this, edgeStarts);
 	}
 	else if (object.indicesUS.size() > 0)
 	{
-		CreateConnections(object.indicesUS, this);
+		CreateConnections(object.indicesUS, this, edgeStarts);
 	}
 
 	//connect edges to faces and faces to edges
+	faces.reserve(edges.size() / 3);
 	for (int i = 0; i < edges.size(); i+=3)
 	{
 		Face* newFace = facePool.Alloc();
 		newFace->edge = edges.at(i);
 
-		//edges.at(i).face = &faces.at(i);
-		//edges.at(i+1).face = &faces.at(i);
-		//edges.at(i+2).face = &faces.at(i);
-
 		edges.at(i)->face = newFace;
 		edges.at(i)->next->face = newFace;
 		edges.at(i)->next->next->face = newFace;
@@ -103,32 +258,51 @@ void HalfEdgeMesh::Construct(OBJ &object)
 		faces.push_back(newFace);
 	}
 
-	//find pairs
-	for (auto edgei : edges)
-	{	
-		for (auto edgej : edges)
-		{
-			if (edgej->vertex->pos == edgei->next->vertex->pos) //we could just compare pointers but we have double vertices, not per triangle but per quad
-			{
-				if (edgej->next->vertex->pos == edgei->vertex->pos)
-				{
-					edgei->pair = edgej;
-					edgej->pair = edgei;
-					break;
-				}
-			}
-		}
+	//we have double vertices, not per triangle but per quad, so vertices are paired on their welded position and not their pointer
+	PositionWelder welder(weldTolerance, vertices.size());
+	std::vector<unsigned int> welded(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		welded[i] = welder.Weld(vertices[i]->pos);
 	}
 
-	/*
-	for (int i = 0; i < edges.size(); i++)
+	//find pairs, every half edge looks for an unpaired twin running the other way and otherwise waits for one
+	KeyTable openEdges;
+	openEdges.Reserve(edges.size());
+	edgePairs.assign(edges.size(), noPair);
+	for (size_t i = 0; i < edges.size(); i++)
 	{
-		if (edges.at(i)->next == edges.at(i)->pair)
+		size_t nextInFace = i % 3 == 2 ? i - 2 : i + 1;
+		int start = (int)welded[edgeStarts[i]];
+		int end = (int)welded[edgeStarts[nextInFace]];
+		//an edge collapsed by the weld has no twin
+		if (start == end) continue;
+		unsigned int* twin = openEdges.Find(glm::ivec3(end, start, 0));
+		if (twin != nullptr && edges[*twin]->pair == nullptr)
 		{
-			printf("error %d \n", i);
+			edges[i]->pair = edges[*twin];
+			edges[*twin]->pair = edges[i];
+			edgePairs[i] = *twin;
+			edgePairs[*twin] = (unsigned int)i;
 		}
+		//a third face on the same edge is non manifold and stays a boundary
+		else if (openEdges.Find(glm::ivec3(start, end, 0)) == nullptr)
+		{
+			openEdges.Insert(glm::ivec3(start, end, 0), (unsigned int)i);
+		}
+	}
+
+	edgeVertices.swap(edgeStarts);
+
+	boundaryEdges.clear();
+	for (auto edge : edges)
+	{
+		if (edge->pair == nullptr) boundaryEdges.push_back(edge);
+	}
+	if (!boundaryEdges.empty())
+	{
+		printf("\nHalf edge mesh has %d boundary edges\n", (int)boundaryEdges.size());
 	}
-	*/
 }
 
 bool HalfEdgeMesh::checkIfSameVect(Vector3 &vect1, Vector3 &vect2)
@@ -141,86 +315,173 @@ bool HalfEdgeMesh::checkIfSameVect(Vector3 &vect1, Vector3 &vect2)
 	}
 }
 
-void HalfEdgeMesh::Subdivide()
+void HalfEdgeMesh::Subdivide(int levels)
 {
-	CalculateOldPosition();
-	CalculateMidpointPosition();
-	SplitHalfEdges();
-	UpdateConnections();
-	UpdateVertexPositions();
+	//the scheme walks every vertex ring through pairs so it needs a closed mesh
+	if (!boundaryEdges.empty())
+	{
+		printf("\nCan't subdivide a half edge mesh with %d boundary edges\n", (int)boundaryEdges.size());
+		return;
+	}
+	for (int level = 0; level < levels; level++)
+	{
+		UpdateIndices();
+		unsigned int oldVertexCount = (unsigned int)vertices.size();
+		CalculateOldPosition(oldVertexCount);
+		AllocateNextLevel();
+		CalculateMidpointPosition();
+		UpdateConnections();
+		UpdateVertexPositions();
+		//the next level replaces this one
+		edges.swap(nextEdges);
+		faces.swap(nextFaces);
+		edgePairs.swap(nextEdgePairs);
+		edgeVertices.swap(nextEdgeVertices);
+	}
 	//we could do the new recalculation of normals 
 	//for each vertex we find all neighbours
 	//then we calculate new normals from them
 	//traversing code is already existent in CalculateOldPosition function
 }
 
-
-void HalfEdgeMesh::CalculateOldPosition()
+void HalfEdgeMesh::UpdateIndices()
 {
-	for (int i = 0; i < edges.size(); i++)
+	if (edgePairs.size() == edges.size() && edgeVertices.size() == edges.size()) return;
+
+	//the vectors were edited from outside, lay the half edges out by face again and index them through their pointers
+	std::unordered_map<const Vertex*, unsigned int> vertexIndices;
+	vertexIndices.reserve(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		vertexIndices[vertices[i]] = (unsigned int)i;
+	}
+	edges.clear();
+	for (auto face : faces)
 	{
-		if (edges[i]->next == edges[i]->pair)
+		Edge* faceTraverser = face->edge;
+		do
 		{
-			printf("\nFEL\n");
-		}
+			edges.push_back(faceTraverser);
+			faceTraverser = faceTraverser->next;
+		} while (faceTraverser != face->edge);
+	}
+	std::unordered_map<const Edge*, unsigned int> edgeIndices;
+	edgeIndices.reserve(edges.size());
+	for (size_t i = 0; i < edges.size(); i++)
+	{
+		edgeIndices[edges[i]] = (unsigned int)i;
 	}
+	edgePairs.resize(edges.size());
+	edgeVertices.resize(edges.size());
+	for (size_t i = 0; i < edges.size(); i++)
+	{
+		edgePairs[i] = edges[i]->pair != nullptr ? edgeIndices[edges[i]->pair] : noPair;
+		edgeVertices[i] = vertexIndices[edges[i]->vertex];
+	}
+}
 
-	for (int i = 0; i < vertices.size(); i++){
-		//Get the vertex to which we will calculate its new position
-		Vertex* vertex = vertices.at(i);
-		//Get the half-edge of the vertex we are working on
-		Edge* halfedge = vertices.at(i)->edge;
+void HalfEdgeMesh::CalculateOldPosition(unsigned int vertexCount)
+{
+	JobSystem::Instance()->ParallelFor(vertexCount, 4096, [this](size_t begin, size_t end, unsigned int /*thread*/)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			//Get the vertex to which we will calculate its new position
+			Vertex* vertex = vertices[i];
+			//Get the half-edge of the vertex we are working on
+			Edge* halfedge = vertex->edge;
+
+			//Sum of all neighbour vertices
+			glm::vec3 neighbourSum(0);
+			//Amount of neighbors around the vertex
+			float n = 0;
+
+			//we find here all neighboring vertices of current vertex of current edge, we can use this traversing for better calculation of normals after subdivision 
+			//starting edge, its vertex
+			Edge* currentEdge = halfedge->next;
+			//traverse around vertice sum neighboring vertices
+			do
+			{
+				neighbourSum = neighbourSum + currentEdge->vertex->pos;
+				n++;
 
-		//Sum of all neighbour vertices
-		glm::vec3 neighbourSum(0);
-		//Amount of neighbors around the vertex
-		float n = 0;
+				//get next neighbour
+				currentEdge = currentEdge->next->pair->next;
+			} while (currentEdge != halfedge->next);
 
-		//we find here all neighboring vertices of current vertex of current edge, we can use this traversing for better calculation of normals after subdivision 
-		//starting edge, its vertex
-		Edge* currentEdge = halfedge->next;
-		//traverse around vertice sum neighboring vertices
-		do
-		{
-			neighbourSum = neighbourSum + currentEdge->vertex->pos;
-			n++;
+			//Calculate b which is a function used by the equation which calculates the new position
+			//Using  Warren and Weimer's equation which doesnt have expensive trigonometric functions
+			float b = 3.0f / (n*(n + 2.0f));
 
-			//get next neighbour
-			currentEdge = currentEdge->next->pair->next;
-		} while (currentEdge != halfedge->next);
+			vertex->newPos = (1.0f - n*b)*vertex->pos + b*neighbourSum;
+		}
+	});
+}
 
-		//Calculate b which is a function used by the equation which calculates the new position
-		//Using  Warren and Weimer's equation which doesnt have expensive trigonometric functions
-		float b = 3.0f / (n*(n + 2.0f));
+void HalfEdgeMesh::AllocateNextLevel()
+{
+	//the next level has a midpoint per edge, 4 faces per face and 12 half edges per face
+	//the old faces and half edges are reused so only the difference is allocated, with the pools reserved up front
+	size_t edgeCount = edges.size();
+	size_t faceCount = faces.size();
+	vertexPool.Reserve(vertexPool.GetCount() + (int)edgeCount / 2);
+	edgePool.Reserve(edgePool.GetCount() + (int)faceCount * 9);
+	facePool.Reserve(facePool.GetCount() + (int)faceCount * 3);
+
+	//the half edge with the lower index of a pair owns the midpoint both share
+	edgeMids.resize(edgeCount);
+	vertices.reserve(vertices.size() + edgeCount / 2);
+	for (size_t i = 0; i < edgeCount; i++)
+	{
+		if (i < edgePairs[i])
+		{
+			edgeMids[i] = (unsigned int)vertices.size();
+			edgeMids[edgePairs[i]] = (unsigned int)vertices.size();
+			vertices.push_back(vertexPool.Alloc());
+		}
+	}
 
-		vertex->newPos = (1.0f - n*b)*vertex->pos + b*neighbourSum;
+	//child c of face f is face 4f + c and its half edges are 12f + 3c + k, the old half edge k becomes the first half edge of child k
+	nextEdges.resize(faceCount * 12);
+	nextFaces.resize(faceCount * 4);
+	nextEdgePairs.resize(faceCount * 12);
+	nextEdgeVertices.resize(faceCount * 12);
+	for (size_t f = 0; f < faceCount; f++)
+	{
+		Edge** childEdges = &nextEdges[f * 12];
+		for (int c = 0; c < 4; c++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				childEdges[c * 3 + k] = c < 3 && k == 0 ? edges[f * 3 + c] : edgePool.Alloc();
+			}
+		}
+		nextFaces[f * 4] = faces[f];
+		nextFaces[f * 4 + 1] = facePool.Alloc();
+		nextFaces[f * 4 + 2] = facePool.Alloc();
+		nextFaces[f * 4 + 3] = facePool.Alloc();
 	}
 }
 
 void HalfEdgeMesh::CalculateMidpointPosition()
 {
-	/*
-	Iterate edges calculate the midpoint vertex
-	*/
-
-	/*Iterate HE around face . do while until same HE then pair.next.next.origin. after do while jaha. then got all 4 vertices*/
-	unsigned int halfEdgeListSize = edges.size();
-	for (unsigned int i = 0; i < halfEdgeListSize; i++){
-		//Get the halfedge to which we will calculate midpoint position of the new vertex
-		Edge* halfedge = edges.at(i);
-
-		if (halfedge->midVertex == nullptr){
-			//to calculate midpoint position i need first all involved vertices
-			Vertex* v1 = halfedge->vertex;
-			Vertex* v2 = halfedge->next->vertex;
-			Vertex* v3 = halfedge->next->next->vertex;
-			Vertex* v4 = halfedge->pair->next->next->vertex;
+	JobSystem::Instance()->ParallelFor(edges.size(), 4096, [this](size_t begin, size_t end, unsigned int /*thread*/)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			unsigned int pair = edgePairs[i];
+			if (i > pair) continue;
+			//to calculate midpoint position i need first all involved vertices, the two on the edge and the opposite ones of both faces
+			size_t face = i - i % 3;
+			size_t pairFace = pair - pair % 3;
+			Vertex* v1 = vertices[edgeVertices[i]];
+			Vertex* v2 = vertices[edgeVertices[face + (i + 1) % 3]];
+			Vertex* v3 = vertices[edgeVertices[face + (i + 2) % 3]];
+			Vertex* v4 = vertices[edgeVertices[pairFace + (pair + 2) % 3]];
 
 			glm::vec3 vertexPosSum = 3.f * (v1->pos + v2->pos) + v3->pos + v4->pos;
 
-			//we only calculate midpoint and assign it to the edge and it's pair
-			//we are not performing any splitting or reconnections here
-			Vertex* midpoint = vertexPool.Alloc();
+			Vertex* midpoint = vertices[edgeMids[i]];
 			glm::vec3 calculatedPosition = vertexPosSum / 8.0f;
 			glm::vec2 calculatedUVs = (v1->tex + v2->tex) / 2.0f;
 			glm::vec3 calculatedNormal = (v1->normal + v2->normal + v3->normal + v4->normal) / 4.0f;
@@ -228,150 +489,82 @@ void HalfEdgeMesh::CalculateMidpointPosition()
 			midpoint->tex = calculatedUVs;
 			midpoint->normal = glm::normalize(calculatedNormal);
 			midpoint->newPos = calculatedPosition;
-			halfedge->midVertex = midpoint;
-			halfedge->pair->midVertex = midpoint;
-
-
-			vertices.push_back(midpoint);
 		}
-	}
-}
-
-void HalfEdgeMesh::SplitHalfEdges()
-{
-	//here we want to split edges and connect pairs
-	unsigned int hEdgesSize = edges.size();
-	//iterate trought edge list and split edge if not splitted 
-	for (unsigned int i = 0; i < hEdgesSize; i++){
-		//Create new half-edge
-		Edge* newHEdge = edgePool.Alloc();
-		newHEdge->vertex = edges.at(i)->midVertex;
-		newHEdge->vertex->edge = newHEdge;
-		newHEdge->next = edges.at(i)->next;
-		newHEdge->face = edges.at(i)->face;
-
-		edges.at(i)->next = newHEdge;
-		newHEdge->pair = edges.at(i)->pair;
-
-		edges.push_back(newHEdge);
-	}
-
-	for (int i = hEdgesSize; i < edges.size(); i++){
-		edges.at(i)->pair->pair = edges.at(i);
-	}
+	});
 }
 
 void HalfEdgeMesh::UpdateVertexPositions()
 {
 	//we copy new positions into original positions
-	for (int i = 0; i < vertices.size(); i++){
-		vertices.at(i)->pos = vertices.at(i)->newPos;
-	}
+	JobSystem::Instance()->ParallelFor(vertices.size(), 4096, [this](size_t begin, size_t end, unsigned int /*thread*/)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			vertices[i]->pos = vertices[i]->newPos;
+		}
+	});
 }
 
 void HalfEdgeMesh::UpdateConnections()
 {
-	unsigned int faceListSize = faces.size();
-	for (unsigned int i = 0; i < faceListSize; i++){
-		Face* leftFace = faces.at(i);
-		Face* topFace = facePool.Alloc();
-		Face* rightFace = facePool.Alloc();
-		Face* middleFace = facePool.Alloc();
-
-		Edge* innerLeftEdge = edgePool.Alloc();
-		Edge* innerTopEdge = edgePool.Alloc();
-		Edge* innerRightEdge = edgePool.Alloc();
-
-		//New triangle, middle
-		Edge* innerRightMidEdge = edgePool.Alloc();
-		Edge* innerLeftMidEdge = edgePool.Alloc();
-		Edge* innerBottomMidEdge = edgePool.Alloc();
-
-		Edge* oldLeftEdge = faces.at(i)->edge;
-		Edge* newLeftEdge = faces.at(i)->edge->next;
-		Edge* oldRightEdge = faces.at(i)->edge->next->next;
-		Edge* newRightEdge = faces.at(i)->edge->next->next->next;
-		Edge* oldBottomEdge = faces.at(i)->edge->next->next->next->next;
-		Edge* newBottomEdge = faces.at(i)->edge->next->next->next->next->next;
-
-
-
-		//Connectivity for inner edges
-		//Bottom left face
-		innerLeftEdge->vertex = newLeftEdge->vertex;  
-
-		//connectivity
-		innerLeftEdge->next = newBottomEdge;
-		oldLeftEdge->next = innerLeftEdge;
-
-		innerLeftEdge->face = leftFace; 
-
-		//fixing pair for the inner middle face
-		innerLeftEdge->pair = innerLeftMidEdge;
-		innerLeftMidEdge->pair = innerLeftEdge; 
-
-		//Top face
-		topFace->edge = newLeftEdge; 
-		innerTopEdge->vertex = newRightEdge->vertex; 
-
-		//connectivity
-		innerTopEdge->next = newLeftEdge; 
-		oldRightEdge->next = innerTopEdge; 
-
-		//setting all edges to the new top face
-		newLeftEdge->face = topFace;
-		oldRightEdge->face = topFace;
-		innerTopEdge->face = topFace; 
-
-		//fixing pair for the inner middle face
-		innerTopEdge->pair = innerBottomMidEdge;
-		innerBottomMidEdge->pair = innerTopEdge; 
-
-		//Bottom right face
-		rightFace->edge = newRightEdge;
-		innerRightEdge->vertex = newBottomEdge->vertex; 
-
-		innerRightEdge->next = newRightEdge; 
-		oldBottomEdge->next = innerRightEdge; 
-
-		//setting all edges to the new right face
-		newRightEdge->face = rightFace;
-		oldBottomEdge->face = rightFace;
-		innerRightEdge->face = rightFace; 
-
-		//fixing pair for the inner middle face
-		innerRightEdge->pair = innerRightMidEdge;
-		innerRightMidEdge->pair = innerRightEdge; 
-
-		//Middle face
-		middleFace->edge = innerRightMidEdge; 
-		innerRightMidEdge->vertex = newRightEdge->vertex; 
-		innerRightMidEdge->next = innerLeftMidEdge; 
-
-		innerLeftMidEdge->vertex = newBottomEdge->vertex;
-		innerLeftMidEdge->next = innerBottomMidEdge; 
-
-		innerBottomMidEdge->vertex = newLeftEdge->vertex;  
-		innerBottomMidEdge->next = innerRightMidEdge; 
-
-		//setting all edges to the new middle face
-		innerRightMidEdge->face = middleFace;
-		innerLeftMidEdge->face = middleFace;
-		innerBottomMidEdge->face = middleFace;
-
-		//pushing new faces
-		faces.push_back(topFace);
-		faces.push_back(rightFace);
-		faces.push_back(middleFace);
-
-		//pushing new edges
-		edges.push_back(innerLeftEdge);
-		edges.push_back(innerTopEdge);
-		edges.push_back(innerRightEdge);
-		edges.push_back(innerRightMidEdge);
-		edges.push_back(innerLeftMidEdge);
-		edges.push_back(innerBottomMidEdge);
-	}
+	//every face only writes its own children, everything it needs from its neighbours comes from the index arrays
+	JobSystem::Instance()->ParallelFor(faces.size(), 1024, [this](size_t begin, size_t end, unsigned int /*thread*/)
+	{
+		for (size_t f = begin; f < end; f++)
+		{
+			unsigned int corners[3], mids[3], pairs[3];
+			for (int k = 0; k < 3; k++)
+			{
+				corners[k] = edgeVertices[f * 3 + k];
+				mids[k] = edgeMids[f * 3 + k];
+				pairs[k] = edgePairs[f * 3 + k];
+			}
+			unsigned int base = (unsigned int)f * 12;
+			unsigned int* childPairs = &nextEdgePairs[base];
+			unsigned int* childVertices = &nextEdgeVertices[base];
+			for (int c = 0; c < 3; c++)
+			{
+				//corner child c runs corner c, midpoint of edge c, midpoint of the edge before it
+				int previous = (c + 2) % 3;
+				childVertices[c * 3] = corners[c];
+				childVertices[c * 3 + 1] = mids[c];
+				childVertices[c * 3 + 2] = mids[previous];
+				//first half of edge c pairs with the second half of its twin, which is the last half edge of the child after the twin's
+				childPairs[c * 3] = pairs[c] / 3 * 12 + (pairs[c] % 3 + 1) % 3 * 3 + 2;
+				//the inner half edge pairs with the middle child
+				childPairs[c * 3 + 1] = base + 9 + previous;
+				//second half of the edge before pairs with the first half of its twin
+				childPairs[c * 3 + 2] = pairs[previous] / 3 * 12 + pairs[previous] % 3 * 3;
+			}
+			//middle child runs through the three midpoints
+			for (int k = 0; k < 3; k++)
+			{
+				childVertices[9 + k] = mids[k];
+				childPairs[9 + k] = base + (k + 1) % 3 * 3 + 1;
+			}
+
+			for (int c = 0; c < 4; c++)
+			{
+				Face* child = nextFaces[f * 4 + c];
+				child->edge = nextEdges[base + c * 3];
+				for (int k = 0; k < 3; k++)
+				{
+					Edge* edge = nextEdges[base + c * 3 + k];
+					edge->vertex = vertices[childVertices[c * 3 + k]];
+					edge->next = nextEdges[base + c * 3 + (k + 1) % 3];
+					edge->pair = nextEdges[childPairs[c * 3 + k]];
+					edge->face = child;
+					edge->midVertex = nullptr;
+				}
+			}
+			//midpoints leave along the inner half edge of the child at the start of their edge, written by the owner only
+			//corners keep their old half edge which now ends at the midpoint
+			for (int k = 0; k < 3; k++)
+			{
+				if (f * 3 + k < pairs[k]) vertices[mids[k]]->edge = nextEdges[base + k * 3 + 1];
+			}
+		}
+	});
 }
 
 
@@ -379,33 +572,39 @@ void HalfEdgeMesh::ExportMeshToOBJ(HalfEdgeMesh* mesh, OBJ* newOBJ)
 {
 
 	//GENERATING RENDERABLE DATA FORMAT 
-
-	//let's use map for vertex pointer and index 
-	std::map<const Vertex*, int> indexMap;
+	mesh->UpdateIndices();
 
 	//for each vertice export position normal and uv
-	for (int i = 0; i < mesh->vertices.size(); i++)
+	size_t vertexCount = mesh->vertices.size();
+	newOBJ->indexed_vertices.resize(vertexCount);
+	newOBJ->indexed_uvs.resize(vertexCount);
+	newOBJ->indexed_normals.resize(vertexCount);
+	JobSystem::Instance()->ParallelFor(vertexCount, 4096, [mesh, newOBJ](size_t begin, size_t end, unsigned int /*thread*/)
 	{
-		newOBJ->indexed_vertices.push_back(mesh->vertices.at(i)->pos);
-		newOBJ->indexed_uvs.push_back(mesh->vertices.at(i)->tex);
-		newOBJ->indexed_normals.push_back(mesh->vertices.at(i)->normal);
-		indexMap[mesh->vertices.at(i)] = i;
-	}
-
-	for (int i = 0; i < mesh->faces.size(); i++){
-		Edge* faceTraverser = mesh->faces.at(i)->edge;
-		do
+		for (size_t i = begin; i < end; i++)
 		{
-			int index;
-			//Iterator
-			//we search for the same vertex in vertex index map
-			std::map<const Vertex*, int>::iterator it = indexMap.find(faceTraverser->vertex);
-			index = it->second;
-			//then we push back it's index
-			newOBJ->indices.push_back(index);
+			const Vertex* vertex = mesh->vertices[i];
+			newOBJ->indexed_vertices[i] = vertex->pos;
+			newOBJ->indexed_uvs[i] = vertex->tex;
+			newOBJ->indexed_normals[i] = vertex->normal;
+		}
+	});
 
-			faceTraverser = faceTraverser->next;
-		} while (faceTraverser != mesh->faces.at(i)->edge);
+	//half edges are laid out by face so their start vertices are the triangle indices, written straight in the type ProcessIndicesType would pick
+	const std::vector<unsigned int>& indices = mesh->edgeVertices;
+	newOBJ->indicesCount = (unsigned int)indices.size();
+	if (indices.size() <= UCHAR_MAX)
+	{
+		newOBJ->indicesUB.assign(indices.begin(), indices.end());
+		newOBJ->indices = std::vector<unsigned int>();
 	}
-	newOBJ->ProcessIndicesType();
-}
\ No newline at end of file
+	else if (indices.size() <= USHRT_MAX)
+	{
+		newOBJ->indicesUS.assign(indices.begin(), indices.end());
+		newOBJ->indices = std::vector<unsigned int>();
+	}
+	else
+	{
+		newOBJ->indices = indices;
+	}
+}
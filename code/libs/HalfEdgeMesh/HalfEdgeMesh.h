@@ -12,8 +12,10 @@ class HalfEdgeMesh
 public:
 	HalfEdgeMesh();
 	~HalfEdgeMesh();
-	void Construct(OBJ &object);
-	void Subdivide();
+	//pairs twins through a hash of welded vertex index pairs, positions closer than weldTolerance count as the same vertex
+	void Construct(OBJ &object, float weldTolerance = 0.f);
+	//applies levels of loop subdivision, each level splits every triangle in four
+	void Subdivide(int levels = 1);
 	static void ExportMeshToOBJ(HalfEdgeMesh* mesh, OBJ* newOBJ);
 
 	PoolParty<Vertex,1000> vertexPool;
@@ -22,12 +24,29 @@ public:
 	std::vector<Vertex*> vertices;
 	std::vector<Edge*> edges;
 	std::vector<Face*> faces;
+	//half edges left without a twin by the last Construct
+	std::vector<Edge*> boundaryEdges;
 private:
+	static const unsigned int noPair = 0xFFFFFFFF;
+
 	bool checkIfSameVect(Vector3 &vect1, Vector3 &vect2);
-	void SplitHalfEdges();
-	void CalculateOldPosition();
+	//rebuilds the index arrays from the pointers when the vectors were changed from outside
+	void UpdateIndices();
+	void CalculateOldPosition(unsigned int vertexCount);
+	void AllocateNextLevel();
 	void CalculateMidpointPosition();
 	void UpdateVertexPositions();
 	void UpdateConnections();
+
+	//half edges of face f are 3f, 3f + 1 and 3f + 2, these hold the index of each one's twin and start vertex
+	std::vector<unsigned int> edgePairs;
+	std::vector<unsigned int> edgeVertices;
+	//vertex index of each half edge's midpoint while a level is subdivided
+	std::vector<unsigned int> edgeMids;
+	//the level being built, swapped in when it is done
+	std::vector<Edge*> nextEdges;
+	std::vector<Face*> nextFaces;
+	std::vector<unsigned int> nextEdgePairs;
+	std::vector<unsigned int> nextEdgeVertices;
 };
 
@@ -17,6 +17,11 @@ PointLight::~PointLight()
 {
 }
 
+bool PointLight::IsThreadSafe()
+{
+	return true;
+}
+
 void PointLight::Update()
 {
 	if (CanCastShadow())
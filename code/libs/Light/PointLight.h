@@ -16,6 +16,7 @@ public:
 	PointLight();
 	~PointLight();
 	void Update();
+	bool IsThreadSafe();
 	Component* Clone();
 	glm::mat4 ProjectionMatrix; //used when drawing depth
 	float ProjectionSize = 150.f;
@@ -25,6 +25,11 @@ SpotLight::~SpotLight()
 {
 }
 
+bool SpotLight::IsThreadSafe()
+{
+	return true;
+}
+
 void SpotLight::Update()
 {
 	glm::mat3 rotationMatrix = object->node->GetWorldRotation3();
@@ -16,6 +16,7 @@ public:
 	SpotLight();
 	~SpotLight();
 	void Update();
+	bool IsThreadSafe();
 	void Init(Object* parent);
 	glm::mat4 ProjectionMatrix; //used when drawing depth
 	glm::vec3 LightInvDir; //used when drawing light 
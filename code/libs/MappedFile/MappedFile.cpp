@@ -0,0 +1,100 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	data = nullptr;
+	size = 0;
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = nullptr;
+#else
+	fileDescriptor = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+#ifdef _WIN32
+	fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		Close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+	//empty files can't be mapped, they are open with no data
+	if (size == 0) return true;
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr)
+	{
+		Close();
+		return false;
+	}
+	data = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+	fileDescriptor = open(path, O_RDONLY);
+	if (fileDescriptor == -1) return false;
+	struct stat fileInfo;
+	if (fstat(fileDescriptor, &fileInfo) != 0)
+	{
+		Close();
+		return false;
+	}
+	size = (size_t)fileInfo.st_size;
+	if (size == 0) return true;
+	void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	data = mapped == MAP_FAILED ? nullptr : (const char*)mapped;
+	if (data != nullptr) madvise(mapped, size, MADV_SEQUENTIAL);
+#endif
+	if (data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (data != nullptr) UnmapViewOfFile(data);
+	if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = nullptr;
+#else
+	if (data != nullptr) munmap((void*)data, size);
+	if (fileDescriptor != -1) close(fileDescriptor);
+	fileDescriptor = -1;
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+const char* MappedFile::GetData() const
+{
+	return data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return size;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+
+//read only view of a whole file mapped into memory, unmapped when closed or destroyed
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	bool Open(const char* path);
+	void Close();
+	const char* GetData() const;
+	size_t GetSize() const;
+private:
+	//copy
+	MappedFile(const MappedFile&);
+	//assign
+	MappedFile& operator=(const MappedFile&);
+
+	const char* data;
+	size_t size;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+};
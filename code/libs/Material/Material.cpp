@@ -9,6 +9,8 @@
 #include "FrameBuffer.h"
 #include "Texture.h"
 
+unsigned int Material::elementsVersion = 0;
+
 Material::Material()
 {
 	rps = nullptr;
@@ -57,6 +59,7 @@ void Material::AssignElement(RenderElement* ele, MaterialElements type)
 void Material::AssignShader(Shader * ns)
 {
 	Shader* previousShader = shader;
+	elementsVersion++;
 	shader = ns;
 
 	if (shader != nullptr)
@@ -82,16 +85,19 @@ void Material::AssignShader(Shader * ns)
 void Material::AssignRenderProfile(RenderProfile * nrp)
 {
 	rp = nrp;
+	elementsVersion++;
 }
 
 void Material::AssignTextureProfile(TextureProfile * ntp)
 {
 	tp = ntp;
+	elementsVersion++;
 }
 
 void Material::AssignMaterialProfile(MaterialProfile * nmp)
 {
 	mp = nmp;
+	elementsVersion++;
 	if (shader != nullptr)
 	{
 		if (mp != nullptr)
@@ -105,6 +111,7 @@ void Material::AssignMaterialProfile(MaterialProfile * nmp)
 void Material::AssignMesh(VertexArray* nm)
 {
 	vao = nm;
+	elementsVersion++;
 	if (vao != nullptr)
 	{
 		if (op != nullptr)
@@ -118,6 +125,7 @@ void Material::AssignMesh(VertexArray* nm)
 void Material::AssignObjectProfile(ObjectProfile * nop)
 {
 	op = nop;
+	elementsVersion++;
 	if (op != nullptr)
 	{
 		if (shader != nullptr)
@@ -136,6 +144,7 @@ void Material::AssignObjectProfile(ObjectProfile * nop)
 void Material::AssignRenderPass(RenderPass * nrps)
 {
 	rps = nrps;
+	elementsVersion++;
 	if (shader != nullptr)
 	{
 		if (rps != nullptr)
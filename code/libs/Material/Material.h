@@ -45,6 +45,8 @@ public:
 		};
 	};
 	bool unbound = false;
+	//bumped whenever an element of any material is reassigned, lets the renderer keep its render list between frames
+	static unsigned int elementsVersion;
 	std::string name;
 	std::string path;
 	void AssignElement(RenderElement* ele, MaterialElements type);
@@ -0,0 +1,216 @@
+#define _CRT_SECURE_NO_DEPRECATE
+#include "MeshCache.h"
+#include "OBJ.h"
+#include <cstring>
+#include <cstdio>
+#include <climits>
+#include <filesystem>
+
+static const char meshCacheMagic[4] = { 'M', 'S', 'H', 'C' };
+
+static uint64_t AlignOffset(uint64_t offset)
+{
+	return (offset + 15) & ~(uint64_t)15;
+}
+
+MeshCache::MeshCache()
+{
+	header = nullptr;
+}
+
+MeshCache::~MeshCache()
+{
+}
+
+bool MeshCache::Open(const char* cachePath)
+{
+	Close();
+	if (!file.Open(cachePath)) return false;
+	if (file.GetSize() < sizeof(MeshCacheHeader))
+	{
+		Close();
+		return false;
+	}
+	const MeshCacheHeader* candidate = (const MeshCacheHeader*)file.GetData();
+	if (memcmp(candidate->magic, meshCacheMagic, sizeof(meshCacheMagic)) != 0 || candidate->version != version)
+	{
+		Close();
+		return false;
+	}
+	uint64_t size = file.GetSize();
+	uint64_t vertexCount = candidate->vertexCount;
+	uint64_t tangentCount = candidate->tangentCount;
+	bool valid = (candidate->indexSize == 1 || candidate->indexSize == 2 || candidate->indexSize == 4)
+		&& candidate->verticesOffset + vertexCount * sizeof(glm::vec3) <= size
+		&& candidate->uvsOffset + vertexCount * sizeof(glm::vec2) <= size
+		&& candidate->normalsOffset + vertexCount * sizeof(glm::vec3) <= size
+		&& candidate->tangentsOffset + tangentCount * sizeof(glm::vec3) <= size
+		&& candidate->bitangentsOffset + tangentCount * sizeof(glm::vec3) <= size
+		&& candidate->indicesOffset + (uint64_t)candidate->indicesCount * candidate->indexSize <= size;
+	if (!valid)
+	{
+		Close();
+		return false;
+	}
+	header = candidate;
+	return true;
+}
+
+void MeshCache::Close()
+{
+	file.Close();
+	header = nullptr;
+}
+
+const MeshCacheHeader* MeshCache::GetHeader() const
+{
+	return header;
+}
+
+const glm::vec3* MeshCache::GetVertices() const
+{
+	return (const glm::vec3*)(file.GetData() + header->verticesOffset);
+}
+
+const glm::vec2* MeshCache::GetUVs() const
+{
+	return (const glm::vec2*)(file.GetData() + header->uvsOffset);
+}
+
+const glm::vec3* MeshCache::GetNormals() const
+{
+	return (const glm::vec3*)(file.GetData() + header->normalsOffset);
+}
+
+const glm::vec3* MeshCache::GetTangents() const
+{
+	return (const glm::vec3*)(file.GetData() + header->tangentsOffset);
+}
+
+const glm::vec3* MeshCache::GetBitangents() const
+{
+	return (const glm::vec3*)(file.GetData() + header->bitangentsOffset);
+}
+
+const void* MeshCache::GetIndicesData() const
+{
+	return file.GetData() + header->indicesOffset;
+}
+
+void MeshCache::CopyTo(OBJ* obj) const
+{
+	obj->indexed_vertices.assign(GetVertices(), GetVertices() + header->vertexCount);
+	obj->indexed_uvs.assign(GetUVs(), GetUVs() + header->vertexCount);
+	obj->indexed_normals.assign(GetNormals(), GetNormals() + header->vertexCount);
+	obj->indexed_tangents.assign(GetTangents(), GetTangents() + header->tangentCount);
+	obj->indexed_bitangents.assign(GetBitangents(), GetBitangents() + header->tangentCount);
+	if (header->indexSize == sizeof(unsigned char))
+	{
+		const unsigned char* indices = (const unsigned char*)GetIndicesData();
+		obj->indicesUB.assign(indices, indices + header->indicesCount);
+	}
+	else if (header->indexSize == sizeof(unsigned short))
+	{
+		const unsigned short* indices = (const unsigned short*)GetIndicesData();
+		obj->indicesUS.assign(indices, indices + header->indicesCount);
+	}
+	else
+	{
+		const unsigned int* indices = (const unsigned int*)GetIndicesData();
+		obj->indices.assign(indices, indices + header->indicesCount);
+	}
+	CopyInfoTo(obj);
+}
+
+void MeshCache::CopyInfoTo(OBJ* obj) const
+{
+	obj->indicesCount = header->indicesCount;
+	obj->dimensions = glm::vec3(header->dimensions[0], header->dimensions[1], header->dimensions[2]);
+	obj->center_of_mesh = glm::vec3(header->centerOfMesh[0], header->centerOfMesh[1], header->centerOfMesh[2]);
+}
+
+bool MeshCache::Write(OBJ* obj, const std::string& cachePath)
+{
+	MeshCacheHeader newHeader = {};
+	memcpy(newHeader.magic, meshCacheMagic, sizeof(meshCacheMagic));
+	newHeader.version = version;
+	newHeader.vertexCount = (uint32_t)obj->indexed_vertices.size();
+	newHeader.tangentCount = (uint32_t)obj->indexed_tangents.size();
+	newHeader.indicesCount = obj->indicesCount;
+	newHeader.indexSize = obj->indicesCount <= UCHAR_MAX ? 1 : obj->indicesCount <= USHRT_MAX ? 2 : 4;
+	for (int i = 0; i < 3; i++)
+	{
+		newHeader.dimensions[i] = obj->dimensions[i];
+		newHeader.centerOfMesh[i] = obj->center_of_mesh[i];
+	}
+
+	const void* streams[6] = { obj->indexed_vertices.data(), obj->indexed_uvs.data(), obj->indexed_normals.data(), obj->indexed_tangents.data(), obj->indexed_bitangents.data(), obj->GetIndicesData() };
+	uint64_t sizes[6] = {
+		newHeader.vertexCount * sizeof(glm::vec3),
+		newHeader.vertexCount * sizeof(glm::vec2),
+		newHeader.vertexCount * sizeof(glm::vec3),
+		newHeader.tangentCount * sizeof(glm::vec3),
+		newHeader.tangentCount * sizeof(glm::vec3),
+		(uint64_t)newHeader.indicesCount * newHeader.indexSize };
+	uint64_t* offsets[6] = { &newHeader.verticesOffset, &newHeader.uvsOffset, &newHeader.normalsOffset, &newHeader.tangentsOffset, &newHeader.bitangentsOffset, &newHeader.indicesOffset };
+	uint64_t offset = AlignOffset(sizeof(MeshCacheHeader));
+	for (int i = 0; i < 6; i++)
+	{
+		*offsets[i] = offset;
+		offset = AlignOffset(offset + sizes[i]);
+	}
+
+	//written next to the cache and renamed over it so a reader never maps a half written file
+	std::string tempPath = cachePath + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (file == NULL)
+	{
+		printf("\nCould not write mesh cache %s", cachePath.c_str());
+		return false;
+	}
+	const char padding[16] = {};
+	uint64_t written = fwrite(&newHeader, 1, sizeof(MeshCacheHeader), file);
+	bool ok = written == sizeof(MeshCacheHeader);
+	for (int i = 0; i < 6 && ok; i++)
+	{
+		ok = fwrite(padding, 1, *offsets[i] - written, file) == *offsets[i] - written;
+		written = *offsets[i];
+		if (sizes[i] > 0) ok = ok && fwrite(streams[i], 1, sizes[i], file) == sizes[i];
+		written += sizes[i];
+	}
+	ok = fclose(file) == 0 && ok;
+
+	std::error_code error;
+	if (ok) std::filesystem::rename(tempPath, cachePath, error);
+	if (!ok || error)
+	{
+		std::filesystem::remove(tempPath, error);
+		printf("\nCould not write mesh cache %s", cachePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath)
+{
+	return std::filesystem::path(sourcePath).replace_extension(".mesh").string();
+}
+
+bool MeshCache::IsUpToDate(const std::string& sourcePath, const std::string& cachePath)
+{
+	std::error_code error;
+	auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+	if (error) return false;
+	auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+	if (error) return true;
+	return cacheTime >= sourceTime;
+}
+
+bool MeshCache::Bake(const std::string& sourcePath, bool force)
+{
+	std::string cachePath = GetCachePath(sourcePath);
+	if (!force && IsUpToDate(sourcePath, cachePath)) return true;
+	OBJ obj;
+	if (!obj.LoadAndIndexOBJ(sourcePath.c_str())) return false;
+	return Write(&obj, cachePath);
+}
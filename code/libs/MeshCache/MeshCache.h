@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "MyMathLib.h"
+#include "MappedFile.h"
+
+class OBJ;
+
+//fixed size header at the start of a mesh cache file
+//every stream starts at a 16 byte aligned offset so it can be handed to the gpu straight from the mapped file
+struct MeshCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t vertexCount;
+	uint32_t tangentCount;
+	uint32_t indicesCount;
+	uint32_t indexSize; //1, 2 or 4 bytes, same narrowing as OBJ::ProcessIndicesType
+	float dimensions[3];
+	float centerOfMesh[3];
+	uint64_t verticesOffset;
+	uint64_t uvsOffset;
+	uint64_t normalsOffset;
+	uint64_t tangentsOffset;
+	uint64_t bitangentsOffset;
+	uint64_t indicesOffset;
+};
+
+//binary, memory mapped copy of an indexed OBJ so startup skips parsing, welding and tangent generation
+class MeshCache
+{
+public:
+	static const uint32_t version = 1;
+
+	MeshCache();
+	~MeshCache();
+	//maps the cache and checks magic, version and that every stream lies inside the file
+	bool Open(const char* cachePath);
+	void Close();
+	const MeshCacheHeader* GetHeader() const;
+	const glm::vec3* GetVertices() const;
+	const glm::vec2* GetUVs() const;
+	const glm::vec3* GetNormals() const;
+	const glm::vec3* GetTangents() const;
+	const glm::vec3* GetBitangents() const;
+	const void* GetIndicesData() const;
+	//fills the cpu side streams of the OBJ, half edge meshes, scripts and mesh saving read those
+	void CopyTo(OBJ* obj) const;
+	//fills only the index count, dimensions and center, the streams stay in the file
+	void CopyInfoTo(OBJ* obj) const;
+
+	static bool Write(OBJ* obj, const std::string& cachePath);
+	static std::string GetCachePath(const std::string& sourcePath);
+	//true when the cache exists and the source is not newer, a cache without its source is also up to date
+	static bool IsUpToDate(const std::string& sourcePath, const std::string& cachePath);
+	//parses the source and writes its cache, skipped when the cache is up to date unless forced
+	static bool Bake(const std::string& sourcePath, bool force = false);
+private:
+	//copy
+	MeshCache(const MeshCache&);
+	//assign
+	MeshCache& operator=(const MeshCache&);
+
+	MappedFile file;
+	const MeshCacheHeader* header;
+};
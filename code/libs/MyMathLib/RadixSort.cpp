@@ -0,0 +1,45 @@
+#include "RadixSort.h"
+
+void RadixSort::Sort(std::vector<SortPair>& pairs, std::vector<SortPair>& scratch)
+{
+	size_t count = pairs.size();
+	if (count < 2) return;
+	scratch.resize(count);
+
+	//all eight histograms in one read of the keys
+	uint32_t histograms[8][256] = {};
+	for (const SortPair& pair : pairs)
+	{
+		uint64_t key = pair.key;
+		for (int digit = 0; digit < 8; digit++)
+		{
+			histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+		}
+	}
+
+	SortPair* source = pairs.data();
+	SortPair* destination = scratch.data();
+	for (int digit = 0; digit < 8; digit++)
+	{
+		uint32_t* histogram = histograms[digit];
+		uint32_t firstBucket = (uint32_t)((source[0].key >> (digit * 8)) & 0xFF);
+		if (histogram[firstBucket] == count) continue;
+
+		uint32_t offset = 0;
+		for (int bucket = 0; bucket < 256; bucket++)
+		{
+			uint32_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			uint32_t bucket = (uint32_t)((source[i].key >> (digit * 8)) & 0xFF);
+			destination[histogram[bucket]++] = source[i];
+		}
+		SortPair* temp = source;
+		source = destination;
+		destination = temp;
+	}
+	if (source != pairs.data()) pairs.swap(scratch);
+}
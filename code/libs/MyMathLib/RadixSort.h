@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct SortPair
+{
+	uint64_t key;
+	uint32_t value;
+};
+
+//least significant digit radix sort on the key, 8 bits per pass, stable
+//passes where every key has the same digit are skipped so short keys only pay for the bytes they use
+class RadixSort
+{
+public:
+	static void Sort(std::vector<SortPair>& pairs, std::vector<SortPair>& scratch);
+};
@@ -1,11 +1,11 @@
 #include "Node.h"
 #include "Object.h"
 
+unsigned int Node::hierarchyVersion = 0;
 
 Node::Node()
 {
 	TopDownTransform = glm::mat4(1);
-	TopDownTransformF = glm::mat4(1);
 	LocalScaleM = glm::mat4(1);
 	LocalPositionM = glm::mat4(1);
 	LocalOrientationM = glm::mat4(1);
@@ -14,6 +14,8 @@ Node::Node()
 	localPosition = glm::vec3(1);
 	localOrientation = glm::quat(1,0,0,0);
 	parent = this;
+	localDirty = true;
+	worldVersion = 0;
 	movable = false;
 	totalMovable = movable;
 }
@@ -34,14 +36,33 @@ void Node::Init(Object* parent)
 void Node::UpdateNode(const Node& parentNode)
 {
 	totalScale = localScale * parentNode.totalScale;
-	TopDownTransform = LocalPositionM * LocalOrientationM * LocalScaleM * parentNode.TopDownTransform;
-	TopDownTransformF = TopDownTransform;
+	ComposeTransform(glm::vec3(LocalPositionM[3]), GetLocalRotationScale(), parentNode.TopDownTransform, TopDownTransform);
+	worldVersion++;
 	for (auto& childNode : children)
 	{
 		childNode->UpdateNode(*this);
 	}
 }
 
+glm::mat3 Node::GetLocalRotationScale() const
+{
+	//LocalScaleM is diagonal so scaling the orientation columns is the whole product
+	return glm::mat3(
+		glm::vec3(LocalOrientationM[0]) * LocalScaleM[0][0],
+		glm::vec3(LocalOrientationM[1]) * LocalScaleM[1][1],
+		glm::vec3(LocalOrientationM[2]) * LocalScaleM[2][2]);
+}
+
+void Node::ComposeTransform(const glm::vec3& position, const glm::mat3& rotationScale, const glm::mat4& parentTransform, glm::mat4& result)
+{
+	//local matrix is affine so every column of the product is rotationScale * xyz + position * w
+	for (int i = 0; i < 4; i++)
+	{
+		const glm::vec4& column = parentTransform[i];
+		result[i] = glm::vec4(rotationScale * glm::vec3(column) + position * column.w, column.w);
+	}
+}
+
 Component* Node::Clone()
 {
 	return new Node(*this);
@@ -51,6 +72,7 @@ void Node::addChild(Node* child)
 {
 	child->parent = this;
 	children.push_back(child);
+	hierarchyVersion++;
 }
 
 void Node::removeChild(Node* child)
@@ -61,6 +83,7 @@ void Node::removeChild(Node* child)
 		{
 			children[i] = children.back();
 			children.pop_back();
+			hierarchyVersion++;
 			return;
 		}
 	}
@@ -85,6 +108,7 @@ void Node::SetPosition(const glm::vec3& vector)
 {
 	localPosition = vector;
 	MathUtils::SetPosition(LocalPositionM, vector);
+	localDirty = true;
 }
 
 glm::vec3 Node::GetWorldPosition() const
@@ -419,24 +443,28 @@ void Node::SetScale(const glm::vec3& vector)
 {
 	localScale = vector;
 	MathUtils::SetScale(LocalScaleM, vector);
+	localDirty = true;
 }
 
 void Node::Translate(const glm::vec3& vector)
 {
 	localPosition += vector;
 	MathUtils::SetPosition(LocalPositionM, localPosition);
+	localDirty = true;
 }
 
 void Node::SetOrientation(const glm::quat& q)
 {
 	localOrientation = glm::normalize(q);//for now
 	LocalOrientationM = glm::mat4_cast(localOrientation);
+	localDirty = true;
 }
 
 void Node::SetRotation(const glm::mat4& m)
 {
 	LocalOrientationM = m;
 	localOrientation = glm::normalize(glm::quat_cast(LocalOrientationM));
+	localDirty = true;
 }
 
 glm::quat& Node::GetLocalOrientation()
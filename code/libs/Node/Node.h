@@ -17,7 +17,6 @@ public:
 	void addChild(Node* child);
 	void removeChild(Node* child);
 	glm::mat4 TopDownTransform;
-	glm::mat4 TopDownTransformF;
 	
 	glm::mat4 LocalScaleM;
 	glm::mat4 LocalPositionM;
@@ -26,8 +25,18 @@ public:
 	glm::quat localOrientation;
 	glm::vec3 localScale;
 	glm::vec3 totalScale;
+	//set by the local setters and cleared once the flat transform arrays picked up the new local transform
+	bool localDirty;
+	//incremented every time TopDownTransform is recomputed, dependents keep the last version they saw
+	unsigned int worldVersion;
 	std::string name;
 	virtual void UpdateNode(const Node& parentNode);
+	glm::mat3 GetLocalRotationScale() const;
+	//same result as LocalPositionM * LocalOrientationM * LocalScaleM * parentTransform
+	//without building the local matrix, rotationScale is the upper 3x3 of LocalOrientationM * LocalScaleM
+	static void ComposeTransform(const glm::vec3& position, const glm::mat3& rotationScale, const glm::mat4& parentTransform, glm::mat4& result);
+	//bumped on every addChild and removeChild so flattened copies of the tree know when to rebuild
+	static unsigned int hierarchyVersion;
 	Component* Clone();
 	
 	void SetPosition(const glm::vec3& vector);
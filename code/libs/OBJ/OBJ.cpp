@@ -1,232 +1,278 @@
 #define _CRT_SECURE_NO_DEPRECATE
 #include "OBJ.h"
 #include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "MappedFile.h"
 
-
-bool OBJ::LoadAndIndexOBJ(const char* path)
+//flat open addressing table from a (v, vt, vn) index triple to the welded vertex index
+class CornerWelder
 {
-	// Read our .obj file
-	std::vector<glm::vec3> vertices;
-	std::vector<glm::vec2> uvs;
-	std::vector<glm::vec3> normals; // Won't be used at the moment.
-	bool res = LoadOBJ(path, vertices, uvs, normals);
-	if (res)
+public:
+	CornerWelder()
 	{
-		std::vector<glm::vec3> tangents;
-		std::vector<glm::vec3> bitangents;
-		ComputeTangentBasis(vertices, uvs, normals, tangents, bitangents);
-
-		indexVBO(vertices, uvs, normals, tangents, bitangents);
+		slots.assign(1024, 0);
+		mask = slots.size() - 1;
 	}
-	return res;
-}
-
-void OBJ::indexVBO(
-	std::vector<glm::vec3> & in_vertices,
-	std::vector<glm::vec2> & in_uvs,
-	std::vector<glm::vec3> & in_normals,
-	std::vector<glm::vec3> & in_tangents,
-	std::vector<glm::vec3> & in_bitangents
-	)
-{
-	std::map<PackedVertex, unsigned int> VertexToOutIndex;
-	
-	indices.reserve(in_vertices.size());
-	PackedVertex packed;
-	// For each input vertex
-	for (unsigned int i = 0; i<in_vertices.size(); i++){
-
-		packed.position = in_vertices[i];
-		packed.uv = in_uvs[i];
-		packed.normal = in_normals[i];
-
-		// Try to find a similar vertex in out_XXXX
-		unsigned int index;
-		bool found = getSimilarVertexIndex_fast(packed, VertexToOutIndex, index);
-
-		if (found){ // A similar vertex is already in the VertexBuffer, use it instead !
-			indices.emplace_back(index);
 
-			// Average the tangents and the bitangents
-			indexed_tangents[index] += in_tangents[i];
-			indexed_bitangents[index] += in_bitangents[i];
-		}
-		else{ // If not, it needs to be added in the output data.
-			indexed_vertices.emplace_back(in_vertices[i]);
-			indexed_uvs.emplace_back(in_uvs[i]);
-			indexed_normals.emplace_back(in_normals[i]);
-			indexed_tangents.emplace_back(in_tangents[i]);
-			indexed_bitangents.emplace_back(in_bitangents[i]);
-			unsigned int newindex = (unsigned int)indexed_vertices.size() - 1;
-			indices.emplace_back(newindex);
-			VertexToOutIndex[packed] = newindex;
+	//returns the welded index of the triple and adds it as a new vertex when it was not seen before
+	unsigned int Weld(int position, int uv, int normal, bool& added)
+	{
+		size_t slot = Hash(position, uv, normal) & mask;
+		while (slots[slot] != 0)
+		{
+			const glm::ivec3& key = keys[slots[slot] - 1];
+			if (key.x == position && key.y == uv && key.z == normal)
+			{
+				added = false;
+				return slots[slot] - 1;
+			}
+			slot = (slot + 1) & mask;
 		}
+		keys.emplace_back(position, uv, normal);
+		slots[slot] = (unsigned int)keys.size();
+		added = true;
+		//keep load factor at or below one half so probe sequences stay short
+		if (keys.size() * 2 > slots.size()) Grow();
+		return (unsigned int)keys.size() - 1;
 	}
 
-	ProcessIndicesType();
-
-	CalculateDimensions();
-}
-
-void OBJ::ProcessIndicesType()
-{
-	indicesCount = indices.size();
-	if (indicesCount <= UCHAR_MAX)
+	const glm::ivec3& GetKey(unsigned int index) const
 	{
-		for (size_t i = 0; i < indices.size(); i++)
-		{
-			indicesUB.push_back(indices[i]);
-		}
-		indices = std::vector<unsigned int>();
+		return keys[index];
 	}
-	else if (indicesCount <= USHRT_MAX)
+private:
+	static size_t Hash(int position, int uv, int normal)
 	{
-		for (size_t i = 0; i < indices.size(); i++)
+		uint64_t hash = (uint64_t)(uint32_t)position * 0x9E3779B97F4A7C15ull;
+		hash ^= (uint64_t)(uint32_t)uv * 0xC2B2AE3D27D4EB4Full;
+		hash ^= (uint64_t)(uint32_t)normal * 0x165667B19E3779F9ull;
+		return (size_t)(hash ^ (hash >> 29));
+	}
+
+	void Grow()
+	{
+		slots.assign(slots.size() * 2, 0);
+		mask = slots.size() - 1;
+		for (size_t i = 0; i < keys.size(); i++)
 		{
-			indicesUS.push_back(indices[i]);
+			size_t slot = Hash(keys[i].x, keys[i].y, keys[i].z) & mask;
+			while (slots[slot] != 0) slot = (slot + 1) & mask;
+			slots[slot] = (unsigned int)i + 1;
 		}
-		indices = std::vector<unsigned int>();
 	}
+
+	std::vector<unsigned int> slots; //welded index + 1, 0 is an empty slot
+	std::vector<glm::ivec3> keys;
+	size_t mask;
+};
+
+static inline const char* SkipSpaces(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t')) p++;
+	return p;
 }
 
-bool OBJ::getSimilarVertexIndex_fast(PackedVertex & packed, std::map<PackedVertex, unsigned int> & VertexToOutIndex, unsigned int & result)
+static inline const char* SkipLine(const char* p, const char* end)
 {
-	auto it = VertexToOutIndex.find(packed);
-	if (it == VertexToOutIndex.end()){
-		return false;
-	}
-	else{
-		result = it->second;
-		return true;
-	}
+	const char* newLine = (const char*)memchr(p, '\n', end - p);
+	return newLine != nullptr ? newLine + 1 : end;
 }
 
-bool OBJ::LoadOBJ(
-	const char * path,
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
-	)
+static inline const char* ParseFloat(const char* p, const char* end, float& value)
 {
-	printf("\nLoading OBJ file %s...", path);
+	p = SkipSpaces(p, end);
+	if (p < end && *p == '+') p++;
+	auto result = std::from_chars(p, end, value);
+	if (result.ec != std::errc()) value = 0.f;
+	return result.ptr;
+}
 
-	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-	std::vector<glm::vec3> temp_vertices;
-	std::vector<glm::vec2> temp_uvs;
-	std::vector<glm::vec3> temp_normals;
+static inline const char* ParseIndex(const char* p, const char* end, int& value, bool& parsed)
+{
+	auto result = std::from_chars(p, end, value);
+	parsed = result.ec == std::errc();
+	return result.ptr;
+}
 
+//obj indices are one based and negative ones count back from the last element read so far, -1 means not given
+static inline bool ResolveIndex(int index, size_t count, int& resolved)
+{
+	if (index > 0) resolved = index - 1;
+	else resolved = (int)count + index;
+	return resolved >= 0 && (size_t)resolved < count;
+}
+
+bool OBJ::LoadAndIndexOBJ(const char* path)
+{
+	printf("\nLoading OBJ file %s...", path);
 	this->path = path;
-	FILE * file;
-	file = fopen(path, "r");
-	float x = 0.f, y = 0.f, z = 0.f;
-	unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-	char stupidBuffer[1000];
-	if (file == NULL){
+
+	MappedFile file;
+	if (!file.Open(path))
+	{
 		printf("\nImpossible to open the file ! Are you in the right path ?");
-		//getchar();
 		return false;
 	}
-	while (1){
 
-		char lineHeader[128];
-		// read the first word of the line
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break; // EOF = End Of File. Quit the loop.
-
-		// else : parse lineHeader
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	CornerWelder welder;
+	bool missingNormals = false;
 
-		if (strcmp(lineHeader, "v") == 0){
+	const char* p = file.GetData();
+	const char* end = p + file.GetSize();
+	while (p < end)
+	{
+		p = SkipSpaces(p, end);
+		if (p + 1 >= end)
+		{
+			break;
+		}
+		if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+		{
 			//position
-			fscanf(file, "%f %f %f\n", &x, &y, &z);
-			temp_vertices.emplace_back(x, y, z);
+			glm::vec3 position;
+			p = ParseFloat(p + 1, end, position.x);
+			p = ParseFloat(p, end, position.y);
+			p = ParseFloat(p, end, position.z);
+			positions.push_back(position);
 		}
-		else if (strcmp(lineHeader, "vt") == 0){
+		else if (p[0] == 'v' && p[1] == 't')
+		{
 			//uv
-			fscanf(file, "%f %f\n", &x, &y);
-			y = -y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
-			temp_uvs.emplace_back(x, y);
+			glm::vec2 uv;
+			p = ParseFloat(p + 2, end, uv.x);
+			p = ParseFloat(p, end, uv.y);
+			uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
+			uvs.push_back(uv);
 		}
-		else if (strcmp(lineHeader, "vn") == 0){
+		else if (p[0] == 'v' && p[1] == 'n')
+		{
 			//normal
-			fscanf(file, "%f %f %f\n", &x, &y, &z);
-			temp_normals.emplace_back(x, y, z);
+			glm::vec3 normal;
+			p = ParseFloat(p + 2, end, normal.x);
+			p = ParseFloat(p, end, normal.y);
+			p = ParseFloat(p, end, normal.z);
+			normals.push_back(normal);
 		}
-		else if (strcmp(lineHeader, "f") == 0){
-			int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-			if (matches != 9){
-				printf("\nFile can't be read by our simple parser :-( Try exporting with other options\n");
-				return false;
+		else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			//faces with more than three corners are fanned around the first corner
+			p++;
+			int cornerCount = 0;
+			unsigned int firstCorner = 0;
+			unsigned int previousCorner = 0;
+			while (true)
+			{
+				p = SkipSpaces(p, end);
+				if (p >= end || *p == '\n' || *p == '\r' || *p == '#') break;
+
+				int positionIndex = 0, uvIndex = 0, normalIndex = 0;
+				bool parsed = false;
+				p = ParseIndex(p, end, positionIndex, parsed);
+				if (parsed && p < end && *p == '/')
+				{
+					p++;
+					if (p < end && *p != '/') p = ParseIndex(p, end, uvIndex, parsed);
+					if (parsed && p < end && *p == '/') p = ParseIndex(p + 1, end, normalIndex, parsed);
+				}
+
+				int position = -1, uv = -1, normal = -1;
+				bool valid = parsed && ResolveIndex(positionIndex, positions.size(), position);
+				if (valid && uvIndex != 0) valid = ResolveIndex(uvIndex, uvs.size(), uv);
+				if (valid && normalIndex != 0) valid = ResolveIndex(normalIndex, normals.size(), normal);
+				if (!valid)
+				{
+					printf("\nFile can't be read by our parser, face corner %d is invalid\n", cornerCount + 1);
+					return false;
+				}
+
+				bool added;
+				unsigned int corner = welder.Weld(position, uv, normal, added);
+				if (added)
+				{
+					indexed_vertices.push_back(positions[position]);
+					indexed_uvs.push_back(uv >= 0 ? uvs[uv] : glm::vec2(0.f));
+					indexed_normals.push_back(normal >= 0 ? normals[normal] : glm::vec3(0.f));
+					missingNormals |= normal < 0;
+				}
+
+				if (cornerCount == 0)
+				{
+					firstCorner = corner;
+				}
+				else if (cornerCount >= 2)
+				{
+					indices.push_back(firstCorner);
+					indices.push_back(previousCorner);
+					indices.push_back(corner);
+				}
+				previousCorner = corner;
+				cornerCount++;
 			}
-			vertexIndices.emplace_back(vertexIndex[0]);
-			vertexIndices.emplace_back(vertexIndex[1]);
-			vertexIndices.emplace_back(vertexIndex[2]);
-			uvIndices.emplace_back(uvIndex[0]);
-			uvIndices.emplace_back(uvIndex[1]);
-			uvIndices.emplace_back(uvIndex[2]);
-			normalIndices.emplace_back(normalIndex[0]);
-			normalIndices.emplace_back(normalIndex[1]);
-			normalIndices.emplace_back(normalIndex[2]);
-		}
-		else{
-			// Probably a comment, eat up the rest of the line
-			fgets(stupidBuffer, 1000, file);
 		}
+		// anything else is a comment or a statement we don't use, eat up the rest of the line
+		p = SkipLine(p, end);
+	}
 
+	if (indices.empty())
+	{
+		printf("\nOBJ %s has no faces", path);
+		return false;
 	}
-	out_vertices.reserve(vertexIndices.size());
-	out_uvs.reserve(vertexIndices.size());
-	out_normals.reserve(vertexIndices.size());
-	// For each vertex of each triangle
-	for (unsigned int i = 0; i<vertexIndices.size(); i++){
-
-		// Get the indices of its attributes
-		//unsigned int vertexIndex = vertexIndices[i];
-		//unsigned int uvIndex = uvIndices[i];
-		//unsigned int normalIndex = normalIndices[i];
-
-		// Get the attributes thanks to the index
-		//glm::vec3& vertex = temp_vertices[vertexIndex - 1];
-		//glm::vec2& uv = temp_uvs[uvIndex - 1];
-		//glm::vec3& normal = temp_normals[normalIndex - 1];
-
-		// Put the attributes in buffers
-		out_vertices.emplace_back(temp_vertices[vertexIndices[i] - 1]);
-		out_uvs.emplace_back(temp_uvs[uvIndices[i] - 1]);
-		out_normals.emplace_back(temp_normals[normalIndices[i] - 1]);
 
+	if (missingNormals)
+	{
+		//area weighted face normals summed into the vertices that came without one
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			glm::vec3 faceNormal = glm::cross(indexed_vertices[b] - indexed_vertices[a], indexed_vertices[c] - indexed_vertices[a]);
+			if (welder.GetKey(a).z < 0) indexed_normals[a] += faceNormal;
+			if (welder.GetKey(b).z < 0) indexed_normals[b] += faceNormal;
+			if (welder.GetKey(c).z < 0) indexed_normals[c] += faceNormal;
+		}
+		for (size_t i = 0; i < indexed_normals.size(); i++)
+		{
+			float length = glm::length(indexed_normals[i]);
+			if (welder.GetKey((unsigned int)i).z < 0 && length > 0.f) indexed_normals[i] /= length;
+		}
 	}
+
+	ComputeTangents();
+
+	ProcessIndicesType();
+
+	CalculateDimensions();
+
 	printf("\nFinished loading OBJ %s", path);
-	fclose(file);
 	return true;
 }
 
-void OBJ::ComputeTangentBasis(
-	// inputs
-	std::vector<glm::vec3> & in_vertices,
-	std::vector<glm::vec2> & in_uvs,
-	std::vector<glm::vec3> & in_normals,
-	// outputs
-	std::vector<glm::vec3> & out_tangents,
-	std::vector<glm::vec3>& out_bitangents
-) {
-
-	out_tangents.reserve(in_vertices.size());
-	out_bitangents.reserve(in_vertices.size());
-	for (unsigned int i = 0; i < in_vertices.size(); i += 3) {
+//per triangle tangents orthogonalized against each corner normal and summed into the welded vertices
+void OBJ::ComputeTangents()
+{
+	indexed_tangents.assign(indexed_vertices.size(), glm::vec3(0.f));
+	indexed_bitangents.assign(indexed_vertices.size(), glm::vec3(0.f));
+	unsigned int invalidUVs = 0;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		unsigned int corners[3] = { indices[i], indices[i + 1], indices[i + 2] };
 
 		// Shortcuts for vertices
-		glm::vec3 & v0 = in_vertices[i + 0];
-		glm::vec3 & v1 = in_vertices[i + 1];
-		glm::vec3 & v2 = in_vertices[i + 2];
+		glm::vec3& v0 = indexed_vertices[corners[0]];
+		glm::vec3& v1 = indexed_vertices[corners[1]];
+		glm::vec3& v2 = indexed_vertices[corners[2]];
 
 		// Shortcuts for UVs
-		glm::vec2 & uv0 = in_uvs[i + 0];
-		glm::vec2 & uv1 = in_uvs[i + 1];
-		glm::vec2 & uv2 = in_uvs[i + 2];
+		glm::vec2& uv0 = indexed_uvs[corners[0]];
+		glm::vec2& uv1 = indexed_uvs[corners[1]];
+		glm::vec2& uv2 = indexed_uvs[corners[2]];
 
 		// Edges of the triangle : postion delta
 		glm::vec3 deltaPos1 = v1 - v0;
@@ -236,47 +282,59 @@ void OBJ::ComputeTangentBasis(
 		glm::vec2 deltaUV1 = uv1 - uv0;
 		glm::vec2 deltaUV2 = uv2 - uv0;
 
-
 		float r = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
-		if (isinf(r))
-		{
-			printf("\nInvalid UVS, inf, possible cause: uvs of a triangle are at the same position");
-			r = 0.0f;
-		}
-		if (isnan(r))
+		if (isinf(r) || isnan(r))
 		{
-			printf("\nInvalid UVS, nan");
+			//possible cause: uvs of a triangle are at the same position or the mesh has no uvs
+			invalidUVs++;
 			r = 0.0f;
 		}
 
-		glm::vec3 tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y)*r;
-		glm::vec3 bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x)*r;
+		glm::vec3 tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y) * r;
+		glm::vec3 bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x) * r;
 
-		// Set the same tangent for all three vertices of the triangle.
-		// They will be indexed later
-		out_tangents.emplace_back(tangent);
-		out_tangents.emplace_back(tangent);
-		out_tangents.emplace_back(tangent);
-
-		// Same thing for binormals
-		out_bitangents.emplace_back(bitangent);
-		out_bitangents.emplace_back(bitangent);
-		out_bitangents.emplace_back(bitangent);
+		for (int j = 0; j < 3; j++)
+		{
+			const glm::vec3& n = indexed_normals[corners[j]];
+			// Gram-Schmidt orthogonalize
+			glm::vec3 t = tangent - n * glm::dot(n, tangent);
+			//triangles without uvs have no tangent, normalizing it would spread nans over the welded corners
+			float lengthSquared = glm::dot(t, t);
+			if (lengthSquared <= 0.f) continue;
+			t /= sqrtf(lengthSquared);
+
+			// Calculate handedness
+			if (glm::dot(glm::cross(n, t), bitangent) > 0.0f) {
+				t = t * -1.0f;
+			}
+			indexed_tangents[corners[j]] += t;
+			indexed_bitangents[corners[j]] += bitangent;
+		}
+	}
+	if (invalidUVs > 0)
+	{
+		printf("\nInvalid UVS in %u triangles", invalidUVs);
 	}
+}
 
-	// See "Going Further"
-	for (unsigned int i = 0; i < in_vertices.size(); i += 1)
+void OBJ::ProcessIndicesType()
+{
+	indicesCount = indices.size();
+	if (indicesCount <= UCHAR_MAX)
 	{
-		glm::vec3 & n = in_normals[i];
-		glm::vec3 & t = out_tangents[i];
-		glm::vec3 & b = out_bitangents[i];
-		// Gram-Schmidt orthogonalize
-		t = glm::normalize(t - n * glm::dot(n, t));
-
-		// Calculate handedness
-		if (glm::dot(glm::cross(n, t), b) > 0.0f) {
-			t = t * -1.0f;
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			indicesUB.push_back(indices[i]);
 		}
+		indices = std::vector<unsigned int>();
+	}
+	else if (indicesCount <= USHRT_MAX)
+	{
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			indicesUS.push_back(indices[i]);
+		}
+		indices = std::vector<unsigned int>();
 	}
 }
 
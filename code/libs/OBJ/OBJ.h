@@ -19,25 +19,8 @@ public:
 	int ID;
 	std::string name;
 	std::string path;
-	bool LoadOBJ(
-		const char * path,
-		std::vector<glm::vec3>& out_vertices,
-		std::vector<glm::vec2>& out_uvs,
-		std::vector<glm::vec3>& out_normals
-		);
-	void ComputeTangentBasis(
-		std::vector<glm::vec3>& in_vertices,
-		std::vector<glm::vec2>& in_uvs,
-		std::vector<glm::vec3>& in_normals,
-		std::vector<glm::vec3>& out_tangents,
-		std::vector<glm::vec3>& out_bitangents);
-	void indexVBO(
-		std::vector<glm::vec3>& in_vertices,
-		std::vector<glm::vec2>& in_uvs,
-		std::vector<glm::vec3>& in_normals,
-		std::vector<glm::vec3>& in_tangents,
-		std::vector<glm::vec3>& in_bitangents
-);
+	//parses a memory mapped obj, faces may be triangles, quads or n-gons with v, v/vt, v//vn or v/vt/vn corners and negative indices
+	//corners are welded on their index triple, missing normals are smoothed from the faces, missing uvs are zero
 	bool LoadAndIndexOBJ(const char* path);
 	void ProcessIndicesType();
 	glm::vec3 GetDimensions();
@@ -48,19 +31,8 @@ public:
 	void* GetIndicesData();
 	void CalculateDimensions();
 	unsigned int indicesCount;
+	//set while the streams above are still only in the mesh cache, GraphicsManager::LoadOBJStreams fills them
+	std::string cachePath;
 private:
-	struct PackedVertex{
-		glm::vec3 position;
-		glm::vec2 uv;
-		glm::vec3 normal;
-		bool operator<(const PackedVertex &that) const{
-			return memcmp((void*)this, (void*)&that, sizeof(PackedVertex))>0;
-		};
-	};
-	static bool getSimilarVertexIndex_fast(
-		PackedVertex & packed,
-		std::map<PackedVertex, unsigned int> & VertexToOutIndex,
-		unsigned int & result
-		);
-};
-
+	void ComputeTangents();
+};
\ No newline at end of file
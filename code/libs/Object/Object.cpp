@@ -32,6 +32,7 @@ void Object::AssignMaterial(Material* mat, int sequenceIndex, int materialSlot)
 		materials[sequenceIndex].resize(materialSlot + 1);
 	}
 	materials[sequenceIndex][materialSlot] = mat;
+	materialsVersion++;
 }
 
 void Object::UnAssignMaterial(int matSequenceIndex, int slot)
@@ -41,6 +42,7 @@ void Object::UnAssignMaterial(int matSequenceIndex, int slot)
 		if (materials[matSequenceIndex].size() > slot)
 		{
 			materials[matSequenceIndex].erase(materials[matSequenceIndex].begin() + slot);
+			materialsVersion++;
 			if (materials[matSequenceIndex].size() == 0)
 			{
 				materials.erase(materials.begin() + matSequenceIndex);
@@ -51,6 +53,7 @@ void Object::UnAssignMaterial(int matSequenceIndex, int slot)
 
 void Object::AddMaterial(Material* mat, int matSequenceIndex)
 {
+	materialsVersion++;
 	if (matSequenceIndex != -1)
 	{
 		if (materials.size() < matSequenceIndex + 1)
@@ -76,6 +79,7 @@ void Object::RemoveMaterial(Material* mat)
 		{
 			matSq[index] = matSq.back();
 			matSq.pop_back();
+			materialsVersion++;
 			if (matSq.size() == 0)
 			{
 				sqToErase.push_back(i);
@@ -92,6 +96,7 @@ void Object::RemoveMaterial(Material* mat)
 void Object::RemoveMaterialSequence(int index)
 {
 	materials.erase(materials.begin() + index);
+	materialsVersion++;
 }
 
 Material* Object::GetMaterial(const char* name)
@@ -148,6 +153,14 @@ void Object::UpdateComponents()
 	}
 }
 
+void Object::UpdateComponents(bool threadSafe)
+{
+	for (auto component : dynamicComponents)
+	{
+		if (component.second->IsThreadSafe() == threadSafe) component.second->Update();
+	}
+}
+
 void Object::ResetIDs()
 {
 	currentID = 0;
@@ -158,6 +171,13 @@ unsigned int Object::Count()
 	return currentID;
 }
 
+unsigned int Object::ReserveIDs(unsigned int count)
+{
+	unsigned int firstID = currentID;
+	currentID += count;
+	return firstID;
+}
+
 int Object::FindMaterialIndex(Material* materialToFind, std::vector<Material*>& matSq)
 {
 	for (size_t i = 0; i < matSq.size(); i++)
@@ -255,4 +275,5 @@ void Object::RemoveComponent(std::type_index& componentToRemove)
 	}
 }
 
-unsigned int Object::currentID = 0;
\ No newline at end of file
+unsigned int Object::currentID = 0;
+unsigned int Object::materialsVersion = 0;
\ No newline at end of file
@@ -51,6 +51,8 @@ public:
 	Object* GetParentObject();
 
 	std::vector<std::vector<Material*>> materials;
+	//bumped whenever any object's material sequences change
+	static unsigned int materialsVersion;
 	std::unordered_map<std::type_index, Component*> components;
 	std::unordered_map<std::type_index, Component*> dynamicComponents;
 
@@ -84,6 +86,7 @@ public:
 
 	void Update();
 	void UpdateComponents();
+	void UpdateComponents(bool threadSafe);
 
 	void StopDrawing() { draw = false; drawAlways = false; }
 	void DrawOnce() { draw = true; drawAlways = false; }
@@ -95,6 +98,8 @@ public:
 
 	static void ResetIDs();
 	static unsigned int Count();
+	//hands out count consecutive ids for things that are picked like objects without being one, returns the first
+	static unsigned int ReserveIDs(unsigned int count);
 	bool inFrustum = true;
 
 private:
@@ -101,6 +101,7 @@ void ObjectProfile::RemoveVBO(VertexBufferDynamic* vbo)
 		if (vbos[i] == vbo)
 		{
 			vbos.erase(vbos.begin() + i);
+			vboBindings.erase(vbo);
 			return;
 		}
 	}
@@ -120,24 +121,30 @@ void ObjectProfile::UpdateVBOCPUData()
 	{
 		//vbod->activeCount = 0;
 		auto& locations = vbod->layout.GetLocations();
+		auto& registryBindings = vboBindings[vbod];
 		for (auto& dr : registries)
 		{
 			if (dr->bindings.size() == 0)
 			{
 				continue;
 			}
-			bool elementSet = false;
-			for (auto& loc : locations)
+			CompiledBindings& bindings = registryBindings[dr];
+			if (!bindings.IsCurrent(dr, dr->version, vbod->layout.version))
 			{
-				auto property = dr->GetProperty(loc.name.c_str());
-				if (property != nullptr)
+				bindings.Begin(dr, dr->version, vbod->layout.version);
+				for (auto& loc : locations)
 				{
-					vbod->SetLocationData(property->dataAddress, loc);
-					elementSet = true;
+					auto property = dr->GetProperty(loc.name.c_str());
+					if (property != nullptr)
+					{
+						bindings.Add(loc.offset, property->dataAddress, loc.size);
+					}
 				}
+				bindings.End();
 			}
-			if (elementSet)
+			if (bindings.ranges.size() > 0)
 			{
+				vbod->SetData(bindings.ranges);
 				vbod->IncreaseInstanceCount();
 			}
 		}
@@ -148,15 +155,13 @@ void ObjectProfile::UpdateVBOCPUData()
 
 void ObjectProfile::UpdateShaderBlockCPUData()
 {
+	//the string lookups run only when the registry or the block layout changed, otherwise it's a copy per merged range
 	for (auto& sbd : shaderBlockDatas)
 	{
-		for (auto& nameAndOffset : sbd.shaderBlock->offsets)
+		if (registryPtr != nullptr)
 		{
-			auto property = registryPtr->GetProperty(nameAndOffset.first.c_str());
-			if (property != nullptr)
-			{
-				sbd.shaderBlock->data.SetData(nameAndOffset.second, property->dataAddress, property->size);
-			}
+			sbd.CompileBindings(*registryPtr);
+			sbd.UpdateFromCompiledBindings();
 		}
 		sbd.Submit();
 	}
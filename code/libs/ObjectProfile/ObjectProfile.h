@@ -39,4 +39,6 @@ public:
 	DataRegistry* registryPtr = nullptr;
 	std::vector<DataRegistry*> registries;
 private:
+	//per vbo, the registry properties resolved against its locations
+	std::unordered_map<const VertexBufferDynamic*, std::unordered_map<const DataRegistry*, CompiledBindings>> vboBindings;
 };
\ No newline at end of file
@@ -1,6 +1,35 @@
 #include "Particle.h"
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PARTICLE_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLE_SIMD_WIDTH 4
+#else
+#define PARTICLE_SIMD_WIDTH 1
+#endif
 
-
+//thin wrappers so one kernel body serves both instruction sets
+#if PARTICLE_SIMD_WIDTH == 8
+typedef __m256 SimdFloat;
+static inline SimdFloat SimdLoad(const float* src) { return _mm256_loadu_ps(src); }
+static inline void SimdStore(float* dst, SimdFloat v) { _mm256_storeu_ps(dst, v); }
+static inline SimdFloat SimdSet(float f) { return _mm256_set1_ps(f); }
+static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return _mm256_add_ps(a, b); }
+static inline SimdFloat SimdSub(SimdFloat a, SimdFloat b) { return _mm256_sub_ps(a, b); }
+static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return _mm256_mul_ps(a, b); }
+//one bit per lane that is not negative
+static inline int SimdAliveMask(SimdFloat v) { return _mm256_movemask_ps(_mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GE_OQ)); }
+#elif PARTICLE_SIMD_WIDTH == 4
+typedef __m128 SimdFloat;
+static inline SimdFloat SimdLoad(const float* src) { return _mm_loadu_ps(src); }
+static inline void SimdStore(float* dst, SimdFloat v) { _mm_storeu_ps(dst, v); }
+static inline SimdFloat SimdSet(float f) { return _mm_set1_ps(f); }
+static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return _mm_add_ps(a, b); }
+static inline SimdFloat SimdSub(SimdFloat a, SimdFloat b) { return _mm_sub_ps(a, b); }
+static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a, b); }
+static inline int SimdAliveMask(SimdFloat v) { return _mm_movemask_ps(_mm_cmpge_ps(v, _mm_setzero_ps())); }
+#endif
 
 Particle::Particle()
 {
@@ -11,3 +40,98 @@ Particle::~Particle()
 {
 
 }
+
+void ParticleStreams::Resize(int maxParticles)
+{
+	for (auto stream : { &posX, &posY, &posZ, &velX, &velY, &velZ, &lifeTime, &colorR, &colorG, &colorB, &colorA, &cameraDistance })
+	{
+		stream->resize(maxParticles);
+	}
+}
+
+void ParticleStreams::Integrate(int count, float deltaTime, const glm::vec3& force, const glm::vec3& cameraPos)
+{
+	// Simulate simple physics : gravity only, no collisions
+	glm::vec3 deltaSpeed = force * deltaTime * 0.5f;
+	float* px = posX.data(); float* py = posY.data(); float* pz = posZ.data();
+	float* vx = velX.data(); float* vy = velY.data(); float* vz = velZ.data();
+	float* life = lifeTime.data();
+	float* distance = cameraDistance.data();
+	int i = 0;
+#if PARTICLE_SIMD_WIDTH > 1
+	SimdFloat dt = SimdSet(deltaTime);
+	SimdFloat dvx = SimdSet(deltaSpeed.x), dvy = SimdSet(deltaSpeed.y), dvz = SimdSet(deltaSpeed.z);
+	SimdFloat cx = SimdSet(cameraPos.x), cy = SimdSet(cameraPos.y), cz = SimdSet(cameraPos.z);
+	for (; i + PARTICLE_SIMD_WIDTH <= count; i += PARTICLE_SIMD_WIDTH)
+	{
+		SimdStore(life + i, SimdSub(SimdLoad(life + i), dt));
+		SimdFloat x = SimdLoad(vx + i), y = SimdLoad(vy + i), z = SimdLoad(vz + i);
+		x = SimdAdd(x, dvx); y = SimdAdd(y, dvy); z = SimdAdd(z, dvz);
+		SimdStore(vx + i, x); SimdStore(vy + i, y); SimdStore(vz + i, z);
+		x = SimdAdd(SimdLoad(px + i), SimdMul(x, dt));
+		y = SimdAdd(SimdLoad(py + i), SimdMul(y, dt));
+		z = SimdAdd(SimdLoad(pz + i), SimdMul(z, dt));
+		SimdStore(px + i, x); SimdStore(py + i, y); SimdStore(pz + i, z);
+		x = SimdSub(x, cx); y = SimdSub(y, cy); z = SimdSub(z, cz);
+		SimdStore(distance + i, SimdAdd(SimdAdd(SimdMul(x, x), SimdMul(y, y)), SimdMul(z, z)));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		life[i] -= deltaTime;
+		vx[i] += deltaSpeed.x; vy[i] += deltaSpeed.y; vz[i] += deltaSpeed.z;
+		px[i] += vx[i] * deltaTime; py[i] += vy[i] * deltaTime; pz[i] += vz[i] * deltaTime;
+		float x = px[i] - cameraPos.x, y = py[i] - cameraPos.y, z = pz[i] - cameraPos.z;
+		distance[i] = x * x + y * y + z * z;
+	}
+}
+
+int ParticleStreams::Compact(int count)
+{
+	//every particle is copied to the write position and the position only advances past the living ones, no branch per particle
+	int write = 0;
+	int i = 0;
+#if PARTICLE_SIMD_WIDTH > 1
+	const int allAlive = (1 << PARTICLE_SIMD_WIDTH) - 1;
+	for (; i + PARTICLE_SIMD_WIDTH <= count; i += PARTICLE_SIMD_WIDTH)
+	{
+		int aliveMask = SimdAliveMask(SimdLoad(&lifeTime[i]));
+		//nothing died so far, the block is already in place
+		if (aliveMask == allAlive && write == i)
+		{
+			write += PARTICLE_SIMD_WIDTH;
+			continue;
+		}
+		for (int lane = 0; lane < PARTICLE_SIMD_WIDTH; lane++)
+		{
+			Copy(i + lane, write);
+			write += (aliveMask >> lane) & 1;
+		}
+	}
+#endif
+	for (; i < count; i++)
+	{
+		Copy(i, write);
+		write += lifeTime[i] >= 0.f;
+	}
+	return write;
+}
+
+void ParticleStreams::Pack(int count, float size, ParticleData* out) const
+{
+	for (int i = 0; i < count; i++)
+	{
+		out[i].pos = glm::vec3(posX[i], posY[i], posZ[i]);
+		out[i].size = size;
+		out[i].color = glm::vec4(colorR[i], colorG[i], colorB[i], colorA[i]);
+	}
+}
+
+void ParticleStreams::Copy(int from, int to)
+{
+	posX[to] = posX[from]; posY[to] = posY[from]; posZ[to] = posZ[from];
+	velX[to] = velX[from]; velY[to] = velY[from]; velZ[to] = velZ[from];
+	lifeTime[to] = lifeTime[from];
+	colorR[to] = colorR[from]; colorG[to] = colorG[from]; colorB[to] = colorB[from]; colorA[to] = colorA[from];
+	cameraDistance[to] = cameraDistance[from];
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "MyMathLib.h"
+#include <vector>
+
 struct ParticleData
 {
 	glm::vec3 pos;
@@ -7,12 +9,25 @@ struct ParticleData
 	glm::vec4 color;
 };
 
-struct ParticleInfo
+//structure of arrays with the simulated state of a particle system, one float stream per component
+//the kernels run over 8 (avx) or 4 (sse) particles at a time with a scalar loop for the remainder
+struct ParticleStreams
 {
-	glm::vec3 speed;
-	float angle, weight;
-	double lifeTime = -1.0;
-	double cameraDistance = -1.0;
+	std::vector<float> posX, posY, posZ;
+	std::vector<float> velX, velY, velZ;
+	std::vector<float> lifeTime;
+	std::vector<float> colorR, colorG, colorB, colorA;
+	//squared distance to the camera, refreshed by Integrate
+	std::vector<float> cameraDistance;
+
+	void Resize(int maxParticles);
+	//ages, accelerates and moves the first count particles then measures their distance to the camera
+	void Integrate(int count, float deltaTime, const glm::vec3& force, const glm::vec3& cameraPos);
+	//packs the particles that are still alive to the front keeping their order, returns how many there are
+	int Compact(int count);
+	//interleaves the first count particles into the layout uploaded to the gpu
+	void Pack(int count, float size, ParticleData* out) const;
+	void Copy(int from, int to);
 };
 
 class Particle{
@@ -20,11 +35,10 @@ public:
 	Particle();
 	~Particle();
 	ParticleData data;
-	ParticleInfo info;
+	float cameraDistance = -1.f;
 
 	bool operator<(Particle& that){
 		// Sort in reverse order : far particles drawn first.
-		return this->info.cameraDistance > that.info.cameraDistance;
+		return this->cameraDistance > that.cameraDistance;
 	}
 };
-
@@ -7,6 +7,8 @@
 #include "CameraManager.h"
 #include "Camera.h"
 #include <cstddef>
+#include <random>
+#include <cstring>
 #include "Vao.h"
 #include "GraphicsStorage.h"
 
@@ -39,6 +41,7 @@ ParticleSystem::ParticleSystem()
 	paused = false;
 	timeSinceLastEmission = 0.0;
 	vao = nullptr;
+	rng = XoshiroCpp::Xoshiro256PlusPlus(std::random_device{}());
 }
 
 ParticleSystem::ParticleSystem(int maxParticles, int emissionRate)
@@ -46,7 +49,9 @@ ParticleSystem::ParticleSystem(int maxParticles, int emissionRate)
 	LastUsedParticle = 0;
 	MaxParticles = maxParticles;
 	ParticlesData.resize(maxParticles);
-	ParticlesInfo.resize(maxParticles);
+	Particles.Resize(maxParticles);
+	sortPairs.reserve(maxParticles);
+	sortScratch.reserve(maxParticles);
 	DesiredEmissionRate = emissionRate;
 	Color = glm::vec4(1.f, 1.f, 1.f, 0.8f);
 	Size = 1.f;
@@ -59,6 +64,7 @@ ParticleSystem::ParticleSystem(int maxParticles, int emissionRate)
 	paused = false;
 	timeSinceLastEmission = 0.0;
 	EmissionRate = emissionRate;
+	rng = XoshiroCpp::Xoshiro256PlusPlus(std::random_device{}());
 	SetUp();
 }
 
@@ -68,7 +74,11 @@ ParticleSystem::~ParticleSystem()
 
 Component* ParticleSystem::Clone()
 {
-	return new ParticleSystem(*this);
+	ParticleSystem* clone = new ParticleSystem(*this);
+	clone->rng = XoshiroCpp::Xoshiro256PlusPlus(std::random_device{}());
+	clone->sortPairs.reserve(MaxParticles);
+	clone->sortScratch.reserve(MaxParticles);
+	return clone;
 }
 
 //int ParticleSystem::FindUnusedParticle()
@@ -102,47 +112,46 @@ Component* ParticleSystem::Clone()
 //	return particleWithLowestLifeTime;
 //}
 
-void ParticleSystem::UpdateParticles(double deltaTime)
+void ParticleSystem::UpdateParticles(float deltaTime, const glm::vec3& cameraPos)
 {
-	particles_data_buffer->activeCount = 0;
-	int newTotalParticleCount = std::min(LastParticleIndex + NewParticles, MaxParticles-1); //improve formula for when fps is faster than emission rate
-	LastParticleIndex = 0;
-	DeadParticles = 0;
-	ReallyAliveParticles = 0;
-	int newparticles = NewParticles;
-	for (int i = 0; i < newTotalParticleCount; i++){
-
-		ParticleInfo& p = ParticlesInfo[i]; 
-
-		if (p.lifeTime < 0.0)
-		{
-			if (newparticles > 0)
-			{
-				NewParticle(i);
-				//particles_data_buffer->SetElementData(particles_data_buffer->activeCount, &ParticlesData[i]);
-				//particles_data_buffer->IncreaseInstanceCount();
-				newparticles--;
-				LastParticleIndex = i;
-				ReallyAliveParticles++;
-			}
-			else
-			{
-				p.cameraDistance = -1.0;
-				DeadParticles++;
-			}
-		}
-		else{
-			UpdateParticle(i);
-			//particles_data_buffer->SetElementData(particles_data_buffer->activeCount, &ParticlesData[i]);
-			//particles_data_buffer->IncreaseInstanceCount();
-			LastParticleIndex = i;
-			ReallyAliveParticles++;
-		}
+	Particles.Integrate(ReallyAliveParticles, deltaTime, Force, cameraPos);
+	int aliveParticles = Particles.Compact(ReallyAliveParticles);
+	DeadParticles = ReallyAliveParticles - aliveParticles;
+	ReallyAliveParticles = aliveParticles;
+
+	//new particles are appended behind the survivors and start moving next frame
+	int newParticles = std::min(NewParticles, MaxParticles - ReallyAliveParticles);
+	glm::vec3 origin = object->node->GetWorldPosition();
+	for (int i = 0; i < newParticles; i++)
+	{
+		NewParticle(ReallyAliveParticles++, origin, cameraPos);
 	}
+	LastParticleIndex = ReallyAliveParticles - 1;
 }
 
-void ParticleSystem::SortParticles(){
-	//std::sort(&ParticlesData[0], &ParticlesData[LastParticleIndex]);
+void ParticleSystem::SortParticles()
+{
+	//distances are never negative so their bits order like the floats, inverted they put the far particles first
+	//the top 24 bits keep the exponent and 15 bits of mantissa, that is three radix passes, the empty high bytes are skipped
+	sortPairs.resize(ReallyAliveParticles);
+	const float* cameraDistance = Particles.cameraDistance.data();
+	for (int i = 0; i < ReallyAliveParticles; i++)
+	{
+		uint32_t bits;
+		memcpy(&bits, &cameraDistance[i], sizeof(bits));
+		sortPairs[i].key = (~bits >> 8) & 0xFFFFFF;
+		sortPairs[i].value = (uint32_t)i;
+	}
+	RadixSort::Sort(sortPairs, sortScratch);
+
+	for (int i = 0; i < ReallyAliveParticles; i++)
+	{
+		uint32_t index = sortPairs[i].value;
+		ParticleData& particleData = ParticlesData[i];
+		particleData.pos = glm::vec3(Particles.posX[index], Particles.posY[index], Particles.posZ[index]);
+		particleData.size = Size;
+		particleData.color = glm::vec4(Particles.colorR[index], Particles.colorG[index], Particles.colorB[index], Particles.colorA[index]);
+	}
 }
 
 //VAO
@@ -162,11 +171,12 @@ void ParticleSystem::SetUp()
 //VAO
 void ParticleSystem::UpdateBuffers()
 {
-	particles_data_buffer->Resize(ReallyAliveParticles + 1);
-	particles_data_buffer->activeCount = ReallyAliveParticles + 1;
-	particles_data_buffer->SetData(0, &ParticlesData[0], particles_data_buffer->layout.GetStride() * ReallyAliveParticles + 1);
+	//the buffer is shared by every particle system so it is refilled and uploaded right before each draw
+	particles_data_buffer->Resize(std::max(ReallyAliveParticles, 1));
+	particles_data_buffer->activeCount = ReallyAliveParticles;
+	if (ReallyAliveParticles > 0) particles_data_buffer->SetData(0, ParticlesData.data(), particles_data_buffer->layout.GetStride() * ReallyAliveParticles);
 	if (vao != nullptr) vao->activeCount = particles_data_buffer->activeCount;
-	//particles_data_buffer->Update();
+	particles_data_buffer->Update();
 }
 
 int ParticleSystem::Draw()
@@ -213,7 +223,7 @@ void ParticleSystem::SetAdditive(bool isAdditiveMode)
 
 int ParticleSystem::GetAliveParticlesCount()
 {
-	return vao->activeCount;
+	return ReallyAliveParticles;
 }
 
 int ParticleSystem::GetNewParticlesCount()
@@ -226,7 +236,10 @@ void ParticleSystem::SetMaxParticles(int maxParticles)
 	MaxParticles = std::max(maxParticles, 0);
 	LastUsedParticle = std::clamp(LastUsedParticle, 0, std::max(MaxParticles - 1, 0));
 	ParticlesData.resize(MaxParticles);
-	ParticlesInfo.resize(MaxParticles);
+	Particles.Resize(MaxParticles);
+	sortPairs.reserve(MaxParticles);
+	sortScratch.reserve(MaxParticles);
+	ReallyAliveParticles = std::min(ReallyAliveParticles, MaxParticles);
 	EmissionRate = LifeTime <= 0 ? 0 : std::min(DesiredEmissionRate, (int)(MaxParticles / LifeTime));
 	if (vao != nullptr && vao->vbos.size() > 0 && MaxParticles > 0)
 	{
@@ -257,59 +270,54 @@ void ParticleSystem::Update()
 		if (MaxParticles > 0)
 		{
 			//calculate nr of new particles
-			CalculateNewEmitedParticles(Times::Instance()->deltaTime);
-			UpdateParticles(Times::Instance()->deltaTime);
-			UpdateBuffers();
-			//if (!additive) SortParticles();
+			double deltaTime = Times::Instance()->deltaTime;
+			CalculateNewEmitedParticles(deltaTime);
+			UpdateParticles((float)deltaTime, CameraManager::Instance()->cameraPos);
+			//additive blending does not depend on the order
+			if (additive) Particles.Pack(ReallyAliveParticles, Size, ParticlesData.data());
+			else SortParticles();
 		}
 		else
 		{
-			vao->activeCount = 0;
+			ReallyAliveParticles = 0;
 		}
 	}
 }
 
-inline void ParticleSystem::NewParticle(int index)
+bool ParticleSystem::IsThreadSafe()
+{
+	return true;
+}
+
+inline void ParticleSystem::NewParticle(int index, const glm::vec3& origin, const glm::vec3& cameraPos)
 {
-	ParticleData& particleData = ParticlesData[ReallyAliveParticles];
-	ParticleInfo& particleInfo = ParticlesInfo[ReallyAliveParticles];
-	particleInfo.lifeTime = LifeTime;
-	particleData.pos = object->node->GetWorldPosition();
+	Particles.lifeTime[index] = LifeTime;
+	Particles.posX[index] = origin.x;
+	Particles.posY[index] = origin.y;
+	Particles.posZ[index] = origin.z;
 
 	// Very bad way to generate a random direction; 
 	// See for instance http://stackoverflow.com/questions/5408276/python-uniform-spherical-distribution instead,
 	// combined with some user-controlled parameters (main direction, spread, etc)
-	particleInfo.speed = Direction + glm::vec3((rand() % 2000 - 1000.0f) / 1000.0f, (rand() % 2000 - 1000.0f) / 1000.0f, (rand() % 2000 - 1000.0f) / 1000.0f) * Spread;
-	particleData.color = glm::vec4((rand() % 255) / 255.0f, (rand() % 255) / 255.0f, (rand() % 255) / 255.0f, 1.0);
-	particleData.size = Size;//(float)((rand() % 1000) / 2000.0f + 0.1f);
-	glm::vec3 cameraToParticle = particleData.pos - CameraManager::Instance()->cameraPos;
-	particleInfo.cameraDistance = glm::dot(cameraToParticle, cameraToParticle);
+	Particles.velX[index] = Direction.x + RandomSigned() * Spread;
+	Particles.velY[index] = Direction.y + RandomSigned() * Spread;
+	Particles.velZ[index] = Direction.z + RandomSigned() * Spread;
+	Particles.colorR[index] = RandomUnsigned();
+	Particles.colorG[index] = RandomUnsigned();
+	Particles.colorB[index] = RandomUnsigned();
+	Particles.colorA[index] = 1.f;
+	glm::vec3 cameraToParticle = origin - cameraPos;
+	Particles.cameraDistance[index] = glm::dot(cameraToParticle, cameraToParticle);
 }
 
-inline void ParticleSystem::UpdateParticle(int index)
+inline float ParticleSystem::RandomSigned()
 {
-	ParticleData& particleData = ParticlesData[index];
-	ParticleInfo& particleInfo = ParticlesInfo[index];
-
-	particleInfo.lifeTime -= Times::Instance()->deltaTime;
+	return RandomUnsigned() * 2.f - 1.f;
+}
 
-	// Simulate simple physics : gravity only, no collisions 
-	particleInfo.speed += Force * (float)Times::Instance()->deltaTime * 0.5f;
-	particleData.pos += particleInfo.speed * (float)Times::Instance()->deltaTime;
-	glm::vec3 cameraToParticle = particleData.pos - CameraManager::Instance()->cameraPos;
-	particleInfo.cameraDistance = glm::dot(cameraToParticle, cameraToParticle);
-	if (index != ReallyAliveParticles)
-	{
-		ParticleData& reallyAliveParticle = ParticlesData[ReallyAliveParticles];
-		ParticleInfo& reallyAliveParticleInfo = ParticlesInfo[ReallyAliveParticles];
-		reallyAliveParticle = particleData;
-		reallyAliveParticleInfo = particleInfo;
-		particleInfo.lifeTime = -1.f;
-	}
-	
-	//p.size -= (float)deltaTime*3.5f;
-	//if (p.size < 0.f) p.size = 0.f; p.lifeTime = 0.f;
-	// Fill the GPU buffer
+inline float ParticleSystem::RandomUnsigned()
+{
+	return XoshiroCpp::FloatFromBits((uint32_t)(rng() >> 32));
 }
 
 inline void ParticleSystem::CalculateNewEmitedParticles(double deltaTime)
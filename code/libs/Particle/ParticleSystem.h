@@ -1,12 +1,12 @@
 #pragma once
 #include "MyMathLib.h"
 #include "Component.h"
+#include "Particle.h"
+#include "XoshiroCpp.hpp"
+#include "RadixSort.h"
 #include <vector>
 
-class Particle;
 class Material;
-struct ParticleData;
-struct ParticleInfo;
 class VertexBufferDynamic;
 class LocationLayout;
 class VertexArray;
@@ -19,10 +19,12 @@ public:
 	ParticleSystem(int maxParticles, int emissionRate);
 	~ParticleSystem();
 	Component* Clone();
+	//interleaved copy of the alive particles that UpdateBuffers uploads
 	std::vector<ParticleData> ParticlesData;
-	std::vector<ParticleInfo> ParticlesInfo;
+	ParticleStreams Particles;
 	//int FindUnusedParticle();
-	void UpdateParticles(double deltaTime);
+	void UpdateParticles(float deltaTime, const glm::vec3& cameraPos);
+	//writes the alive particles back to front into ParticlesData, for alpha blended systems
 	void SortParticles();
 	void UpdateBuffers();
 	int Draw();
@@ -39,10 +41,11 @@ public:
 	int GetAliveParticlesCount();
 	int GetNewParticlesCount();
 	void Update();
+	//simulation only touches the system's own particles, the shared gpu buffer is filled in Draw
+	bool IsThreadSafe();
 	static const glm::vec3 g_vertex_buffer_data[4];
 	static const unsigned char elements[6];
-	inline void NewParticle(int index);
-	inline void UpdateParticle(int index);
+	inline void NewParticle(int index, const glm::vec3& origin, const glm::vec3& cameraPos);
 	inline void CalculateNewEmitedParticles(double deltaTime);
 
 	VertexBufferDynamic* particles_data_buffer;
@@ -74,5 +77,14 @@ protected:
 private:
 	int LastUsedParticle;
 	double timeSinceLastEmission;
+	//each system draws from its own generator so systems can emit from different threads
+	XoshiroCpp::Xoshiro256PlusPlus rng;
+	//uniform in [-1, 1)
+	inline float RandomSigned();
+	//uniform in [0, 1)
+	inline float RandomUnsigned();
+	//reused by SortParticles, reserved for MaxParticles so sorting does not allocate per frame
+	std::vector<SortPair> sortPairs;
+	std::vector<SortPair> sortScratch;
 };
 
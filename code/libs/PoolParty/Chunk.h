@@ -1,21 +1,81 @@
 #pragma once
-#include <stdlib.h> 
+#include <stdlib.h>
+#include <stdint.h>
+#include <iterator>
+#include <vector>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//chunks this large or larger are aligned to a huge page so the os can back them with one
+static const size_t hugePageSize = 2 * 1024 * 1024;
+static const size_t cacheLineSize = 64;
 
 template <typename T, int length>
 class Chunk
 {
 public:
-	Chunk(){}
-	~Chunk(){}
-	
-	char data[length*sizeof(T)];
+	Chunk(int elementCount = length)
+	{
+		element_count = elementCount;
+		chunk_size = element_count * element_size;
+		alignment = (size_t)chunk_size >= hugePageSize ? hugePageSize : (alignof(T) > cacheLineSize ? alignof(T) : cacheLineSize);
+		//aligned_alloc wants the size to be a multiple of the alignment
+		size_t allocationSize = ((size_t)chunk_size + alignment - 1) & ~(alignment - 1);
+#ifdef _WIN32
+		data = (char*)_aligned_malloc(allocationSize, alignment);
+#else
+		data = (char*)aligned_alloc(alignment, allocationSize);
+#endif
+		liveBits.resize((element_count + 63) / 64, 0);
+	}
+	~Chunk()
+	{
+#ifdef _WIN32
+		_aligned_free(data);
+#else
+		free(data);
+#endif
+	}
+
+	char* data;
 	Chunk<T,length>* next = nullptr;
-	
+	//one bit per slot, set while the slot holds an allocated element
+	std::vector<uint64_t> liveBits;
+
 	int GetCurrentLength() { return current_free_index; }
+	T* GetElement(int slot) { return (T*)&data[slot * element_size]; }
+	int GetSlot(const T* element) { return (int)(((const char*)element - data) / element_size); }
+	bool Contains(const T* element) { return (const char*)element >= data && (const char*)element < data + chunk_size; }
+	bool IsAlive(int slot) { return (liveBits[slot >> 6] >> (slot & 63)) & 1; }
+	void SetAlive(int slot) { liveBits[slot >> 6] |= (uint64_t)1 << (slot & 63); }
+	void SetDead(int slot) { liveBits[slot >> 6] &= ~((uint64_t)1 << (slot & 63)); }
+
+	//first live slot at or after slot, current_free_index when there is none
+	int NextAlive(int slot)
+	{
+		while (slot < current_free_index)
+		{
+			uint64_t word = liveBits[slot >> 6] >> (slot & 63);
+			if (word != 0)
+			{
+				slot += CountTrailingZeros(word);
+				return slot < current_free_index ? slot : current_free_index;
+			}
+			slot = (slot & ~63) + 64;
+		}
+		return current_free_index;
+	}
+
+	//slots in use, every slot below it holds a constructed element, live or freed
 	int current_free_index = 0;
 	int element_count = length;
 	int element_size = sizeof(T);
 	int chunk_size = length * element_size;
+	size_t alignment;
 
     struct Iterator
     {
@@ -25,21 +85,36 @@ public:
         using pointer = T*;
         using reference = T&;
 
-        Iterator(pointer ptr) : m_ptr(ptr) {}
+        Iterator(Chunk<T, length>* chunk, int slot) : m_chunk(chunk), m_slot(chunk->NextAlive(slot)) {}
 
-        reference operator*() const { return *m_ptr; }
-        pointer operator->() { return m_ptr; }
-        Iterator& operator++() { m_ptr++; return *this; }
+        reference operator*() const { return *m_chunk->GetElement(m_slot); }
+        pointer operator->() { return m_chunk->GetElement(m_slot); }
+        Iterator& operator++() { m_slot = m_chunk->NextAlive(m_slot + 1); return *this; }
         Iterator operator++(int) { Iterator tmp = *this; ++(*this); return tmp; }
-        friend bool operator== (const Iterator& a, const Iterator& b) { return a.m_ptr == b.m_ptr; };
-        friend bool operator!= (const Iterator& a, const Iterator& b) { return a.m_ptr != b.m_ptr; };
+        friend bool operator== (const Iterator& a, const Iterator& b) { return a.m_slot == b.m_slot && a.m_chunk == b.m_chunk; };
+        friend bool operator!= (const Iterator& a, const Iterator& b) { return a.m_slot != b.m_slot || a.m_chunk != b.m_chunk; };
 
     private:
-        pointer m_ptr;
+        Chunk<T, length>* m_chunk;
+        int m_slot;
     };
 
-    Iterator begin() { return Iterator((T*)(&data[0])); }
-    Iterator end() { return Iterator((T*)(&data[current_free_index])); }
+    Iterator begin() { return Iterator(this, 0); }
+    Iterator end() { return Iterator(this, current_free_index); }
 private:
-	//Chunk();
+	//copy
+	Chunk(const Chunk&);
+	//assign
+	Chunk& operator=(const Chunk&);
+
+	static int CountTrailingZeros(uint64_t word)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, word);
+		return (int)index;
+#else
+		return __builtin_ctzll(word);
+#endif
+	}
 };
@@ -1,5 +1,9 @@
 #pragma once
-#include <stdlib.h> 
+#include <stdlib.h>
+#include <limits.h>
+#include <map>
+#include <unordered_map>
+#include <utility>
 #include "Chunk.h"
 
 template <typename T, int chunk_length = 1000>
@@ -7,7 +11,7 @@ class PoolParty
 {
 typedef Chunk<T, chunk_length> C;
 public:
-	PoolParty() { init_number_of_chunks = 0; current_number_of_chunks = 0; first_chunk = nullptr; current_free_chunk = nullptr; nr_of_elements = 0; }
+	PoolParty() { init_number_of_chunks = 0; current_number_of_chunks = 0; first_chunk = nullptr; current_free_chunk = nullptr; last_chunk = nullptr; nr_of_elements = 0; SetMaxChunkLength((int)(hugePageSize / sizeof(T))); }
 
 	~PoolParty()
 	{
@@ -15,9 +19,9 @@ public:
 		for (int i = 0; i < current_number_of_chunks; i++)
 		{
 			C* nextChunk = curChunk->next;
-			for (int i = 0; i < curChunk->current_free_index; i+=sizeOfT)
+			for (int i = 0; i < curChunk->current_free_index; i++)
 			{
-				((T*)&curChunk->data[i])->~T();
+				curChunk->GetElement(i)->~T();
 			}
 			delete curChunk;
 			curChunk = nextChunk;
@@ -27,63 +31,167 @@ public:
 
 	C* GetFirstChunk() { return first_chunk; }
 	C* GetLastChunk() { return current_free_chunk; }
-	
+
 	void CreatePoolParty(int num_of_chunks = 100)
 	{
-		C* previous_chunk = new C;
-		first_chunk = previous_chunk;
-		current_free_chunk = previous_chunk;
 		init_number_of_chunks = num_of_chunks;
-		current_number_of_chunks = init_number_of_chunks;
-		for(int i = 1; i < init_number_of_chunks; i++)
+		for(int i = 0; i < init_number_of_chunks; i++)
+		{
+			AddChunk(chunk_length);
+		}
+		current_free_chunk = first_chunk;
+	}
+
+	//chunks appended after the preallocated ones double in length up to this many elements
+	//the default grows them until they span a huge page, set it to chunk_length to keep every chunk the same size
+	void SetMaxChunkLength(int max_length)
+	{
+		max_chunk_length = max_length > chunk_length ? max_length : chunk_length;
+	}
+
+	//preallocates chunks until the pool can hold count elements without allocating
+	void Reserve(int count)
+	{
+		while (count > 0 && GetCapacity() < (unsigned int)count)
 		{
-			C* next_chunk = new C;
-			previous_chunk->next = next_chunk;
-			previous_chunk = next_chunk;
+			AddChunk(NextChunkLength(last_chunk != nullptr ? last_chunk->element_count : chunk_length / 2, count));
 		}
+		if (current_free_chunk == nullptr) current_free_chunk = first_chunk;
 	}
 
 	template<typename... ArgTypes>
 	T* Alloc(ArgTypes... args)
 	{
+		if (first_chunk == nullptr) CreatePoolParty(1);
 		T* element = nullptr;
 		if (unusedObjects.size() > 0){
-			element = unusedObjects.back();
+			FreeSlot freeSlot = unusedObjects.back();
 			unusedObjects.pop_back();
+			element = freeSlot.chunk->GetElement(freeSlot.slot);
 			element->~T(); //because of dynamic allocations in the assets we have to call their destructors
 			new(element) T{ std::forward<ArgTypes>(args)... };
+			freeSlot.chunk->SetAlive(freeSlot.slot);
 			//*element = std::move(T{ std::forward<ArgTypes>(args)... });
 		}
-		else if(current_free_chunk->current_free_index < current_free_chunk->chunk_size){
-			element = (T*)&current_free_chunk->data[current_free_chunk->current_free_index];
-			current_free_chunk->current_free_index += sizeOfT;
-			new(element) T{ std::forward<ArgTypes>(args)... };
-		}
-		else if(current_free_chunk->next != nullptr){
-			current_free_chunk = current_free_chunk->next;
-			element = (T*)&current_free_chunk->data[current_free_chunk->current_free_index];
-			current_free_chunk->current_free_index += sizeOfT;
-			new(element) T{ std::forward<ArgTypes>(args)... };
-		}
 		else{
-			C* next_chunk = new C;
-			current_free_chunk->next = next_chunk;
-			current_free_chunk = next_chunk;
-			current_number_of_chunks++;
-			element = (T*)&current_free_chunk->data[current_free_chunk->current_free_index];
-			current_free_chunk->current_free_index += sizeOfT;
+			if (current_free_chunk->current_free_index >= current_free_chunk->element_count)
+			{
+				if (current_free_chunk->next == nullptr) AddChunk(NextChunkLength(current_free_chunk->element_count, 0));
+				current_free_chunk = current_free_chunk->next;
+			}
+			int slot = current_free_chunk->current_free_index++;
+			element = current_free_chunk->GetElement(slot);
 			new(element) T{ std::forward<ArgTypes>(args)... };
+			current_free_chunk->SetAlive(slot);
 		}
 		nr_of_elements++;
 		return element;
 	}
 
+	//the element stays constructed until its slot is reused or compacted away, iteration skips it
 	void Dealloc(T* element)
 	{
-		unusedObjects.push_back(element);
+		C* chunk = FindChunk(element);
+		if (chunk == nullptr) return;
+		int slot = chunk->GetSlot(element);
+		if (!chunk->IsAlive(slot)) return;
+		chunk->SetDead(slot);
+		unusedObjects.push_back({ chunk, slot });
 		nr_of_elements--;
 	}
 
+	//moves live elements from the back into freed slots at the front so they are contiguous again
+	//destroys the freed elements and releases empty chunks past the ones created by CreatePoolParty
+	//returns old to new address of every moved element, pointers to them held elsewhere have to be patched with it
+	std::unordered_map<T*, T*> Compact()
+	{
+		std::unordered_map<T*, T*> remap;
+		if (first_chunk == nullptr) return remap;
+
+		std::vector<C*> chunks;
+		for (C* chunk = first_chunk; chunk != current_free_chunk->next; chunk = chunk->next) chunks.push_back(chunk);
+
+		//position of the first slot past the live elements once they are packed
+		size_t boundaryChunk = 0;
+		int boundarySlot = nr_of_elements;
+		while (boundaryChunk + 1 < chunks.size() && boundarySlot >= chunks[boundaryChunk]->element_count)
+		{
+			boundarySlot -= chunks[boundaryChunk]->element_count;
+			boundaryChunk++;
+		}
+
+		//freed slots in front of the boundary and live slots behind it come in equal numbers
+		size_t holeChunk = 0;
+		int holeSlot = 0;
+		size_t liveChunk = boundaryChunk;
+		int liveSlot = boundarySlot;
+		while (true)
+		{
+			while (holeChunk < boundaryChunk || (holeChunk == boundaryChunk && holeSlot < boundarySlot))
+			{
+				if (holeSlot >= chunks[holeChunk]->element_count) { holeChunk++; holeSlot = 0; continue; }
+				if (!chunks[holeChunk]->IsAlive(holeSlot)) break;
+				holeSlot++;
+			}
+			if (holeChunk > boundaryChunk || (holeChunk == boundaryChunk && holeSlot >= boundarySlot)) break;
+			while (liveChunk < chunks.size())
+			{
+				liveSlot = chunks[liveChunk]->NextAlive(liveSlot);
+				if (liveSlot < chunks[liveChunk]->current_free_index) break;
+				liveChunk++;
+				liveSlot = 0;
+			}
+
+			T* hole = chunks[holeChunk]->GetElement(holeSlot);
+			T* live = chunks[liveChunk]->GetElement(liveSlot);
+			hole->~T();
+			new(hole) T(std::move(*live));
+			chunks[holeChunk]->SetAlive(holeSlot);
+			chunks[liveChunk]->SetDead(liveSlot);
+			remap[live] = hole;
+			holeSlot++;
+			liveSlot++;
+		}
+
+		//everything behind the boundary is freed or moved from
+		for (size_t i = boundaryChunk; i < chunks.size(); i++)
+		{
+			int firstSlot = i == boundaryChunk ? boundarySlot : 0;
+			for (int slot = firstSlot; slot < chunks[i]->current_free_index; slot++)
+			{
+				chunks[i]->GetElement(slot)->~T();
+				chunks[i]->SetDead(slot);
+			}
+			chunks[i]->current_free_index = firstSlot;
+		}
+		current_free_chunk = chunks[boundaryChunk];
+		unusedObjects.clear();
+
+		int keptChunks = (int)boundaryChunk + 1;
+		C* previous = current_free_chunk;
+		C* chunk = current_free_chunk->next;
+		while (chunk != nullptr)
+		{
+			C* nextChunk = chunk->next;
+			if (keptChunks < init_number_of_chunks)
+			{
+				keptChunks++;
+				previous = chunk;
+			}
+			else
+			{
+				chunksByAddress.erase(chunk->data);
+				previous->next = nextChunk;
+				capacity -= chunk->element_count;
+				delete chunk;
+				current_number_of_chunks--;
+			}
+			chunk = nextChunk;
+		}
+		last_chunk = previous;
+		return remap;
+	}
+
 	struct iterator
 	{
 		using iterator_category = std::forward_iterator_tag;
@@ -92,34 +200,19 @@ public:
 		using pointer = C*;
 		using reference = T&;
 
-		iterator(pointer ptr, Chunk<T, chunk_length>::Iterator chunkIterator, pointer lastChunk) : m_ptr(ptr), m_chunkIterator(chunkIterator), m_lastChunk(lastChunk) {}
+		iterator(pointer ptr, typename C::Iterator chunkIterator, pointer lastChunk) : m_ptr(ptr), m_chunkIterator(chunkIterator), m_lastChunk(lastChunk) { SkipEmptyChunks(); }
 
 		reference operator*() const { return *m_chunkIterator; }
-		pointer operator->() { return m_chunkIterator; }
+		T* operator->() { return &*m_chunkIterator; }
 		iterator& operator++() {
 			m_chunkIterator++;
-			if (m_chunkIterator == m_ptr->end())
-			{
-				if (m_lastChunk != m_ptr)
-				{
-					m_ptr = m_ptr->next;
-					m_chunkIterator = m_ptr->begin();
-				}
-			}
+			SkipEmptyChunks();
 			return *this;
 		}
 		iterator operator++(int) {
 			iterator tmp = *this;
-			m_chunkIterator++;
-			if (m_chunkIterator == m_ptr->end())
-			{
-				if (m_lastChunk != m_ptr)
-				{
-					m_ptr = m_ptr->next;
-					m_chunkIterator = m_ptr->begin();
-				}
-			}
-			return tmp; 
+			++(*this);
+			return tmp;
 		}
 		friend bool operator== (const iterator& a, const iterator& b) {
 			return a.m_chunkIterator == b.m_chunkIterator;
@@ -129,26 +222,81 @@ public:
 		};
 
 	private:
+		//moves on to the next chunk with a live element, stops at the end of the last one
+		void SkipEmptyChunks()
+		{
+			while (m_chunkIterator == m_ptr->end() && m_lastChunk != m_ptr)
+			{
+				m_ptr = m_ptr->next;
+				m_chunkIterator = m_ptr->begin();
+			}
+		}
+
 		pointer m_ptr;
-		Chunk<T,chunk_length>::Iterator m_chunkIterator;
+		typename C::Iterator m_chunkIterator;
 		pointer m_lastChunk;
 	};
 
 	iterator begin() { return iterator(first_chunk, first_chunk->begin(), current_free_chunk); }
 	iterator end() { return iterator(current_free_chunk, current_free_chunk->end(), current_free_chunk); }
 
-	unsigned int GetCapacity() { return current_number_of_chunks * chunk_length; }
+	unsigned int GetCapacity() { return capacity; }
 	int GetCount() { return nr_of_elements; }
 private:
+	struct FreeSlot
+	{
+		C* chunk;
+		int slot;
+	};
+
+	void AddChunk(int length)
+	{
+		C* chunk = new C(length);
+		if (first_chunk == nullptr) first_chunk = chunk;
+		else last_chunk->next = chunk;
+		last_chunk = chunk;
+		chunksByAddress[chunk->data] = chunk;
+		current_number_of_chunks++;
+		capacity += length;
+	}
+
+	//double the previous chunk up to the max length, or enough to reach the requested capacity in one chunk
+	//worked out in size_t and clamped so the byte size of a chunk still fits the int offsets it uses, Reserve adds more chunks past that
+	int NextChunkLength(int previousLength, int requestedCapacity)
+	{
+		size_t length = (size_t)previousLength * 2;
+		if (length > (size_t)max_chunk_length) length = max_chunk_length;
+		size_t currentCapacity = GetCapacity();
+		if (requestedCapacity > 0 && (size_t)requestedCapacity > currentCapacity + length) length = (size_t)requestedCapacity - currentCapacity;
+		if (length < (size_t)chunk_length) length = chunk_length;
+		if (length > chunkLengthLimit) length = chunkLengthLimit;
+		return (int)length;
+	}
+
+	static const size_t chunkLengthLimit = INT_MAX / sizeof(T);
+
+	C* FindChunk(const T* element)
+	{
+		auto res = chunksByAddress.upper_bound((const char*)element);
+		if (res == chunksByAddress.begin()) return nullptr;
+		--res;
+		return res->second->Contains(element) ? res->second : nullptr;
+	}
+
 	C* current_free_chunk;
+	C* last_chunk;
 	int init_number_of_chunks;
 	int current_number_of_chunks;
 	int nr_of_elements;
+	int max_chunk_length;
+	unsigned int capacity = 0;
 	C* first_chunk;
-	std::vector<T*> unusedObjects;
+	std::vector<FreeSlot> unusedObjects;
+	//chunk lookup for freed elements, keyed by the start of the chunk storage
+	std::map<const char*, C*> chunksByAddress;
 	int sizeOfT = sizeof(T);
 	bool destroyed = false;
 };
 
 //to work around fragmentation we can store iteration ranges whenever there are holes
-//then when we move from one range to another and keep iterating
\ No newline at end of file
+//then when we move from one range to another and keep iterating
@@ -9,6 +9,8 @@ public:
 	~RenderElement();
 	virtual void Execute() = 0;
 	std::string name;
+	//small id handed out by the renderer the first time the element is seen, packed into render list sort keys
+	unsigned int sortId = 0;
 private:
 
 };
\ No newline at end of file
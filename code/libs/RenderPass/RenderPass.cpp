@@ -8,6 +8,8 @@ RenderPass::RenderPass()
 {
 	fbo = nullptr;
 	script = new Script();
+	//pass and profile scripts run while gameplay scripts may be mid call, so they stay out of the shared state
+	script->ownState = true;
 	registryPtr = &registry;
 }
 
@@ -15,6 +15,11 @@ public:
 	~RenderPass();
 	void SetUp();
 	Frustum frustum;
+	//visibility per object ID from the scene bounds tree, shared by all passes with the same frustum planes
+	const std::vector<unsigned char>* visibleObjects = nullptr;
+	//position in the rendering queue, only valid when queueStamp matches the renderer's current graph stamp
+	unsigned int queueIndex = 0;
+	unsigned int queueStamp = 0;
 	Matrix4* vp;
 	void SetFrameBuffer(FrameBuffer* newFbo);
 	FrameBuffer* fbo;
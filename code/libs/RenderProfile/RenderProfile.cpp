@@ -4,6 +4,7 @@
 RenderProfile::RenderProfile()
 {
 	script = new Script();
+	script->ownState = true;
 }
 
 RenderProfile::~RenderProfile()
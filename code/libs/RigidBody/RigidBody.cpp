@@ -22,6 +22,7 @@ RigidBody::RigidBody()
 	isAwake = true;
 	isKinematic = false;
 	restitution = 0.0;
+	friction = 0.5;
 	motion = 1.0; //make sure it does not sleep directly at start of simulation
 	canSleep = true;
 	sleepEpsilon = 0.2;
@@ -356,7 +357,11 @@ void RigidBody::UpdateKineticEnergyStoreAndPutToSleep(float timestep)
 		double bias = pow(0.5, timestep);
 		motion = bias*motion + (1.0 - bias)*currentMotion;
 
-		if (motion < sleepEpsilon) SetAwake(false);
+		if (motion < sleepEpsilon)
+		{
+			//with island sleeping the physics manager puts the whole island to sleep at once
+			if (!PhysicsManager::Instance()->useIslandSleeping) SetAwake(false);
+		}
 		else if (motion > 10.0 * sleepEpsilon) motion = 10.0 * sleepEpsilon;
 	//}
 }
@@ -390,6 +395,21 @@ void RigidBody::SetCanSleep(const bool canSleep)
 	if (!canSleep && !isAwake) SetAwake();
 }
 
+bool RigidBody::GetCanSleep()
+{
+	return canSleep;
+}
+
+bool RigidBody::IsResting()
+{
+	return motion < sleepEpsilon;
+}
+
+bool RigidBody::IsThreadSafe()
+{
+	return true;
+}
+
 void RigidBody::Update()
 {
 	if (!isAwake || isKinematic) return;
@@ -13,6 +13,8 @@ public:
 	
 	void SetAwake(const bool awake = true);
 	void SetCanSleep(const bool canSleep);
+	bool GetCanSleep();
+	bool IsResting();
 	void AttractTowardsWithPID(float Kp, float Ki, float Kd, const glm::vec3& target);
 	void ApplyImpulse(const glm::vec3& force, const glm::vec3& target);
 	void ApplyImpulse(const glm::vec3& direction, float magnitude, const glm::vec3& target);
@@ -21,6 +23,7 @@ public:
 	void SetMass(double mass);
 	Component* Clone();
 	void Update();
+	bool IsThreadSafe();
 	double mass;
 	double massInverse;
 	double linearDamping;
@@ -42,6 +45,7 @@ public:
 	glm::mat3 inverse_inertia_tensor_world;
 	
 	double restitution;
+	double friction;
 	void SetIsKinematic(bool kinematic);
 	bool GetIsKinematic();
 private:
@@ -8,10 +8,23 @@ extern "C" {
 //#include "include/luaconf.h"
 }
 #include "LuaTools.h"
+#include <stdio.h>
+
+bool Script::shareState = true;
+lua_State* Script::sharedState = nullptr;
+int Script::envMetatableRef = LUA_NOREF;
+std::unordered_map<std::string, Script::Chunk*>* Script::chunks = nullptr;
+int Script::sharedCallDepth = 0;
+std::vector<std::function<void()>> Script::deferred;
 
 Script::Script()
 {
 	L = nullptr;
+	envRef = LUA_NOREF;
+	initRef = LUA_NOREF;
+	runRef = LUA_NOREF;
+	chunk = nullptr;
+	ownState = false;
 	//L = luaL_newstate();
 
 	//luaL_openlibs(L);
@@ -20,16 +33,39 @@ Script::Script()
 Script::Script(const char* filename)
 {
 	L = nullptr;
+	envRef = LUA_NOREF;
+	initRef = LUA_NOREF;
+	runRef = LUA_NOREF;
+	chunk = nullptr;
+	ownState = false;
 	LoadLuaFile(filename);
 }
 
 Script::~Script()
 {
-	if (L != nullptr) lua_close(L);
+	Unload();
+}
+
+//the shared state and chunk cache live until the process exits, pooled scripts may be destroyed after every other static
+lua_State* Script::GetSharedState()
+{
+	if (sharedState == nullptr)
+	{
+		sharedState = luaL_newstate();
+		luaL_openlibs(sharedState);
+
+		lua_newtable(sharedState);
+		lua_pushvalue(sharedState, LUA_GLOBALSINDEX);
+		lua_setfield(sharedState, -2, "__index");
+		envMetatableRef = luaL_ref(sharedState, LUA_REGISTRYINDEX);
+		chunks = new std::unordered_map<std::string, Chunk*>();
+	}
+	return sharedState;
 }
 
 void Script::LoadLuaFile(const char * path)
 {
+	if (Reentered(L, path) || (shareState && !ownState && Reentered(sharedState, path))) return;
 	Unload();
 	this->path = path;
 	this->name = path;
@@ -45,18 +81,40 @@ void Script::LoadLuaFile(const char * path)
 		this->name.erase(period_idx);
 	}
 
-	L = luaL_newstate();
+	if (shareState && !ownState)
+	{
+		L = GetSharedState();
+		chunk = AcquireChunk(L, this->path);
+		if (chunk != nullptr)
+		{
+			//running the chunk in a fresh environment defines this script's functions and globals there
+			lua_rawgeti(L, LUA_REGISTRYINDEX, chunk->ref);
+			lua_newtable(L);
+			lua_rawgeti(L, LUA_REGISTRYINDEX, envMetatableRef);
+			lua_setmetatable(L, -2);
+			lua_pushvalue(L, -1);
+			envRef = luaL_ref(L, LUA_REGISTRYINDEX);
+			lua_setfenv(L, -2);
+			DoCall(0, 1);
+		}
+	}
+	else
+	{
+		L = luaL_newstate();
 
-	luaL_openlibs(L);
+		luaL_openlibs(L);
 
-	LuaTools::dofile(L, path);
+		LuaTools::dofile(L, path);
+	}
+	initRef = RefFunction("init");
+	runRef = RefFunction("run");
 }
 
 bool Script::GetFunction(const char* functionName)
 {
 	if (L != nullptr)
 	{
-		lua_getglobal(L, functionName);
+		PushFunction(functionName);
 		if (lua_isfunction(L, -1))
 		{
 			return true;
@@ -71,12 +129,12 @@ bool Script::GetFunction(const char* functionName)
 
 void Script::Call(const char* functionName, int nrOfArgs, int clear)
 {
-	if (L != nullptr)
+	if (L != nullptr && !Reentered(L, path.c_str()))
 	{
-		lua_getglobal(L, functionName);
+		PushFunction(functionName);
 		if (lua_isfunction(L, -1))
 		{
-			LuaTools::docall(L, nrOfArgs, clear);
+			DoCall(nrOfArgs, clear);
 		}
 		else
 		{
@@ -87,13 +145,13 @@ void Script::Call(const char* functionName, int nrOfArgs, int clear)
 
 void Script::Call(const char* functionName, void* lightUserData)
 {
-	if (L != nullptr)
+	if (L != nullptr && !Reentered(L, path.c_str()))
 	{
-		lua_getglobal(L, functionName);
+		PushFunction(functionName);
 		if (lua_isfunction(L, -1))
 		{
 			lua_pushlightuserdata(L, lightUserData);
-			LuaTools::docall(L, 1, 1);
+			DoCall(1, 1);
 		}
 		else
 		{
@@ -102,17 +160,28 @@ void Script::Call(const char* functionName, void* lightUserData)
 	}
 }
 
+void Script::CallInit(void* lightUserData)
+{
+	CallRef(initRef, lightUserData);
+}
+
+void Script::CallRun(void* lightUserData)
+{
+	CallRef(runRef, lightUserData);
+}
+
 void Script::Reload()
 {
-	if (L == nullptr)
+	if (L == nullptr || Reentered(L, path.c_str()))
 	{
 		return;
 	}
-	lua_close(L);
-
-	L = luaL_newstate();
-
-	luaL_openlibs(L);
+	//the next load compiles the file again, scripts still using the old chunk keep it until they reload
+	if (chunk != nullptr)
+	{
+		auto it = chunks->find(path);
+		if (it != chunks->end() && it->second == chunk) chunks->erase(it);
+	}
 	std::string scriptPath = path;
 	LoadLuaFile(scriptPath.c_str());
 }
@@ -121,9 +190,130 @@ void Script::Unload()
 {
 	if (L != nullptr)
 	{
-		lua_close(L);
+		if (L == sharedState)
+		{
+			luaL_unref(L, LUA_REGISTRYINDEX, initRef);
+			luaL_unref(L, LUA_REGISTRYINDEX, runRef);
+			luaL_unref(L, LUA_REGISTRYINDEX, envRef);
+			if (chunk != nullptr) ReleaseChunk(L, chunk);
+		}
+		else
+		{
+			lua_close(L);
+		}
 		L = nullptr;
+		envRef = LUA_NOREF;
+		initRef = LUA_NOREF;
+		runRef = LUA_NOREF;
+		chunk = nullptr;
 		name.clear();
 		path.clear();
 	}
 }
+
+void Script::PushFunction(const char* functionName)
+{
+	if (envRef != LUA_NOREF)
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, envRef);
+		lua_getfield(L, -1, functionName);
+		lua_remove(L, -2);
+	}
+	else
+	{
+		lua_getglobal(L, functionName);
+	}
+}
+
+int Script::RefFunction(const char* functionName)
+{
+	//a shared script whose file failed to load has nothing of its own to find
+	if (L == nullptr || (L == sharedState && envRef == LUA_NOREF)) return LUA_NOREF;
+	PushFunction(functionName);
+	if (lua_isfunction(L, -1))
+	{
+		return luaL_ref(L, LUA_REGISTRYINDEX);
+	}
+	lua_pop(L, 1);
+	return LUA_NOREF;
+}
+
+void Script::CallRef(int functionRef, void* lightUserData)
+{
+	if (L != nullptr && functionRef != LUA_NOREF && !Reentered(L, path.c_str()))
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, functionRef);
+		lua_pushlightuserdata(L, lightUserData);
+		DoCall(1, 1);
+	}
+}
+
+void Script::DoCall(int nrOfArgs, int clear)
+{
+	if (L != sharedState)
+	{
+		LuaTools::report(L, LuaTools::docall(L, nrOfArgs, clear));
+		return;
+	}
+	sharedCallDepth++;
+	LuaTools::report(L, LuaTools::docall(L, nrOfArgs, clear));
+	sharedCallDepth--;
+	RunDeferred();
+}
+
+bool Script::Reentered(lua_State* state, const char* scriptPath)
+{
+	//anything reaching here while the shared state is mid call came through an export that didn't use RunWhenIdle
+	if (state == nullptr || state != sharedState || sharedCallDepth == 0) return false;
+	printf("Script: %s can't enter the shared lua state while it's running, use RunWhenIdle\n", scriptPath);
+	return true;
+}
+
+void Script::RunWhenIdle(std::function<void()> operation)
+{
+	if (sharedCallDepth > 0)
+	{
+		deferred.push_back(std::move(operation));
+		return;
+	}
+	operation();
+}
+
+void Script::RunDeferred()
+{
+	//operations may defer more work of their own, that runs in the next pass
+	while (!deferred.empty())
+	{
+		std::vector<std::function<void()>> operations;
+		operations.swap(deferred);
+		for (auto& operation : operations) operation();
+	}
+}
+
+Script::Chunk* Script::AcquireChunk(lua_State* L, const std::string& path)
+{
+	auto it = chunks->find(path);
+	if (it != chunks->end())
+	{
+		it->second->users++;
+		return it->second;
+	}
+	int status = luaL_loadfile(L, path.c_str());
+	if (status != 0)
+	{
+		LuaTools::report(L, status);
+		return nullptr;
+	}
+	Chunk* newChunk = new Chunk{ luaL_ref(L, LUA_REGISTRYINDEX), 1, path };
+	(*chunks)[path] = newChunk;
+	return newChunk;
+}
+
+void Script::ReleaseChunk(lua_State* L, Chunk* chunk)
+{
+	if (--chunk->users > 0) return;
+	auto it = chunks->find(chunk->path);
+	if (it != chunks->end() && it->second == chunk) chunks->erase(it);
+	luaL_unref(L, LUA_REGISTRYINDEX, chunk->ref);
+	delete chunk;
+}
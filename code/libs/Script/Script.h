@@ -1,5 +1,8 @@
 #pragma once
 #include <string>
+#include <unordered_map>
+#include <vector>
+#include <functional>
 
 struct lua_State;
 
@@ -13,10 +16,52 @@ public:
 	bool GetFunction(const char* functionName);
 	void Call(const char* functionName = "run", int nrOfArgs = 0, int clear = 1);
 	void Call(const char* functionName, void* lightUserData);
+	//init and run are resolved once at load time, these skip the lookup by name
+	void CallInit(void* lightUserData);
+	void CallRun(void* lightUserData);
 	void Reload();
 	void Unload();
 	std::string path;
 	std::string name;
 	lua_State *L;
+	//keeps this script in a lua state of its own even when shareState is set, has to be set before loading
+	bool ownState;
+
+	//scripts loaded while this is set run in one shared vm, each in its own environment table
+	//that falls back to the globals, scripts loaded from the same file share one compiled chunk
+	//when it's not set every script opens its own lua state like before
+	static bool shareState;
+	static lua_State* GetSharedState();
+	//lua can't be entered again from an ffi call into the same state, exports that load, call or unload scripts
+	//pass their work here, it runs right away unless the shared state is mid call, then after that call returns
+	static void RunWhenIdle(std::function<void()> operation);
 private:
-};
\ No newline at end of file
+	struct Chunk
+	{
+		int ref;
+		int users;
+		std::string path;
+	};
+
+	void PushFunction(const char* functionName);
+	int RefFunction(const char* functionName);
+	void CallRef(int functionRef, void* lightUserData);
+	void DoCall(int nrOfArgs, int clear);
+	static bool Reentered(lua_State* state, const char* scriptPath);
+	static void RunDeferred();
+	static Chunk* AcquireChunk(lua_State* L, const std::string& path);
+	static void ReleaseChunk(lua_State* L, Chunk* chunk);
+
+	int envRef;
+	int initRef;
+	int runRef;
+	Chunk* chunk;
+
+	static lua_State* sharedState;
+	//metatable sending lookups that miss the environment to the globals
+	static int envMetatableRef;
+	//created with the shared state and never freed either, see GetSharedState
+	static std::unordered_map<std::string, Chunk*>* chunks;
+	static int sharedCallDepth;
+	static std::vector<std::function<void()>> deferred;
+};
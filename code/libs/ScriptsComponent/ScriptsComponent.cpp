@@ -50,7 +50,7 @@ void ScriptsComponent::Start()
 {
 	for (auto& script : scripts)
 	{
-		script->Call("init", object);
+		script->CallInit(object);
 	}
 }
 
@@ -58,7 +58,7 @@ void ScriptsComponent::Update()
 {
 	for (auto& script : scripts)
 	{
-		script->Call("run", object);
+		script->CallRun(object);
 	}
 }
 
@@ -1,5 +1,6 @@
 #include "CPUBlockData.h"
 #include "GL/glew.h"
+#include <algorithm>
 
 CPUBlockData::CPUBlockData()
 {
@@ -34,6 +35,35 @@ void CPUBlockData::SetData(int offset, const void* newData, int size)
 	memcpy(&data[offset], newData, size);
 }
 
+void CompiledBindings::Begin(const void* newSource, unsigned int newSourceVersion, unsigned int newDestinationVersion)
+{
+	ranges.clear();
+	source = newSource;
+	sourceVersion = newSourceVersion;
+	destinationVersion = newDestinationVersion;
+	compiled = true;
+}
+
+void CompiledBindings::End()
+{
+	std::sort(ranges.begin(), ranges.end());
+	size_t merged = 0;
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		if (merged > 0)
+		{
+			DataBinding& last = ranges[merged - 1];
+			if (last.offset + last.size == ranges[i].offset && (const char*)last.dataAddress + last.size == ranges[i].dataAddress)
+			{
+				last.size += ranges[i].size;
+				continue;
+			}
+		}
+		ranges[merged++] = ranges[i];
+	}
+	ranges.resize(merged);
+}
+
 void CPUBlockData::ResetCounters()
 {
 	gpuBufferStart = 0;
@@ -15,6 +15,25 @@ struct DataBinding
 	}
 };
 
+//copies resolved once from named properties to offsets in a block or vertex, adjacent copies merged into one range
+//recompiled only when the source registry or the destination layout reports a new version
+struct CompiledBindings
+{
+	bool IsCurrent(const void* newSource, unsigned int newSourceVersion, unsigned int newDestinationVersion) const
+	{
+		return compiled && source == newSource && sourceVersion == newSourceVersion && destinationVersion == newDestinationVersion;
+	}
+	void Begin(const void* newSource, unsigned int newSourceVersion, unsigned int newDestinationVersion);
+	void Add(int offset, const void* dataAddress, int size) { ranges.emplace_back(offset, dataAddress, size); }
+	void End();
+	std::vector<DataBinding> ranges;
+private:
+	const void* source = nullptr;
+	unsigned int sourceVersion = 0;
+	unsigned int destinationVersion = 0;
+	bool compiled = false;
+};
+
 class CPUBlockData
 {
 public:
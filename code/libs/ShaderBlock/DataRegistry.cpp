@@ -1,7 +1,10 @@
 #include "DataRegistry.h"
 
+unsigned int DataRegistry::versionCounter = 0;
+
 DataRegistry::DataRegistry()
 {
+	Changed();
 }
 
 DataRegistry::~DataRegistry()
@@ -13,6 +16,7 @@ void DataRegistry::RegisterProperty(const std::string & name, const DataInfo * p
 	if (bindings.find(name) == bindings.end())
 	{
 		bindings[name] = *property;
+		Changed();
 	}
 }
 
@@ -36,6 +40,7 @@ void DataRegistry::RegisterProperty(const std::string& name, void * address, int
 	if (bindings.find(name) == bindings.end())
 	{
 		bindings.try_emplace(name, address, size, type);
+		Changed();
 	}
 }
 
@@ -47,6 +52,7 @@ void DataRegistry::UnregisterProperty(const char* name)
 		bindings.erase(result);
 	}
 	pb.RemoveProperty(name);
+	Changed();
 }
 
 const void* DataRegistry::GetPropertyPtr(const char * name)
@@ -76,10 +82,17 @@ void DataRegistry::RegisterProperties(PropertyBuffer* properties)
 	{
 		bindings[binding.first] = binding.second.info;
 	}
+	Changed();
 }
 
 void DataRegistry::Clear()
 {
 	pb.Clear();
 	bindings.clear();
+	Changed();
+}
+
+void DataRegistry::Changed()
+{
+	version = ++versionCounter;
 }
\ No newline at end of file
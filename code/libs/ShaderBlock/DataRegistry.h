@@ -24,5 +24,9 @@ public:
 	void Clear();
 	std::map<std::string, DataInfo> bindings;
 	PropertyBuffer pb;
+	//changes whenever a property is added, removed or moved, unique across registries so compiled bindings can't mistake one for another
+	unsigned int version;
 private:
+	void Changed();
+	static unsigned int versionCounter;
 };
\ No newline at end of file
@@ -2,8 +2,11 @@
 #include "CPUBlockData.h"
 #include "GL/glew.h"
 
+unsigned int ShaderBlock::layoutVersionCounter = 0;
+
 ShaderBlock::ShaderBlock()
 {
+	layoutVersion = ++layoutVersionCounter;
 }
 
 ShaderBlock::ShaderBlock(int newSize, int newIndex, BlockType type)
@@ -13,6 +16,7 @@ ShaderBlock::ShaderBlock(int newSize, int newIndex, BlockType type)
 	if (type == BlockType::Uniform) target = GL_UNIFORM_BUFFER;
 	else target = GL_SHADER_STORAGE_BUFFER;
 	data.SetSize(newSize);
+	layoutVersion = ++layoutVersionCounter;
 	Generate();
 }
 
@@ -46,6 +50,7 @@ void ShaderBlock::Submit()
 void ShaderBlock::AddVariableOffset(const std::string & uniformName, int loc)
 {
 	offsets[uniformName] = loc;
+	layoutVersion = ++layoutVersionCounter;
 }
 
 void ShaderBlock::SetData(const char* uniformName, const void* newData, int size)
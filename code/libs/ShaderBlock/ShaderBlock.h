@@ -27,7 +27,10 @@ public:
 	int index;
 	int size;
 	GLuint handle;
+	//changes whenever a variable offset is added, unique across blocks
+	unsigned int layoutVersion;
 private:
+	static unsigned int layoutVersionCounter;
 	void Generate();
 	ShaderBlock();
 	GLenum target;
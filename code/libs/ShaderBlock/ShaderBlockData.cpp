@@ -79,6 +79,26 @@ void ShaderBlockData::RegisterDataWithOffset(int offset, const void* data, int s
 	std::sort(dataBindings.begin(), dataBindings.end());
 }
 
+void ShaderBlockData::CompileBindings(const DataRegistry& dataRegistry)
+{
+	if (compiledBindings.IsCurrent(&dataRegistry, dataRegistry.version, shaderBlock->layoutVersion)) return;
+	compiledBindings.Begin(&dataRegistry, dataRegistry.version, shaderBlock->layoutVersion);
+	for (auto& nameAndOffset : shaderBlock->offsets)
+	{
+		auto property = dataRegistry.GetProperty(nameAndOffset.first.c_str());
+		if (property != nullptr)
+		{
+			compiledBindings.Add(nameAndOffset.second, property->dataAddress, property->size);
+		}
+	}
+	compiledBindings.End();
+}
+
+void ShaderBlockData::UpdateFromCompiledBindings()
+{
+	shaderBlock->data.UpdateBuffer(compiledBindings.ranges);
+}
+
 int ShaderBlockData::FindDataBindingIndex(int offset)
 {
 	for (size_t i = 0; i < dataBindings.size(); i++)
@@ -19,8 +19,13 @@ public:
 	void RegisterProperties(const DataRegistry& dataRegistry);
 	void RegisterDataWithOffsets(const DataRegistry& dataRegistry, std::unordered_map<std::string, int>& shaderBlockOffsets);
 	void RegisterDataWithOffset(int offset, const void* data, int size);
+	//resolves the block offsets against the registry properties, only when one of them changed since the last call
+	void CompileBindings(const DataRegistry& dataRegistry);
+	//copies the compiled properties into the block
+	void UpdateFromCompiledBindings();
 	ShaderBlock* shaderBlock;
 	std::vector<DataBinding> dataBindings;
+	CompiledBindings compiledBindings;
 private:
 	int FindDataBindingIndex(int offset);
 };
\ No newline at end of file
@@ -0,0 +1,493 @@
+#define _CRT_SECURE_NO_DEPRECATE
+#include "TextureCache.h"
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include "MappedFile.h"
+#include "SOIL2.h"
+#include "image_DXT.h"
+#define STB_DXT_IMPLEMENTATION
+#include "stb_dxt.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTURE_SIMD_WIDTH 4
+#else
+#define TEXTURE_SIMD_WIDTH 1
+#endif
+
+#define FOURCC_DXT1 0x31545844 // Equivalent to "DXT1" in ASCII
+#define FOURCC_DXT5 0x35545844 // Equivalent to "DXT5" in ASCII
+
+//one rgba pixel per register so the filters are written once for sse and plain floats
+#if TEXTURE_SIMD_WIDTH == 4
+typedef __m128 SimdPixel;
+static inline SimdPixel PixelLoad(const float* src) { return _mm_loadu_ps(src); }
+static inline void PixelStore(float* dst, SimdPixel v) { _mm_storeu_ps(dst, v); }
+static inline SimdPixel PixelSet(float f) { return _mm_set1_ps(f); }
+static inline SimdPixel PixelAdd(SimdPixel a, SimdPixel b) { return _mm_add_ps(a, b); }
+static inline SimdPixel PixelMul(SimdPixel a, SimdPixel b) { return _mm_mul_ps(a, b); }
+#else
+struct SimdPixel { float v[4]; };
+static inline SimdPixel PixelLoad(const float* src) { return { { src[0], src[1], src[2], src[3] } }; }
+static inline void PixelStore(float* dst, SimdPixel p) { memcpy(dst, p.v, sizeof(p.v)); }
+static inline SimdPixel PixelSet(float f) { return { { f, f, f, f } }; }
+static inline SimdPixel PixelAdd(SimdPixel a, SimdPixel b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+static inline SimdPixel PixelMul(SimdPixel a, SimdPixel b) { return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+#endif
+
+//6 tap kaiser windowed sinc for halving, taps sit at source pixels 2x-2 to 2x+3 around the destination center
+static const int kaiserTaps = 6;
+
+struct FilterTables
+{
+	float srgbToLinear[256];
+	//linear values quantized to 12 bits, enough that every dark srgb step keeps its own entry
+	unsigned char linearToSrgb[4096];
+	float kaiserWeights[kaiserTaps];
+
+	FilterTables()
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			float c = i / 255.f;
+			srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for (int i = 0; i < 4096; i++)
+		{
+			float l = i / 4095.f;
+			float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.f / 2.4f) - 0.055f;
+			linearToSrgb[i] = (unsigned char)(c * 255.f + 0.5f);
+		}
+		const double alpha = 4.0;
+		const double radius = 1.5;
+		const double pi = 3.14159265358979323846;
+		double sum = 0.0;
+		double weights[kaiserTaps];
+		for (int k = 0; k < kaiserTaps; k++)
+		{
+			//distance from the destination center in destination pixels
+			double t = ((k - 2) - 0.5) * 0.5;
+			double sinc = sin(pi * t) / (pi * t);
+			double x = t / radius;
+			double window = BesselI0(alpha * sqrt(1.0 - x * x)) / BesselI0(alpha);
+			weights[k] = sinc * window;
+			sum += weights[k];
+		}
+		for (int k = 0; k < kaiserTaps; k++) kaiserWeights[k] = (float)(weights[k] / sum);
+	}
+
+	static double BesselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 32; k++)
+		{
+			double half = x / (2.0 * k);
+			term *= half * half;
+			sum += term;
+		}
+		return sum;
+	}
+};
+
+static const FilterTables& GetFilterTables()
+{
+	static const FilterTables tables;
+	return tables;
+}
+
+static inline unsigned char ToUnorm(float v)
+{
+	v = v < 0.f ? 0.f : v > 1.f ? 1.f : v;
+	return (unsigned char)(v * 255.f + 0.5f);
+}
+
+static inline unsigned char ToSrgb(float v, const FilterTables& tables)
+{
+	v = v < 0.f ? 0.f : v > 1.f ? 1.f : v;
+	return tables.linearToSrgb[(int)(v * 4095.f + 0.5f)];
+}
+
+static inline uint64_t RotateLeft(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t MixBits(uint64_t value)
+{
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdULL;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ULL;
+	value ^= value >> 33;
+	return value;
+}
+
+//dds and hdr files are uploaded as they are, compressed dds are also read through a FILE by SOIL so they can not be decoded from a mapped source
+static bool IsLoadedAsIs(const std::string& sourcePath, const TextureBakeSettings& settings)
+{
+	std::string extension = std::filesystem::path(sourcePath).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+	return settings.compression == TextureCompression::None || extension == ".dds" || extension == ".hdr";
+}
+
+void TextureCache::ParseSettings(const char* options, TextureBakeSettings& settings)
+{
+	char token[32];
+	int consumed = 0;
+	while (options != nullptr && sscanf(options, "%31s%n", token, &consumed) == 1)
+	{
+		options += consumed;
+		if (strcmp(token, "srgb") == 0) settings.srgb = true;
+		else if (strcmp(token, "linear") == 0) settings.srgb = false;
+		else if (strcmp(token, "auto") == 0) settings.compression = TextureCompression::Auto;
+		else if (strcmp(token, "none") == 0) settings.compression = TextureCompression::None;
+		else if (strcmp(token, "bc1") == 0) settings.compression = TextureCompression::BC1;
+		else if (strcmp(token, "bc3") == 0) settings.compression = TextureCompression::BC3;
+		else if (strcmp(token, "bc5") == 0) settings.compression = TextureCompression::BC5;
+		else if (strcmp(token, "box") == 0) settings.filter = MipFilter::Box;
+		else if (strcmp(token, "kaiser") == 0) settings.filter = MipFilter::Kaiser;
+		else printf("Unknown texture option: %s\n", token);
+	}
+}
+
+uint64_t TextureCache::Hash(const char* data, size_t size, const TextureBakeSettings& settings)
+{
+	if (data == nullptr || size == 0) return 0;
+	uint64_t hash = MixBits(size ^ ((uint64_t)version << 32) ^ ((uint64_t)settings.compression << 8) ^ ((uint64_t)settings.filter << 4) ^ (uint64_t)settings.srgb);
+	//word at a time, the whole source is hashed on every load so this has to stay close to memory speed
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		hash = RotateLeft(hash ^ (word * 0x9E3779B97F4A7C15ULL), 31) * 0x100000001B3ULL;
+	}
+	uint64_t tail = 0;
+	memcpy(&tail, data + i, size - i);
+	hash = MixBits(hash ^ tail);
+	return hash == 0 ? 1 : hash;
+}
+
+std::string TextureCache::GetCachePath(const std::string& sourcePath, uint64_t hash)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.dds", (unsigned long long)hash);
+	return (std::filesystem::path(sourcePath).parent_path() / "cache" / name).string();
+}
+
+TextureInfo* TextureCache::Load(const std::string& sourcePath, const TextureBakeSettings& settings)
+{
+	if (IsLoadedAsIs(sourcePath, settings)) return SOIL_load_image(sourcePath.c_str(), 0);
+
+	MappedFile source;
+	if (!source.Open(sourcePath.c_str())) return nullptr;
+	std::string cachePath = GetCachePath(sourcePath, Hash(source.GetData(), source.GetSize(), settings));
+	std::error_code error;
+	if (std::filesystem::exists(cachePath, error))
+	{
+		TextureInfo* cached = SOIL_load_image(cachePath.c_str(), 0);
+		if (cached != nullptr && cached->type == DDS && ((DDSExtraInfo*)cached->extraInfo)->compressed) return cached;
+		if (cached != nullptr) SOIL_free_texture_info(cached);
+	}
+
+	TextureInfo* image = SOIL_load_image_from_memory((const unsigned char*)source.GetData(), (int)source.GetSize(), 0);
+	if (image == nullptr || image->type == DDS || image->type == HDR) return image;
+	TextureInfo* encoded = Encode(image, settings);
+	if (encoded == nullptr) return image;
+	SOIL_free_texture_info(image);
+	WriteDDS(encoded, cachePath);
+	return encoded;
+}
+
+bool TextureCache::Bake(const std::string& sourcePath, const TextureBakeSettings& settings, bool force)
+{
+	//sources that are loaded as they are need no cache
+	if (IsLoadedAsIs(sourcePath, settings)) return true;
+	MappedFile source;
+	if (!source.Open(sourcePath.c_str())) return false;
+	std::string cachePath = GetCachePath(sourcePath, Hash(source.GetData(), source.GetSize(), settings));
+	std::error_code error;
+	if (!force && std::filesystem::exists(cachePath, error)) return true;
+
+	TextureInfo* image = SOIL_load_image_from_memory((const unsigned char*)source.GetData(), (int)source.GetSize(), 0);
+	if (image == nullptr) return false;
+	TextureInfo* encoded = image->type == DDS || image->type == HDR ? nullptr : Encode(image, settings);
+	SOIL_free_texture_info(image);
+	if (encoded == nullptr) return true;
+	bool written = WriteDDS(encoded, cachePath);
+	SOIL_free_texture_info(encoded);
+	return written;
+}
+
+TextureCompression TextureCache::ResolveCompression(const TextureInfo* image, TextureCompression compression)
+{
+	if (compression != TextureCompression::Auto) return compression;
+	switch (image->numOfElements)
+	{
+	case 2:
+		return TextureCompression::BC5;
+	case 3:
+		return TextureCompression::BC1;
+	case 4:
+	{
+		//opaque rgba images are common and get the smaller format
+		const unsigned char* pixels = (const unsigned char*)image->data;
+		size_t count = (size_t)image->width * image->height;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (pixels[i * 4 + 3] != 255) return TextureCompression::BC3;
+		}
+		return TextureCompression::BC1;
+	}
+	default:
+		return TextureCompression::None;
+	}
+}
+
+TextureInfo* TextureCache::Encode(const TextureInfo* image, const TextureBakeSettings& settings)
+{
+	if (image == nullptr || image->data == nullptr || image->type == DDS || image->type == HDR) return nullptr;
+	TextureCompression compression = ResolveCompression(image, settings.compression);
+	if (compression == TextureCompression::None) return nullptr;
+
+	std::vector<MipLevel> levels;
+	BuildMipChain(image, settings, levels);
+
+	unsigned int blockSize = compression == TextureCompression::BC1 ? 8 : 16;
+	size_t totalSize = 0;
+	for (const MipLevel& level : levels)
+	{
+		totalSize += (size_t)((level.width + 3) / 4) * ((level.height + 3) / 4) * blockSize;
+	}
+	unsigned char* blocks = (unsigned char*)malloc(totalSize);
+	size_t offset = 0;
+	for (const MipLevel& level : levels)
+	{
+		CompressLevel(level, compression, settings.srgb && image->numOfElements >= 3, blocks + offset);
+		offset += (size_t)((level.width + 3) / 4) * ((level.height + 3) / 4) * blockSize;
+	}
+
+	//same layout stbi's dds loader produces for compressed files, so upload goes through LoadCompressedDDS
+	TextureInfo* ti = (TextureInfo*)malloc(sizeof(TextureInfo));
+	ti->type = DDS;
+	ti->width = image->width;
+	ti->height = image->height;
+	ti->numOfElements = compression == TextureCompression::BC3 ? 4 : compression == TextureCompression::BC5 ? 2 : 3;
+	ti->data = blocks;
+	DDSExtraInfo* ei = (DDSExtraInfo*)malloc(sizeof(DDSExtraInfo));
+	ei->nrOfMips = (unsigned int)levels.size();
+	ei->fourCC = compression == TextureCompression::BC1 ? FOURCC_DXT1 : compression == TextureCompression::BC3 ? FOURCC_DXT5 : FOURCC_ATI2;
+	ei->nrOfCubeMapFaces = 1;
+	ei->compressed = 1;
+	ti->extraInfo = ei;
+	return ti;
+}
+
+bool TextureCache::WriteDDS(const TextureInfo* ti, const std::string& path)
+{
+	const DDSExtraInfo* ei = (const DDSExtraInfo*)ti->extraInfo;
+	unsigned int blockSize = ei->fourCC == FOURCC_DXT1 ? 8 : 16;
+	size_t dataSize = 0;
+	int width = ti->width;
+	int height = ti->height;
+	for (unsigned int level = 0; level < ei->nrOfMips; level++)
+	{
+		dataSize += (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+
+	DDS_header header;
+	memset(&header, 0, sizeof(DDS_header));
+	header.dwMagic = ('D' << 0) | ('D' << 8) | ('S' << 16) | (' ' << 24);
+	header.dwSize = 124;
+	header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE | DDSD_MIPMAPCOUNT;
+	header.dwWidth = ti->width;
+	header.dwHeight = ti->height;
+	header.dwPitchOrLinearSize = ((ti->width + 3) / 4) * ((ti->height + 3) / 4) * blockSize;
+	header.dwMipMapCount = ei->nrOfMips;
+	header.sPixelFormat.dwSize = 32;
+	header.sPixelFormat.dwFlags = DDPF_FOURCC;
+	header.sPixelFormat.dwFourCC = ei->fourCC;
+	header.sCaps.dwCaps1 = DDSCAPS_TEXTURE | (ei->nrOfMips > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+	//written next to the cache and renamed over it so a parallel load never reads a half written file
+	//sources with the same bytes share a cache, the thread is part of the name so their writes do not meet
+	std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (file == NULL)
+	{
+		printf("\nCould not write texture cache %s", path.c_str());
+		return false;
+	}
+	bool ok = fwrite(&header, 1, sizeof(DDS_header), file) == sizeof(DDS_header);
+	ok = ok && fwrite(ti->data, 1, dataSize, file) == dataSize;
+	ok = fclose(file) == 0 && ok;
+	if (ok) std::filesystem::rename(tempPath, path, error);
+	if (!ok || error)
+	{
+		std::filesystem::remove(tempPath, error);
+		printf("\nCould not write texture cache %s", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+void TextureCache::BuildMipChain(const TextureInfo* image, const TextureBakeSettings& settings, std::vector<MipLevel>& levels)
+{
+	const FilterTables& tables = GetFilterTables();
+	int channels = image->numOfElements;
+	bool srgb = settings.srgb && channels >= 3;
+	int mipCount = 1;
+	for (int size = std::max(image->width, image->height); size > 1; size /= 2) mipCount++;
+	levels.resize(mipCount);
+
+	MipLevel& top = levels[0];
+	top.width = image->width;
+	top.height = image->height;
+	size_t count = (size_t)top.width * top.height;
+	top.pixels.resize(count * 4);
+	const unsigned char* src = (const unsigned char*)image->data;
+	float* dst = top.pixels.data();
+	for (size_t i = 0; i < count; i++, src += channels, dst += 4)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			if (c < channels) dst[c] = srgb && c < 3 ? tables.srgbToLinear[src[c]] : src[c] / 255.f;
+			//missing alpha is opaque, missing color is black
+			else dst[c] = c == 3 ? 1.f : 0.f;
+		}
+		//grey images are spread over rgb
+		if (channels == 1) dst[1] = dst[2] = dst[0];
+	}
+
+	//every level is filtered from the float level above it so rounding does not pile up down the chain
+	for (int level = 1; level < mipCount; level++)
+	{
+		Downsample(levels[level - 1], levels[level], settings.filter);
+	}
+}
+
+void TextureCache::Downsample(const MipLevel& source, MipLevel& destination, MipFilter filter)
+{
+	int srcWidth = source.width;
+	int srcHeight = source.height;
+	int width = std::max(srcWidth / 2, 1);
+	int height = std::max(srcHeight / 2, 1);
+	destination.width = width;
+	destination.height = height;
+	destination.pixels.resize((size_t)width * height * 4);
+	const float* src = source.pixels.data();
+	float* dst = destination.pixels.data();
+
+	if (filter == MipFilter::Box)
+	{
+		//odd edges repeat the last row or column
+		SimdPixel quarter = PixelSet(0.25f);
+		for (int y = 0; y < height; y++)
+		{
+			const float* row0 = src + (size_t)std::min(y * 2, srcHeight - 1) * srcWidth * 4;
+			const float* row1 = src + (size_t)std::min(y * 2 + 1, srcHeight - 1) * srcWidth * 4;
+			float* out = dst + (size_t)y * width * 4;
+			for (int x = 0; x < width; x++)
+			{
+				int x0 = std::min(x * 2, srcWidth - 1) * 4;
+				int x1 = std::min(x * 2 + 1, srcWidth - 1) * 4;
+				SimdPixel sum = PixelAdd(PixelAdd(PixelLoad(row0 + x0), PixelLoad(row0 + x1)), PixelAdd(PixelLoad(row1 + x0), PixelLoad(row1 + x1)));
+				PixelStore(out + x * 4, PixelMul(sum, quarter));
+			}
+		}
+		return;
+	}
+
+	//separable, rows are filtered into a half width buffer which is then filtered down the columns
+	const float* weights = GetFilterTables().kaiserWeights;
+	SimdPixel tapWeights[kaiserTaps];
+	for (int k = 0; k < kaiserTaps; k++) tapWeights[k] = PixelSet(weights[k]);
+	std::vector<float> rows((size_t)width * srcHeight * 4);
+	for (int y = 0; y < srcHeight; y++)
+	{
+		const float* in = src + (size_t)y * srcWidth * 4;
+		float* out = rows.data() + (size_t)y * width * 4;
+		for (int x = 0; x < width; x++)
+		{
+			SimdPixel sum = PixelSet(0.f);
+			for (int k = 0; k < kaiserTaps; k++)
+			{
+				int sx = std::min(std::max(x * 2 + k - 2, 0), srcWidth - 1);
+				sum = PixelAdd(sum, PixelMul(PixelLoad(in + sx * 4), tapWeights[k]));
+			}
+			PixelStore(out + x * 4, sum);
+		}
+	}
+	for (int y = 0; y < height; y++)
+	{
+		const float* taps[kaiserTaps];
+		for (int k = 0; k < kaiserTaps; k++)
+		{
+			int sy = std::min(std::max(y * 2 + k - 2, 0), srcHeight - 1);
+			taps[k] = rows.data() + (size_t)sy * width * 4;
+		}
+		float* out = dst + (size_t)y * width * 4;
+		for (int x = 0; x < width * 4; x += 4)
+		{
+			SimdPixel sum = PixelSet(0.f);
+			for (int k = 0; k < kaiserTaps; k++)
+			{
+				sum = PixelAdd(sum, PixelMul(PixelLoad(taps[k] + x), tapWeights[k]));
+			}
+			PixelStore(out + x, sum);
+		}
+	}
+}
+
+void TextureCache::CompressLevel(const MipLevel& level, TextureCompression compression, bool srgb, unsigned char* out)
+{
+	const FilterTables& tables = GetFilterTables();
+	int width = level.width;
+	int height = level.height;
+	unsigned char rgba[16 * 4];
+	unsigned char rg[16 * 2];
+	for (int by = 0; by < height; by += 4)
+	{
+		for (int bx = 0; bx < width; bx += 4)
+		{
+			//blocks over the edge repeat the last row and column
+			for (int py = 0; py < 4; py++)
+			{
+				const float* row = level.pixels.data() + (size_t)std::min(by + py, height - 1) * width * 4;
+				for (int px = 0; px < 4; px++)
+				{
+					const float* pixel = row + std::min(bx + px, width - 1) * 4;
+					unsigned char* texel = &rgba[(py * 4 + px) * 4];
+					for (int c = 0; c < 3; c++) texel[c] = srgb ? ToSrgb(pixel[c], tables) : ToUnorm(pixel[c]);
+					texel[3] = ToUnorm(pixel[3]);
+					rg[(py * 4 + px) * 2] = texel[0];
+					rg[(py * 4 + px) * 2 + 1] = texel[1];
+				}
+			}
+			switch (compression)
+			{
+			case TextureCompression::BC1:
+				stb_compress_dxt_block(out, rgba, 0, STB_DXT_HIGHQUAL);
+				out += 8;
+				break;
+			case TextureCompression::BC3:
+				stb_compress_dxt_block(out, rgba, 1, STB_DXT_HIGHQUAL);
+				out += 16;
+				break;
+			default:
+				stb_compress_bc5_block(out, rg);
+				out += 16;
+				break;
+			}
+		}
+	}
+}
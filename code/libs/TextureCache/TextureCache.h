@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TextureInfo;
+
+#define FOURCC_ATI2 0x32495441 // Equivalent to "ATI2" in ASCII, the fourCC BC5 is stored with in dds files without a dx10 header
+
+enum class TextureCompression : uint32_t
+{
+	Auto, //BC1 for opaque color, BC3 with alpha, BC5 for two channels, single channel images stay uncompressed
+	None,
+	BC1,
+	BC3,
+	BC5
+};
+
+enum class MipFilter : uint32_t
+{
+	Box,
+	Kaiser
+};
+
+//textures are loaded as they are unless a compression is asked for, block compression is lossy and mangles normal maps
+struct TextureBakeSettings
+{
+	TextureCompression compression = TextureCompression::None;
+	MipFilter filter = MipFilter::Box;
+	//color channels are stored gamma encoded, mips are filtered in linear space
+	bool srgb = false;
+};
+
+//one mip level as linear rgba floats, grey images are spread over rgb and grey alpha images keep their channels in r and g like GL_RG8 does
+struct MipLevel
+{
+	int width;
+	int height;
+	std::vector<float> pixels;
+};
+
+//bakes decoded images into block compressed dds files with a full cpu built mip chain
+//caches are keyed by a hash of the source bytes and the settings so an edited or moved source never reads a stale cache
+class TextureCache
+{
+public:
+	static const uint32_t version = 1;
+
+	//reads "srgb", "linear", "auto", "none", "bc1", "bc3", "bc5", "box" and "kaiser" tokens separated by spaces, unknown tokens are reported and skipped
+	static void ParseSettings(const char* options, TextureBakeSettings& settings);
+	//0 when the source can not be read
+	static uint64_t Hash(const char* data, size_t size, const TextureBakeSettings& settings);
+	static std::string GetCachePath(const std::string& sourcePath, uint64_t hash);
+	//returns the cached dds when there is one, otherwise decodes the source and bakes and writes its cache
+	//sources that are not baked (dds, hdr, uncompressed settings) are returned decoded as SOIL_load_image would
+	static TextureInfo* Load(const std::string& sourcePath, const TextureBakeSettings& settings);
+	//writes the cache of the source, skipped when it exists unless forced
+	static bool Bake(const std::string& sourcePath, const TextureBakeSettings& settings, bool force = false);
+
+	//builds the mip chain of a decoded 8 bit image and block compresses it, nullptr when the image can not be compressed
+	//the result is laid out like a compressed dds loaded by SOIL and is freed with SOIL_free_texture_info
+	static TextureInfo* Encode(const TextureInfo* image, const TextureBakeSettings& settings);
+	static bool WriteDDS(const TextureInfo* ti, const std::string& path);
+
+	static void BuildMipChain(const TextureInfo* image, const TextureBakeSettings& settings, std::vector<MipLevel>& levels);
+	static void Downsample(const MipLevel& source, MipLevel& destination, MipFilter filter);
+private:
+	static TextureCompression ResolveCompression(const TextureInfo* image, TextureCompression compression);
+	static void CompressLevel(const MipLevel& level, TextureCompression compression, bool srgb, unsigned char* out);
+};
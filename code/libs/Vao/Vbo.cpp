@@ -52,37 +52,59 @@ VertexBufferDynamic::~VertexBufferDynamic()
 
 void VertexBufferDynamic::SetLocationData(void* data, int size, int offset)
 {
+	Resize(activeCount + 1);
+	MarkDirty(activeCount, 1);
 	memcpy(&cpuData[layout.GetStride() * activeCount + offset], data, size);
 }
 
 void VertexBufferDynamic::SetLocationData(void* data, LocationLayout& location)
 {
+	Resize(activeCount + 1);
+	MarkDirty(activeCount, 1);
 	memcpy(&cpuData[layout.GetStride() * activeCount + location.offset], data, location.size);
 }
 
 void VertexBufferDynamic::SetElementData(int elementNr, void* data)
 {
+	Resize(elementNr + 1);
+	MarkDirty(elementNr, 1);
 	memcpy(&cpuData[layout.GetStride() * elementNr], data, layout.GetStride());
 }
 
 void VertexBufferDynamic::SetData(int elementNr, LocationLayout& location, void* data) //could probably send Property containing offset and size, offset is calculated by buffer layout
 {
+	Resize(elementNr + 1);
+	MarkDirty(elementNr, 1);
 	memcpy(&cpuData[layout.GetStride() * elementNr + location.offset], data, location.size);
 }
 
 void VertexBufferDynamic::SetData(int elementNr, void* data, int size)
 {
+	unsigned int elementCount = (size + layout.GetStride() - 1) / layout.GetStride();
+	Resize(elementNr + elementCount);
+	MarkDirty(elementNr, elementCount);
 	memcpy(&cpuData[layout.GetStride() * elementNr], data, size);
 }
 
 void VertexBufferDynamic::SetData(std::vector<DataBinding>& dataBindings)
 {
-	for (auto db : dataBindings)
+	Resize(activeCount + 1);
+	MarkDirty(activeCount, 1);
+	for (auto& db : dataBindings)
 	{
 		memcpy(&cpuData[layout.GetStride() * activeCount + db.offset], db.dataAddress, db.size);
 	}
 }
 
+void VertexBufferDynamic::AppendInstances(const void* data, unsigned int count)
+{
+	if (count == 0) return;
+	Resize(activeCount + count);
+	MarkDirty(activeCount, count);
+	memcpy(&cpuData[layout.GetStride() * activeCount], data, layout.GetStride() * count);
+	activeCount += count;
+}
+
 void VertexBufferDynamic::IncreaseInstanceCount()
 {
 	activeCount++;
@@ -93,15 +115,23 @@ void VertexBufferDynamic::Resize(unsigned int newElementCount)
 {
 	if (newElementCount > maxElementCount)
 	{
-		char* newData = new char[layout.GetStride() * newElementCount];
+		unsigned int newCapacity = maxElementCount * growthFactor;
+		if (newCapacity < newElementCount) newCapacity = newElementCount;
+		char* newData = new char[layout.GetStride() * newCapacity];
 		memcpy(newData, cpuData, layout.GetStride() * maxElementCount);
-		maxElementCount = newElementCount;
+		maxElementCount = newCapacity;
 		delete[] cpuData;
 		cpuData = newData;
 		dirty = true;
 	}
 }
 
+void VertexBufferDynamic::MarkDirty(unsigned int firstElement, unsigned int elementCount)
+{
+	if (firstElement < dirtyStart) dirtyStart = firstElement;
+	if (firstElement + elementCount > dirtyEnd) dirtyEnd = firstElement + elementCount;
+}
+
 void VertexBufferDynamic::Update()
 {
 	if (dirty)
@@ -112,8 +142,12 @@ void VertexBufferDynamic::Update()
 		}
 		dirty = false;
 	}
-	else
+	else if (dirtyEnd > dirtyStart)
 	{
-		VertexBuffer::Update(cpuData, layout.GetOffset());
+		unsigned int stride = layout.GetStride();
+		//the layout offset counts elements, same as the offset VertexBuffer::Update takes
+		glNamedBufferSubData(handle, stride * (layout.GetOffset() + dirtyStart), stride * (dirtyEnd - dirtyStart), &cpuData[stride * dirtyStart]);
 	}
-}
\ No newline at end of file
+	dirtyStart = UINT_MAX;
+	dirtyEnd = 0;
+}
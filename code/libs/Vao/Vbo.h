@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
 #include <functional>
+#include <span>
+#include <climits>
 #include "RenderElement.h"
 #include "CPUBlockData.h"
 #include "ShaderDataType.h"
@@ -62,8 +64,11 @@ public:
 	std::vector<LocationLayout>& GetLocations() { return locations; }
 	std::vector<LocationLayout> locations;
 	bool isDynamic;
+	//changes whenever the locations are laid out again, unique across layouts
+	unsigned int version = 0;
 	void CalculateOffsetsAndStride()
 	{
+		version = ++versionCounter;
 		unsigned int Offset = 0;
 		stride = 0;
 		isDynamic = false;
@@ -77,7 +82,7 @@ public:
 		}
 	}
 private:
-	
+	static inline unsigned int versionCounter = 0;
 	unsigned int stride = 0;
 	unsigned int offset = 0; //offset to first element, hmm we should probably expose that, something to thing about in the future
 	void* data;
@@ -111,11 +116,23 @@ public:
 	void SetData(std::vector<DataBinding>& dataBindings);
 	void SetLocationData(void* data, int size, int offset);
 	void SetLocationData(void* data, LocationLayout& location);
+	//copies count whole elements after the active ones and makes them active
+	void AppendInstances(const void* data, unsigned int count);
+	template <typename T>
+	void AppendInstances(std::span<const T> instances) { AppendInstances(instances.data(), (unsigned int)(instances.size_bytes() / layout.GetStride())); }
+	//uploads only the elements written since the last update, or recreates the gpu buffer after it grew
 	void Update();
+	//grows the capacity to at least newElementCount, by at least growthFactor so appends are amortized
 	void Resize(unsigned int newElementCount);
 	~VertexBufferDynamic();
 	char* cpuData;
 	std::vector<VertexArray*> vaos;
+	//the gpu buffer has to be recreated with the new capacity
 	bool dirty = false;
+	static const unsigned int growthFactor = 2;
+	//for callers that write cpuData directly, the range is uploaded by the next Update
+	void MarkDirty(unsigned int firstElement, unsigned int elementCount);
 private:
+	unsigned int dirtyStart = UINT_MAX;
+	unsigned int dirtyEnd = 0;
 };
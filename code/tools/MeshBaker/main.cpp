@@ -0,0 +1,93 @@
+#define _CRT_SECURE_NO_DEPRECATE
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include "MeshCache.h"
+#include "JobSystem.h"
+
+//bakes every model listed in a models file into a binary mesh cache next to its source
+//usage: mesh_baker [-f] [models file] [paths file]
+//-f rebakes caches that are already up to date
+
+static std::string ReadResourcesPath(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+	{
+		printf("%s could not be opened.\n", path);
+		return "";
+	}
+	std::string resources;
+	char line[128];
+	while (fgets(line, sizeof(line), file))
+	{
+		// Skip lines that start with ;, #, or /
+		if (line[0] == '/' || line[0] == ';' || line[0] == '#') continue;
+		char folder[128];
+		char folderPath[128];
+		if (sscanf(line, "%s %s", folder, folderPath) == 2 && strcmp(folder, "resources") == 0) resources = folderPath;
+	}
+	fclose(file);
+	return resources;
+}
+
+static bool ReadModelPaths(const char* path, const std::string& resources, std::vector<std::string>& modelPaths)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+	{
+		printf("%s could not be opened.\n", path);
+		return false;
+	}
+	char line[128];
+	while (fgets(line, sizeof(line), file))
+	{
+		// Skip lines that start with ;, #, or /
+		if (line[0] == ';' || line[0] == '#' || line[0] == '/') continue;
+		char lineHeader[128];
+		if (sscanf(line, "%s", lineHeader) != 1) continue;
+		modelPaths.push_back(resources + lineHeader);
+	}
+	fclose(file);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	bool force = false;
+	const char* modelsPath = "config/models.txt";
+	const char* pathsPath = "config/paths.txt";
+	int positional = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-f") == 0) force = true;
+		else if (positional == 0) { modelsPath = argv[i]; positional++; }
+		else if (positional == 1) { pathsPath = argv[i]; positional++; }
+	}
+
+	std::string resources = ReadResourcesPath(pathsPath);
+	std::vector<std::string> modelPaths;
+	if (!ReadModelPaths(modelsPath, resources, modelPaths)) return 1;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	std::atomic<int> failed(0);
+	JobSystem::Instance()->ParallelFor(modelPaths.size(), 1, [&](size_t begin, size_t end, unsigned int /*thread*/)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			if (!MeshCache::Bake(modelPaths[i], force))
+			{
+				printf("\nFailed to bake %s", modelPaths[i].c_str());
+				failed++;
+			}
+		}
+	});
+	auto finish = std::chrono::high_resolution_clock::now();
+	double bakeTime = std::chrono::duration<double, std::milli>(finish - start).count();
+
+	printf("\nBaked %d of %d meshes in %f ms\n", (int)modelPaths.size() - failed.load(), (int)modelPaths.size(), bakeTime);
+	return failed.load() == 0 ? 0 : 1;
+}
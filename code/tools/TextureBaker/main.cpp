@@ -0,0 +1,98 @@
+#define _CRT_SECURE_NO_DEPRECATE
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include "TextureCache.h"
+#include "JobSystem.h"
+
+//bakes every texture listed with a compression option in a textures file into the block compressed dds cache the engine loads at startup
+//usage: texture_baker [-f] [textures file] [paths file]
+//-f rebakes caches that already exist
+
+static std::string ReadResourcesPath(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+	{
+		printf("%s could not be opened.\n", path);
+		return "";
+	}
+	std::string resources;
+	char line[128];
+	while (fgets(line, sizeof(line), file))
+	{
+		// Skip lines that start with ;, #, or /
+		if (line[0] == '/' || line[0] == ';' || line[0] == '#') continue;
+		char folder[128];
+		char folderPath[128];
+		if (sscanf(line, "%s %s", folder, folderPath) == 2 && strcmp(folder, "resources") == 0) resources = folderPath;
+	}
+	fclose(file);
+	return resources;
+}
+
+static bool ReadTextures(const char* path, const std::string& resources, std::vector<std::string>& texturePaths, std::vector<TextureBakeSettings>& textureSettings)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+	{
+		printf("%s could not be opened.\n", path);
+		return false;
+	}
+	char line[128];
+	while (fgets(line, sizeof(line), file))
+	{
+		// Skip lines that start with ;, #, or /
+		if (line[0] == ';' || line[0] == '#' || line[0] == '/') continue;
+		char texturePath[128];
+		int pathLength = 0;
+		if (sscanf(line, "%s%n", texturePath, &pathLength) != 1) continue;
+		TextureBakeSettings settings;
+		TextureCache::ParseSettings(line + pathLength, settings);
+		texturePaths.push_back(resources + texturePath);
+		textureSettings.push_back(settings);
+	}
+	fclose(file);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	bool force = false;
+	const char* texturesPath = "config/textures.txt";
+	const char* pathsPath = "config/paths.txt";
+	int positional = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-f") == 0) force = true;
+		else if (positional == 0) { texturesPath = argv[i]; positional++; }
+		else if (positional == 1) { pathsPath = argv[i]; positional++; }
+	}
+
+	std::string resources = ReadResourcesPath(pathsPath);
+	std::vector<std::string> texturePaths;
+	std::vector<TextureBakeSettings> textureSettings;
+	if (!ReadTextures(texturesPath, resources, texturePaths, textureSettings)) return 1;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	std::atomic<int> failed(0);
+	JobSystem::Instance()->ParallelFor(texturePaths.size(), 1, [&](size_t begin, size_t end, unsigned int /*thread*/)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			if (!TextureCache::Bake(texturePaths[i], textureSettings[i], force))
+			{
+				printf("\nFailed to bake %s", texturePaths[i].c_str());
+				failed++;
+			}
+		}
+	});
+	auto finish = std::chrono::high_resolution_clock::now();
+	double bakeTime = std::chrono::duration<double, std::milli>(finish - start).count();
+
+	printf("\nBaked %d of %d textures in %f ms\n", (int)texturePaths.size() - failed.load(), (int)texturePaths.size(), bakeTime);
+	return failed.load() == 0 ? 0 : 1;
+}
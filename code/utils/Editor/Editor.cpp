@@ -39,6 +39,7 @@
 #include <algorithm>
 #include "misc/cpp/imgui_stdlib.h"
 #include "OBJ.h"
+#include "JobSystem.h"
 #include "ParticleSystem.h"
 #include "ScriptsComponent.h"
 #include <thread>
@@ -147,6 +148,7 @@ inline void Editor::DrawComponentBasic(Component* component, const std::string&
 
 		if (removeComponent)
 		{
+			SceneGraph::Instance()->unregisterComponentForPicking(component);
 			object->RemoveComponent(component);
 		}
 	}
@@ -1393,7 +1395,7 @@ void Editor::DrawComponentUI(ImGuiTextFilter& filter, Object* object, Component*
 				ImGui::Text("Child Count: %d", object->node->children.size());
 				ImGui::Separator();
 				ImGui::PushItemWidth(ImGui::GetFontSize() * -7.f);
-				glm::mat4 worldTransform = object->node->TopDownTransformF;
+				glm::mat4 worldTransform = object->node->TopDownTransform;
 				EditTransform(&worldTransform[0][0], object);
 				ImGui::PopItemWidth();
 				ImGui::Separator();
@@ -1453,6 +1455,7 @@ void Editor::DrawComponentUI(ImGuiTextFilter& filter, Object* object, Component*
 								{
 									bc->SetUp(asset.center, asset.dimensions, asset.name);
 									bc->Update();
+									SceneGraph::Instance()->RebuildBoundsTree();
 									ImGui::CloseCurrentPopup();
 								}
 							}
@@ -1473,6 +1476,7 @@ void Editor::DrawComponentUI(ImGuiTextFilter& filter, Object* object, Component*
 					bc->name = "custom";
 					bc->SetBoundsCenter(glm::vec3(center.x, center.y, center.z));
 					bc->Update();
+					SceneGraph::Instance()->RebuildBoundsTree();
 				}
 				if (ImGui::InputFloat3("Dimensions", &dimensions.x))
 				{
@@ -1480,6 +1484,7 @@ void Editor::DrawComponentUI(ImGuiTextFilter& filter, Object* object, Component*
 					bc->name = "custom";
 					bc->SetBoundsDimensions(glm::vec3(dimensions.x, dimensions.y, dimensions.z));
 					bc->Update();
+					SceneGraph::Instance()->RebuildBoundsTree();
 				}
 				ImGui::Text("%s Measurements", meshName.c_str());
 			}, [&](auto component) {});
@@ -2709,9 +2714,16 @@ void Editor::AssetImport(const char** paths, int count)
 void Editor::LoadAndSaveMeshes()
 {
 	std::scoped_lock<std::mutex> lock(createVaoMutex);
+	for (auto obj : failedImports)
+	{
+		GraphicsStorage::assetRegistry.DeallocAsset(obj);
+	}
+	failedImports.clear();
 	std::vector<OBJ*> meshesToExport;
 	for (auto& obj : importedObjs)
 	{
+		//the saver reads the cpu streams on its own thread, they are filled here so it never has to
+		GraphicsManager::LoadOBJStreams(obj);
 		auto saveMeshDataThread = std::thread(&Editor::SaveMeshData, this, obj);
 		saveMeshDataThread.detach();
 		//SaveMeshData(pathObj.second);
@@ -2830,8 +2842,16 @@ void Editor::ImportUI()
 			for (auto& pathAndConfig : pathsAndConfigurations)
 			{
 				pathAndConfig.second = std::format("resources/vao_configurations/{}.json", pathAndConfig.second);
-				auto t = std::thread(GraphicsManager::LoadOBJ, &importedObjs, pathAndConfig.first);
-				t.detach();
+				std::string path = pathAndConfig.first;
+				//the registry is not safe to use while the frame runs, so the obj is allocated here and the job only parses
+				OBJ* obj = GraphicsStorage::assetRegistry.AllocAsset<OBJ>();
+				JobSystem::Instance()->Submit([this, path, obj]()
+				{
+					bool parsed = GraphicsManager::ParseOBJ(path, obj);
+					std::scoped_lock<std::mutex> lock(createVaoMutex);
+					if (parsed) importedObjs.push_back(obj);
+					else failedImports.push_back(obj);
+				});
 			}
 		}
 		if (ImGui::Button("Cancel"))
@@ -4748,6 +4768,7 @@ void Editor::ShadersInspector()
 			if (mat.shader == sh)
 			{
 				mat.shader = nullptr;
+				Material::elementsVersion++;
 			}
 		}
 		//GraphicsStorage::shaderIDs.erase(shaderName);
@@ -4763,6 +4784,7 @@ void Editor::ShadersInspector()
 			if (mat.shader == sh)
 			{
 				mat.shader = nullptr;
+				Material::elementsVersion++;
 			}
 		}
 		std::remove(sh->shaderPaths.vs.c_str());
@@ -7439,7 +7461,7 @@ void Editor::GenerateMaterialElementsUI(Material * mat)
 	static ImGuiTextFilter materialProfileFilter;
 	static ImGuiTextFilter objectProfileFilter;
 	static ImGuiTextFilter vaoFilter;
-	ImGui::Checkbox("Unbound", &mat->unbound);
+	if (ImGui::Checkbox("Unbound", &mat->unbound)) Material::elementsVersion++;
 	GenerateElementComboBox(mat, &renderPassFilter, MaterialElements::ERenderPass, "RenderPass", GraphicsStorage::assetRegistry.GetPool<RenderPass>());
 	GenerateElementComboBox(mat, &shaderFilter, MaterialElements::EShader, "Shader", GraphicsStorage::assetRegistry.GetPool<Shader>());
 	GenerateElementComboBox(mat, &renderProfileFilter, MaterialElements::ERenderProfile, "RenderProfile", GraphicsStorage::assetRegistry.GetPool<RenderProfile>());
@@ -8725,6 +8747,8 @@ void Editor::Stats()
 		ImGui::TreePop();
 	}
 	ImGui::Text("Draw calls %d", Render::Instance()->totalNrOfDrawCalls);
+	ImGui::Text("Render State Changes %d", Render::Instance()->stateChangeCount);
+	ImGui::Text("Render List Patched Passes %d", Render::Instance()->patchedPassCount);
 	ImGui::Text("TimeStep %.6f", Times::Instance()->paused ? 0.0 : 1.0 / Times::Instance()->timeStep);
 	ImGui::Text("Total FPS %.3f", 1.0 / Times::Instance()->deltaTime);
 	ImGui::Text("Total MS %.3f", Times::Instance()->deltaTime * 1000.0);
@@ -8747,15 +8771,27 @@ void Editor::Stats()
 	ImGui::Text("Particles rendered %d", particlesRendered);
 	ImGui::Text("Update Dynamic Array Time %.6f", SceneGraph::Instance()->updateDynamicArrayTime);
 	ImGui::Text("Update Transforms Time %.6f", SceneGraph::Instance()->updateTransformsTime);
-	ImGui::Text("Update Bounds Time %.6f", Bounds::updateBoundsTime);
-	ImGui::Text("Update MinMax Time %.6f", Bounds::updateMinMaxTime);
+	ImGui::Text("Bounds Tree Time %.6f", SceneGraph::Instance()->boundsTreeTime);
+	ImGui::Text("Cull Time %.6f", SceneGraph::Instance()->cullTime);
+	ImGui::Text("Cull Tree Nodes %d", SceneGraph::Instance()->boundsTree.testedTreeNodes);
+	ImGui::Text("Cull Leaves %d", SceneGraph::Instance()->boundsTree.testedLeaves);
+	ImGui::Text("Update Bounds Time %.6f", Bounds::updateBoundsTime.load());
+	ImGui::Text("Update MinMax Time %.6f", Bounds::updateMinMaxTime.load());
 	ImGui::Text("Update Components Time %.6f", SceneGraph::Instance()->updateComponentsTime);
 	ImGui::Text("PickedID %d", pickedID);
 	ImGui::Text("PRUNE %.8f", PhysicsManager::Instance()->pruneAndSweepTime);
+	ImGui::Text("Sweep Swaps %d", PhysicsManager::Instance()->sweepSwaps);
+	ImGui::Text("Pairs Added %d", PhysicsManager::Instance()->pairsAdded);
+	ImGui::Text("Pairs Removed %d", PhysicsManager::Instance()->pairsRemoved);
+	ImGui::Text("Islands %d", PhysicsManager::Instance()->islandCount);
+	ImGui::Text("Sleeping Islands %d", PhysicsManager::Instance()->sleepingIslandCount);
+	ImGui::Text("Islands Time %.8f", PhysicsManager::Instance()->islandTime);
 	ImGui::Text("SAT %.8f", PhysicsManager::Instance()->satTime);
 	ImGui::Text("Intersection Test %.8f", PhysicsManager::Instance()->intersectionTestTime);
 	ImGui::Text("Generate Contacts %.8f", PhysicsManager::Instance()->generateContactsTime);
 	ImGui::Text("Process Contacts %.8f", PhysicsManager::Instance()->processContactTime);
+	ImGui::Text("Solver Iterations %d", PhysicsManager::Instance()->solverIterationsUsed);
+	ImGui::Text("Solver Residual %.8f", PhysicsManager::Instance()->solverResidual);
 	ImGui::Text("Positional Correction %.8f", PhysicsManager::Instance()->positionalCorrectionTime);
 	ImGui::Text("Iterations Count %d", PhysicsManager::Instance()->iterCount);
 	
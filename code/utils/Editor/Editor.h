@@ -226,6 +226,8 @@ public:
 	template<typename UIPropertiesFunction, typename UIMenuItemsFunction>
 	inline void DrawComponentBasic(Component* component, const std::string& name, bool dynamic, Object* object, const UIPropertiesFunction& uiFunction, const UIMenuItemsFunction& menuItems);
 	std::vector<OBJ*> importedObjs;
+	//allocated for an import that failed to parse, released on the main thread
+	std::vector<OBJ*> failedImports;
 private:
 	
 
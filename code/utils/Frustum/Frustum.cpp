@@ -2,10 +2,27 @@
 // Created by marwac-9 on 9/17/15.
 //
 #include "Frustum.h"
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
 
 
 Frustum::Frustum()
 {
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i] = glm::vec4(0.f);
+	}
+	for (int i = 0; i < 8; i++)
+	{
+		planeX[i] = 0.f;
+		planeY[i] = 0.f;
+		planeZ[i] = 0.f;
+		planeD[i] = 0.f;
+	}
 }
 
 Frustum::~Frustum()
@@ -49,6 +66,15 @@ void Frustum::ExtractPlanes(const glm::mat4& VP)
 	fPlanes.w[3] = plane3.w;
 	fPlanes.w[4] = plane4.w;
 	fPlanes.w[5] = plane5.w;
+
+	for (int i = 0; i < 6; i++)
+	{
+		float length = (float)fPlanes.length[i];
+		planeX[i] = fPlanes.normal[i].x;
+		planeY[i] = fPlanes.normal[i].y;
+		planeZ[i] = fPlanes.normal[i].z;
+		planeD[i] = length > 0.f ? planes[i].w / length : 0.f;
+	}
 }
 
 bool Frustum::isBoundingSphereInView(const glm::vec3& position, double radius)
@@ -60,4 +86,60 @@ bool Frustum::isBoundingSphereInView(const glm::vec3& position, double radius)
 		}
 	}
 	return true;
-}
\ No newline at end of file
+}
+
+bool Frustum::IsBoxOutside(const glm::vec3& center, const glm::vec3& extents, unsigned int& planeMask) const
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (!(planeMask & (1u << i))) continue;
+		float distance = center.x * planeX[i] + center.y * planeY[i] + center.z * planeZ[i] + planeD[i];
+		float reach = extents.x * std::abs(planeX[i]) + extents.y * std::abs(planeY[i]) + extents.z * std::abs(planeZ[i]);
+		if (distance + reach <= 0.f) return true;
+		if (distance - reach > 0.f) planeMask &= ~(1u << i);
+	}
+	return false;
+}
+
+unsigned int Frustum::AreSpheresInView4(const float* x, const float* y, const float* z, const float* radius, unsigned int planeMask) const
+{
+#ifdef FRUSTUM_SSE
+	__m128 sx = _mm_loadu_ps(x);
+	__m128 sy = _mm_loadu_ps(y);
+	__m128 sz = _mm_loadu_ps(z);
+	__m128 sr = _mm_loadu_ps(radius);
+	__m128 zero = _mm_setzero_ps();
+	__m128 inView = _mm_cmpeq_ps(zero, zero);
+	for (int i = 0; i < 6; i++)
+	{
+		if (!(planeMask & (1u << i))) continue;
+		__m128 distance = _mm_add_ps(_mm_mul_ps(sx, _mm_set1_ps(planeX[i])), _mm_mul_ps(sy, _mm_set1_ps(planeY[i])));
+		distance = _mm_add_ps(distance, _mm_mul_ps(sz, _mm_set1_ps(planeZ[i])));
+		distance = _mm_add_ps(distance, _mm_add_ps(_mm_set1_ps(planeD[i]), sr));
+		inView = _mm_and_ps(inView, _mm_cmpgt_ps(distance, zero));
+	}
+	return (unsigned int)_mm_movemask_ps(inView);
+#else
+	unsigned int result = 0;
+	for (int s = 0; s < 4; s++)
+	{
+		bool inView = true;
+		for (int i = 0; i < 6 && inView; i++)
+		{
+			if (!(planeMask & (1u << i))) continue;
+			inView = x[s] * planeX[i] + y[s] * planeY[i] + z[s] * planeZ[i] + planeD[i] + radius[s] > 0.f;
+		}
+		if (inView) result |= 1u << s;
+	}
+	return result;
+#endif
+}
+
+bool Frustum::HasSamePlanes(const Frustum& other) const
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (planes[i] != other.planes[i]) return false;
+	}
+	return true;
+}
@@ -21,5 +21,18 @@ public:
 	void ExtractPlanes(const glm::mat4& VP);
 	bool isBoundingSphereInView(const glm::vec3& position, double radius);
 	
+	//box and packed sphere tests for the bounds tree, planes are kept normalized in float
+	//planeMask has a bit per plane that still has to be tested, planes a box is fully inside of are cleared from it
+	bool IsBoxOutside(const glm::vec3& center, const glm::vec3& extents, unsigned int& planeMask) const;
+	//bit i of the result is set when sphere i is in view, tests 4 spheres per plane at once
+	unsigned int AreSpheresInView4(const float* x, const float* y, const float* z, const float* radius, unsigned int planeMask) const;
+	bool HasSamePlanes(const Frustum& other) const;
+	static const unsigned int allPlanes = 0x3F;
+
 	FrustumPlanes fPlanes;
+private:
+	alignas(16) float planeX[8];
+	alignas(16) float planeY[8];
+	alignas(16) float planeZ[8];
+	alignas(16) float planeD[8];
 }; 
\ No newline at end of file
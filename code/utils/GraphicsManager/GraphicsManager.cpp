@@ -40,12 +40,15 @@ extern "C" {
 //#include "include/luaconf.h"
 }
 #include "LuaTools.h"
+#include "JobSystem.h"
+#include "MeshCache.h"
+#include "ShaderPreprocessor.h"
+#include "TextureCache.h"
 
 #define FOURCC_DXT1 0x31545844 // Equivalent to "DXT1" in ASCII
 #define FOURCC_DXT3 0x33545844 // Equivalent to "DXT3" in ASCII
 #define FOURCC_DXT5 0x35545844 // Equivalent to "DXT5" in ASCII
 
-static std::mutex objLoadMutex;
 static std::mutex tiLoadMutex;
 
 std::string str_tolower(std::string s) {
@@ -163,34 +166,86 @@ bool GraphicsManager::LoadOBJs(const char* path, std::vector<OBJ*>& parsedOBJs)
 
 bool GraphicsManager::LoadOBJs(std::vector<std::string>& meshPaths, std::vector<OBJ*>& parsedOBJs)
 {
-	std::vector<std::thread> threadPool;
+	//parsing and tangent generation run on the job system workers instead of one thread per file
+	//the registry is only touched here on the calling thread, jobs parse into objs allocated before they are submitted
+	//results are collected in the order of the paths
+	JobSystem* jobSystem = JobSystem::Instance();
+	std::vector<OBJ*> objs;
+	std::vector<std::future<bool>> loads;
+	objs.reserve(meshPaths.size());
+	loads.reserve(meshPaths.size());
 	for (auto& path : meshPaths)
 	{
-		threadPool.push_back(std::thread(LoadOBJ, &parsedOBJs, path));
+		OBJ* obj = GraphicsStorage::assetRegistry.AllocAsset<OBJ>();
+		objs.push_back(obj);
+		loads.push_back(jobSystem->Submit([path, obj]() { return ParseOBJ(path, obj); }));
 	}
-	for (auto& th : threadPool)
+	for (size_t i = 0; i < loads.size(); i++)
 	{
-		th.join();
+		jobSystem->Wait(loads[i]);
+		if (loads[i].get()) parsedOBJs.push_back(objs[i]);
+		else GraphicsStorage::assetRegistry.DeallocAsset(objs[i]);
 	}
 	return true;
 }
 
-void GraphicsManager::LoadOBJ(std::vector<OBJ*>* objs, std::string path)
+OBJ* GraphicsManager::LoadOBJ(const std::string& path)
 {
 	OBJ* tempOBJ = GraphicsStorage::assetRegistry.AllocAsset<OBJ>();
-	bool res = tempOBJ->LoadAndIndexOBJ(path.c_str());
+	if (ParseOBJ(path, tempOBJ)) return tempOBJ;
+	GraphicsStorage::assetRegistry.DeallocAsset(tempOBJ);
+	return nullptr;
+}
+
+bool GraphicsManager::ParseOBJ(const std::string& path, OBJ* obj)
+{
+	std::filesystem::path objPath(path);
+	//an up to date binary cache skips parsing, welding and tangent generation
+	std::string cachePath = MeshCache::GetCachePath(path);
+	if (MeshCache::IsUpToDate(path, cachePath))
+	{
+		//only the header is read here, the vao upload maps the cache again and the streams are copied when asked for
+		//so no mapping outlives this call
+		MeshCache meshCache;
+		if (meshCache.Open(cachePath.c_str()))
+		{
+			meshCache.CopyInfoTo(obj);
+			obj->cachePath = cachePath;
+			obj->path = path;
+			obj->name = objPath.stem().string();
+			return true;
+		}
+	}
+	bool res = obj->LoadAndIndexOBJ(path.c_str());
 	if (res)
 	{
-		std::filesystem::path objPath(path);
-		tempOBJ->name = objPath.stem().string();
-		
-		std::scoped_lock<std::mutex> lock(objLoadMutex);
-		(*objs).push_back(tempOBJ);
+		MeshCache::Write(obj, cachePath);
+		obj->name = objPath.stem().string();
+		return true;
 	}
+	return false;
+}
+
+bool GraphicsManager::LoadOBJStreams(OBJ* obj)
+{
+	if (obj->cachePath.empty()) return true;
+	MeshCache meshCache;
+	bool loaded = meshCache.Open(obj->cachePath.c_str());
+	if (loaded) meshCache.CopyTo(obj);
+	//the cache became unreadable since it was checked, parse the source instead
+	else loaded = obj->LoadAndIndexOBJ(obj->path.c_str());
+	obj->cachePath.clear();
+	return loaded;
 }
 
 VertexArray* GraphicsManager::LoadOBJToVAO(OBJ* object, VertexArray* vao)
 {
+	if (!object->cachePath.empty())
+	{
+		MeshCache meshCache;
+		if (meshCache.Open(object->cachePath.c_str())) return LoadMeshCacheToVAO(meshCache, vao);
+		if (!LoadOBJStreams(object)) return vao;
+	}
 	vao->AddVertexBuffer(GraphicsStorage::assetRegistry.AllocAsset<VertexBuffer>((const void*)&object->indexed_vertices[0], (unsigned int)object->indexed_vertices.size(), BufferLayout({ {ShaderDataType::Type::Float3, "position"} })));
 	vao->AddVertexBuffer(GraphicsStorage::assetRegistry.AllocAsset<VertexBuffer>((const void*)&object->indexed_uvs[0], (unsigned int)object->indexed_uvs.size(), BufferLayout({ {ShaderDataType::Type::Float2, "uv"} })));
 	vao->AddVertexBuffer(GraphicsStorage::assetRegistry.AllocAsset<VertexBuffer>((const void*)&object->indexed_normals[0], (unsigned int)object->indexed_normals.size(), BufferLayout({ {ShaderDataType::Type::Float3, "normal"} })));
@@ -205,6 +260,24 @@ VertexArray* GraphicsManager::LoadOBJToVAO(OBJ* object, VertexArray* vao)
 	return vao;
 }
 
+VertexArray* GraphicsManager::LoadMeshCacheToVAO(const MeshCache& meshCache, VertexArray* vao)
+{
+	//streams are uploaded straight from the mapped file
+	const MeshCacheHeader* header = meshCache.GetHeader();
+	vao->AddVertexBuffer(GraphicsStorage::assetRegistry.AllocAsset<VertexBuffer>((const void*)meshCache.GetVertices(), header->vertexCount, BufferLayout({ {ShaderDataType::Type::Float3, "position"} })));
+	vao->AddVertexBuffer(GraphicsStorage::assetRegistry.AllocAsset<VertexBuffer>((const void*)meshCache.GetUVs(), header->vertexCount, BufferLayout({ {ShaderDataType::Type::Float2, "uv"} })));
+	vao->AddVertexBuffer(GraphicsStorage::assetRegistry.AllocAsset<VertexBuffer>((const void*)meshCache.GetNormals(), header->vertexCount, BufferLayout({ {ShaderDataType::Type::Float3, "normal"} })));
+	if (header->tangentCount > 0)
+	{
+		vao->AddVertexBuffer(GraphicsStorage::assetRegistry.AllocAsset<VertexBuffer>((const void*)meshCache.GetTangents(), header->tangentCount, BufferLayout({ {ShaderDataType::Type::Float3, "tangent"} })));
+		vao->AddVertexBuffer(GraphicsStorage::assetRegistry.AllocAsset<VertexBuffer>((const void*)meshCache.GetBitangents(), header->tangentCount, BufferLayout({ {ShaderDataType::Type::Float3, "bitangent"} })));
+	}
+	vao->AddElementBuffer(GraphicsStorage::assetRegistry.AllocAsset<ElementBuffer>(meshCache.GetIndicesData(), header->indicesCount));
+	vao->center = glm::vec3(header->centerOfMesh[0], header->centerOfMesh[1], header->centerOfMesh[2]);
+	vao->dimensions = glm::vec3(header->dimensions[0], header->dimensions[1], header->dimensions[2]);
+	return vao;
+}
+
 void GraphicsManager::LoadOBJsToVAOs(std::vector<OBJ*>& parsedOBJs)
 {
 	for (auto& obj : parsedOBJs)
@@ -217,6 +290,7 @@ void GraphicsManager::LoadOBJsToVAOs(std::vector<OBJ*>& parsedOBJs)
 
 bool GraphicsManager::SaveToOBJ(OBJ* obj)
 {
+	LoadOBJStreams(obj);
 	FILE* file;
 	file = fopen("savedFile.obj", "w");
 	for (size_t i = 0; i < obj->indexed_vertices.size(); i++)
@@ -289,7 +363,9 @@ bool GraphicsManager::LoadTextures(const char* path)
 		return false;
 	}
 	//stbi_set_flip_vertically_on_load(true);
-	std::vector<std::thread> threadPool;
+	//images are decoded on the job system workers, only the upload has to stay on the thread owning the context
+	JobSystem* jobSystem = JobSystem::Instance();
+	std::vector<std::future<void>> decodes;
 	char line[128];
 	while (fgets(line, sizeof(line), file)) {
 		// Skip lines that start with ;, #, or /
@@ -298,19 +374,24 @@ bool GraphicsManager::LoadTextures(const char* path)
 		}
 
 		char texturePath[128];
-		int res = sscanf(line, "%s", texturePath);
+		int pathLength = 0;
+		int res = sscanf(line, "%s%n", texturePath, &pathLength);
 		if (res != 1) {
 			printf("Error reading line: %s\n", line);
 			continue;
 		}
+		//the rest of the line holds bake options like "srgb kaiser bc3"
+		TextureBakeSettings settings;
+		TextureCache::ParseSettings(line + pathLength, settings);
 
 		printf("Loading texture: %s\n", texturePath);
-		//threadPool.push_back(std::thread(LoadTextureInfo, &GraphicsStorage::texturesToLoad, GraphicsStorage::paths["resources"] + texturePath, 0));
-		LoadTextureInfo(&GraphicsStorage::texturesToLoad, GraphicsStorage::paths["resources"] + texturePath, 0);
+		std::string fullPath = GraphicsStorage::paths["resources"] + texturePath;
+		decodes.push_back(jobSystem->Submit([fullPath, settings]() { LoadTextureInfo(&GraphicsStorage::texturesToLoad, fullPath, settings); }));
 	}
-	for (auto& th : threadPool)
+	for (auto& decode : decodes)
 	{
-		th.join();
+		jobSystem->Wait(decode);
+		decode.get();
 	}
 	fclose(file);
 
@@ -318,9 +399,10 @@ bool GraphicsManager::LoadTextures(const char* path)
 	return true;
 }
 
-void GraphicsManager::LoadTextureInfo(std::unordered_map<std::string, TextureInfo*>* texturesToLoad, std::string path, int forcedNumOfEle)
+void GraphicsManager::LoadTextureInfo(std::unordered_map<std::string, TextureInfo*>* texturesToLoad, std::string path, const TextureBakeSettings& settings)
 {
-	TextureInfo* ti = SOIL_load_image(path.c_str(), forcedNumOfEle);
+	//baked textures come back as compressed dds with their whole mip chain, from the cache when the source did not change
+	TextureInfo* ti = TextureCache::Load(path, settings);
 	std::filesystem::path texturePath(path);
 	std::scoped_lock<std::mutex> lock(tiLoadMutex);
 	texturesToLoad->insert({ texturePath.string() , ti});
@@ -502,37 +584,14 @@ void GraphicsManager::GetFileNames(std::vector<std::string>& out, const char* di
 
 void GraphicsManager::RemoveComments(std::string& shaderCode)
 {
-	while (true)
-	{
-		size_t nFPos = shaderCode.find("/*");
-		if (nFPos + 1)
-		{
-			size_t second = shaderCode.find("*/", nFPos);
-			shaderCode.erase(nFPos, (second + 1) - nFPos);
-		}
-		else
-		{
-			break;
-		}
-	}
-	while (true)
-	{
-		size_t nFPos = shaderCode.find("//");
-		if (nFPos + 1)
-		{
-			size_t second = shaderCode.find("\n", nFPos);
-			shaderCode.erase(nFPos, second - nFPos);
-		}
-		else
-		{
-			break;
-		}
-	}
+	std::string source;
+	source.swap(shaderCode);
+	ShaderPreprocessor::StripComments(source, shaderCode);
 }
 
 bool GraphicsManager::LoadShaders(const char* path)
 {
-	//GraphicsStorage::ClearShaders();
+	//ClearShaders();
 	auto shadersPaths = LoadShadersPaths(LoadShadersFiles(path));
 
 	for (auto& paths : shadersPaths)
@@ -686,7 +745,24 @@ ShaderPaths GraphicsManager::LoadShaderPaths(const std::string& path)
 
 bool GraphicsManager::ReloadShaders()
 {
-	return LoadShaders("config/shaders.txt");
+	//only programs whose sources or includes changed since they were built are compiled again
+	auto shadersPaths = LoadShadersPaths(LoadShadersFiles("config/shaders.txt"));
+
+	std::unordered_set<std::string> outOfDate;
+	ShaderPreprocessor::GetOutOfDatePrograms(outOfDate);
+	for (auto& paths : shadersPaths)
+	{
+		const std::string& program = paths.second.path;
+		if (!ShaderPreprocessor::IsRecorded(program) || outOfDate.find(program) != outOfDate.end()) ReloadShaderFromPath(nullptr, paths.second);
+	}
+
+	return true;
+}
+
+void GraphicsManager::ClearShaders()
+{
+	GraphicsStorage::ClearShaders();
+	ShaderPreprocessor::Clear();
 }
 
 Shader* GraphicsManager::ReloadShader(Shader* shader)
@@ -709,9 +785,9 @@ Shader* GraphicsManager::ReloadShaderFromPath(const char* guid, const ShaderPath
 	std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
 	std::chrono::duration<double> elapsed_seconds;
 	start = std::chrono::high_resolution_clock::now();
-	std::string VertexShaderCode = std::move(ReadTextFileIntoString(paths.vs));
-	std::string FragmentShaderCode = std::move(ReadTextFileIntoString(paths.fs));
-	std::string GeometryShaderCode = std::move(ReadTextFileIntoString(paths.gs));
+	std::string VertexShaderCode = ReadTextFileIntoString(paths.vs);
+	std::string FragmentShaderCode = ReadTextFileIntoString(paths.fs);
+	std::string GeometryShaderCode = ReadTextFileIntoString(paths.gs);
 	std::unordered_set<std::string> vsIncludes;
 	std::unordered_set<std::string> fsIncludes;
 	std::unordered_set<std::string> gsIncludes;
@@ -766,6 +842,11 @@ Shader* GraphicsManager::ReloadShaderFromPath(const char* guid, const ShaderPath
 		GraphicsStorage::shaderPathsAndGuids[paths.path] = GraphicsStorage::assetRegistry.GetAssetIDAsString(shader);
 		GraphicsStorage::shaderIDs[name] = result;
 
+		std::unordered_set<std::string> includes = vsIncludes;
+		includes.insert(fsIncludes.begin(), fsIncludes.end());
+		includes.insert(gsIncludes.begin(), gsIncludes.end());
+		ShaderPreprocessor::RecordDependencies(paths.path, { paths.vs, paths.fs, paths.gs }, includes);
+
 		shader->Clear();
 		start = std::chrono::high_resolution_clock::now();
 		LoadBlocks(shader, BlockType::Uniform);
@@ -801,42 +882,25 @@ Shader* GraphicsManager::ReloadShaderFromPath(const char* guid, const ShaderPath
 	else
 	{
 		printf("\033[1;31mFailed to load shader: %s\033[0m\n", name.c_str());
+		//the includes it was built with may be recorded as current by other programs, so it is retried on every reload until it builds
+		ShaderPreprocessor::RemoveDependencies(paths.path);
 		return shader;
 	}
 }
 
 bool GraphicsManager::ReloadShaderCode(std::string& shaderCode, std::unordered_set<std::string>& shaderIncludes)
 {
-	RemoveComments(shaderCode);
-	LoadShaderIncludes(shaderCode, shaderIncludes);
+	std::string source;
+	source.swap(shaderCode);
+	ShaderPreprocessor::Preprocess(source, shaderCode, shaderIncludes);
 	return true;
 }
 
 bool GraphicsManager::LoadShaderIncludes(std::string& shaderCode, std::unordered_set<std::string>& shaderIncludes)
 {
-	while(true)
-	{
-		size_t nFPos = shaderCode.find("#include");
-		if (nFPos + 1)
-		{
-			size_t endInclude = shaderCode.find(";", nFPos);
-			std::string includeFile = shaderCode.substr(nFPos + 9, endInclude - (nFPos + 9));
-			std::string pathToIncludeFile = GraphicsStorage::paths["resources"] + "shaders/" + includeFile;
-			shaderCode.erase(nFPos, (endInclude + 1) - nFPos);
-			if (shaderIncludes.find(includeFile) == shaderIncludes.end())
-			{
-				shaderIncludes.insert(includeFile);
-				std::string includeShaderCode = std::move(ReadTextFileIntoString(pathToIncludeFile));
-				shaderCode.insert(nFPos, includeShaderCode);
-				ReloadShaderCode(pathToIncludeFile, shaderIncludes);
-			}
-		}
-		else
-		{
-			break;
-		}
-	}
-	return false;
+	size_t includeCount = shaderIncludes.size();
+	ReloadShaderCode(shaderCode, shaderIncludes);
+	return shaderIncludes.size() > includeCount;
 }
 
 void GraphicsManager::LoadBlocks(Shader* shader, BlockType type)
@@ -1156,17 +1220,7 @@ std::string GraphicsManager::ReadTextFileIntoString(const char* path)
 {
 	if (path != nullptr && strcmp(path, "") != 0)
 	{
-		// Read the Vertex Shader code from the file
-		std::string fileContent;
-		std::ifstream fileStream(path, std::ios::in);
-		if (fileStream.is_open())
-		{
-			std::string Line = "";
-			while (getline(fileStream, Line))
-				fileContent += Line + "\n";
-			fileStream.close();
-		}
-		return fileContent;
+		return ReadTextFileIntoString(std::string(path));
 	}
 	return std::string();
 }
@@ -1175,17 +1229,19 @@ std::string GraphicsManager::ReadTextFileIntoString(const std::string& path)
 {
 	if (path.length() > 0)
 	{
-		// Read the Vertex Shader code from the file
-		std::string fileContent;
 		std::ifstream fileStream(path, std::ios::in);
 		if (fileStream.is_open())
 		{
-			std::string Line = "";
-			while (getline(fileStream, Line))
-				fileContent += Line + "\n";
-			fileStream.close();
+			//one read of the whole file, text mode can shrink it so the content is cut to what was read
+			fileStream.seekg(0, std::ios::end);
+			std::streamoff size = fileStream.tellg();
+			fileStream.seekg(0, std::ios::beg);
+			std::string fileContent((size_t)size, '\0');
+			fileStream.read(&fileContent[0], size);
+			fileContent.resize((size_t)fileStream.gcount());
+			if (!fileContent.empty() && fileContent.back() != '\n') fileContent += '\n';
+			return fileContent;
 		}
-		return fileContent;
 	}
 	return std::string();
 }
@@ -1439,7 +1495,7 @@ Texture* GraphicsManager::LoadTexture(const char* guid, const char* path)
 	Texture* tex = nullptr;
 	
 	// we have to pass guid to these functions
-	ti = GraphicsManager::LoadImage(path, 0);
+	ti = TextureCache::Load(path, TextureBakeSettings());
 	return LoadTextureIntoGPU(guid, path, ti);
 
 	// next steps:
@@ -1466,6 +1522,9 @@ Texture* GraphicsManager::LoadCompressedDDS(Texture* tex, TextureInfo* ti, int i
 	case FOURCC_DXT5:
 		internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
 		break;
+	case FOURCC_ATI2:
+		internalFormat = GL_COMPRESSED_RG_RGTC2;
+		break;
 	default:
 		return nullptr;
 	}
@@ -6,12 +6,14 @@
 #include <thread>
 class Texture;
 class OBJ;
+class MeshCache;
 class Material;
 class VertexArray;
 class Shader;
 struct ShaderPaths;
 class FrameBuffer;
 struct TextureInfo;
+struct TextureBakeSettings;
 enum class BlockType;
 
 class GraphicsManager
@@ -24,13 +26,18 @@ public:
 	static void LoadAllAssets();
 	static bool LoadOBJs(const char* path, std::vector<OBJ*>& parsedOBJs);
 	static bool LoadOBJs(std::vector<std::string>& meshPaths, std::vector<OBJ*>& parsedOBJs);
-	static void LoadOBJ(std::vector<OBJ*>* objs, std::string path);
+	static OBJ* LoadOBJ(const std::string& path);
+	//fills an obj allocated by the caller and does not touch the asset registry, so it may run on a job
+	static bool ParseOBJ(const std::string& path, OBJ* obj);
+	//fills the cpu streams of an obj loaded from its mesh cache, anything reading them has to call this first
+	static bool LoadOBJStreams(OBJ* obj);
 	static void LoadOBJsToVAOs(std::vector<OBJ*>& parsedOBJs);
 	static bool SaveToOBJ(OBJ* objMesh);
 	static VertexArray* LoadOBJToVAO(OBJ* object, VertexArray* vao);
+	static VertexArray* LoadMeshCacheToVAO(const MeshCache& meshCache, VertexArray* vao);
 	//static void LoadAllOBJsToVAOs();
 	static bool LoadTextures(const char* path);
-	static void LoadTextureInfo(std::unordered_map<std::string, TextureInfo*>* texturesToLoad, std::string path, int forcedNumOfEle);
+	static void LoadTextureInfo(std::unordered_map<std::string, TextureInfo*>* texturesToLoad, std::string path, const TextureBakeSettings& settings);
 	static void LoadTexturesIntoGPU(std::unordered_map<std::string, TextureInfo*>& texturesToLoad);
 	static Texture* LoadTextureIntoGPU(const char* guid, const char* fileName, TextureInfo* ti);
 	static bool LoadShaders(const char* path);
@@ -39,6 +46,8 @@ public:
 	static std::unordered_map<std::string, ShaderPaths> LoadShadersPaths(const std::vector<std::string>& shaders);
 	static ShaderPaths LoadShaderPaths(const std::string& path);
 	static bool ReloadShaders();
+	//forgets the stored shaders together with the include graph recorded for them
+	static void ClearShaders();
 	static Shader* ReloadShader(Shader* shader);
 	static Shader* ReloadShaderFromPath(const char* name, const ShaderPaths& paths);
 	static bool ReloadShaderCode(std::string& shaderCode, std::unordered_set<std::string>& shaderIncludes);
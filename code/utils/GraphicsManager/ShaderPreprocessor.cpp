@@ -0,0 +1,186 @@
+#include "ShaderPreprocessor.h"
+#include "GraphicsManager.h"
+#include "GraphicsStorage.h"
+
+std::unordered_map<std::string, ShaderPreprocessor::CachedInclude> ShaderPreprocessor::includeCache;
+std::unordered_map<std::string, ShaderPreprocessor::ProgramRecord> ShaderPreprocessor::programDependencies;
+std::unordered_map<std::string, ShaderPreprocessor::IncludeRecord> ShaderPreprocessor::includeDependents;
+
+void ShaderPreprocessor::Preprocess(const std::string& source, std::string& out, std::unordered_set<std::string>& includes)
+{
+	Tokens tokens;
+	Tokenize(source, tokens, true);
+	Expand(tokens, out, includes);
+}
+
+void ShaderPreprocessor::StripComments(const std::string& source, std::string& out)
+{
+	Tokens tokens;
+	Tokenize(source, tokens, false);
+	out.append(tokens.segments[0]);
+}
+
+std::string ShaderPreprocessor::GetIncludePath(const std::string& includeName)
+{
+	return GraphicsStorage::paths["resources"] + "shaders/" + includeName;
+}
+
+void ShaderPreprocessor::RecordDependencies(const std::string& program, const std::vector<std::string>& sources, const std::unordered_set<std::string>& includes)
+{
+	RemoveDependencies(program);
+	ProgramRecord& record = programDependencies[program];
+	for (auto& source : sources)
+	{
+		if (!source.empty()) record.sources.push_back({ source, GetWriteTime(source) });
+	}
+	for (auto& includeName : includes)
+	{
+		//every dependent of a changed include is rebuilt in the same reload, so the include keeps a single time
+		IncludeRecord& include = includeDependents[includeName];
+		include.writeTime = GetWriteTime(GetIncludePath(includeName));
+		include.dependents.insert(program);
+		record.includeNames.push_back(includeName);
+	}
+}
+
+void ShaderPreprocessor::RemoveDependencies(const std::string& program)
+{
+	auto record = programDependencies.find(program);
+	if (record == programDependencies.end()) return;
+	for (auto& includeName : record->second.includeNames)
+	{
+		auto include = includeDependents.find(includeName);
+		if (include == includeDependents.end()) continue;
+		include->second.dependents.erase(program);
+		if (include->second.dependents.empty()) includeDependents.erase(include);
+	}
+	programDependencies.erase(record);
+}
+
+bool ShaderPreprocessor::IsRecorded(const std::string& program)
+{
+	return programDependencies.find(program) != programDependencies.end();
+}
+
+void ShaderPreprocessor::GetOutOfDatePrograms(std::unordered_set<std::string>& programs)
+{
+	for (auto& include : includeDependents)
+	{
+		if (GetWriteTime(GetIncludePath(include.first)) != include.second.writeTime)
+		{
+			programs.insert(include.second.dependents.begin(), include.second.dependents.end());
+		}
+	}
+	for (auto& record : programDependencies)
+	{
+		if (programs.find(record.first) != programs.end()) continue;
+		for (auto& source : record.second.sources)
+		{
+			if (GetWriteTime(source.path) != source.writeTime)
+			{
+				programs.insert(record.first);
+				break;
+			}
+		}
+	}
+}
+
+void ShaderPreprocessor::Clear()
+{
+	includeCache.clear();
+	programDependencies.clear();
+	includeDependents.clear();
+}
+
+void ShaderPreprocessor::Tokenize(const std::string& source, Tokens& tokens, bool splitIncludes)
+{
+	tokens.segments.assign(1, std::string());
+	tokens.includeNames.clear();
+	std::string* segment = &tokens.segments.back();
+	segment->reserve(source.size());
+
+	//text between copyStart and i is kept and copied in one go when a comment or directive starts
+	const char* interesting = splitIncludes ? "/#" : "/";
+	size_t length = source.size();
+	size_t copyStart = 0;
+	size_t i = source.find_first_of(interesting);
+	while (i < length)
+	{
+		char next = i + 1 < length ? source[i + 1] : '\0';
+		if (source[i] == '/' && next == '*')
+		{
+			segment->append(source, copyStart, i - copyStart);
+			size_t end = source.find("*/", i + 2);
+			i = end == std::string::npos ? length : end + 2;
+			copyStart = i;
+		}
+		else if (source[i] == '/' && next == '/')
+		{
+			//the newline ending the comment is kept
+			segment->append(source, copyStart, i - copyStart);
+			size_t end = source.find('\n', i + 2);
+			i = end == std::string::npos ? length : end;
+			copyStart = i;
+		}
+		else if (source[i] == '#' && source.compare(i, 8, "#include") == 0 && source.find(';', i + 8) != std::string::npos)
+		{
+			segment->append(source, copyStart, i - copyStart);
+			size_t end = source.find(';', i + 8);
+			size_t nameStart = source.find_first_not_of(" \t", i + 8);
+			size_t nameEnd = source.find_last_not_of(" \t\r\n", end - 1);
+			tokens.includeNames.push_back(nameStart < end && nameEnd >= nameStart ? source.substr(nameStart, nameEnd + 1 - nameStart) : std::string());
+			tokens.segments.emplace_back();
+			segment = &tokens.segments.back();
+			i = end + 1;
+			copyStart = i;
+		}
+		else
+		{
+			i++;
+		}
+		if (i < length) i = source.find_first_of(interesting, i);
+	}
+	segment->append(source, copyStart, length - copyStart);
+}
+
+void ShaderPreprocessor::Expand(const Tokens& tokens, std::string& out, std::unordered_set<std::string>& includes)
+{
+	out.append(tokens.segments[0]);
+	for (size_t i = 0; i < tokens.includeNames.size(); i++)
+	{
+		const std::string& includeName = tokens.includeNames[i];
+		//inserted before expanding so an include cycle stops here
+		if (includes.insert(includeName).second)
+		{
+			const CachedInclude* include = GetInclude(includeName);
+			if (include != nullptr) Expand(include->tokens, out, includes);
+		}
+		out.append(tokens.segments[i + 1]);
+	}
+}
+
+const ShaderPreprocessor::CachedInclude* ShaderPreprocessor::GetInclude(const std::string& includeName)
+{
+	std::string path = GetIncludePath(includeName);
+	std::filesystem::file_time_type writeTime = GetWriteTime(path);
+	auto cached = includeCache.find(path);
+	if (cached != includeCache.end() && cached->second.writeTime == writeTime) return &cached->second;
+
+	std::string source = GraphicsManager::ReadTextFileIntoString(path);
+	if (source.empty())
+	{
+		printf("\033[1;31mShader include %s could not be read\033[0m\n", path.c_str());
+		return nullptr;
+	}
+	CachedInclude& include = includeCache[path];
+	include.writeTime = writeTime;
+	Tokenize(source, include.tokens, true);
+	return &include;
+}
+
+std::filesystem::file_time_type ShaderPreprocessor::GetWriteTime(const std::string& path)
+{
+	std::error_code error;
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+	return error ? std::filesystem::file_time_type::min() : writeTime;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+
+//strips comments and expands "#include name;" directives in one pass over the source
+//included files are preprocessed once and cached until their modification time changes
+//programs record the files they were built from so a reload can skip the ones that did not change
+class ShaderPreprocessor
+{
+public:
+	//appends the preprocessed source to out, names already in includes are not included again
+	static void Preprocess(const std::string& source, std::string& out, std::unordered_set<std::string>& includes);
+	//appends the source without comments to out, include directives are kept as they are
+	static void StripComments(const std::string& source, std::string& out);
+	static std::string GetIncludePath(const std::string& includeName);
+
+	//remembers the sources and includes a program was built from together with their modification times
+	static void RecordDependencies(const std::string& program, const std::vector<std::string>& sources, const std::unordered_set<std::string>& includes);
+	//drops the program so it counts as never built, used when it fails to build
+	static void RemoveDependencies(const std::string& program);
+	static bool IsRecorded(const std::string& program);
+	//adds the programs whose sources changed and every dependent of a changed include, each include is checked once
+	static void GetOutOfDatePrograms(std::unordered_set<std::string>& programs);
+	static void Clear();
+private:
+	//comment free text split at the include directives, segments has one more element than includeNames
+	struct Tokens
+	{
+		std::vector<std::string> segments;
+		std::vector<std::string> includeNames;
+	};
+
+	struct CachedInclude
+	{
+		std::filesystem::file_time_type writeTime;
+		Tokens tokens;
+	};
+
+	struct FileStamp
+	{
+		std::string path;
+		std::filesystem::file_time_type writeTime;
+	};
+
+	struct ProgramRecord
+	{
+		std::vector<FileStamp> sources;
+		std::vector<std::string> includeNames;
+	};
+
+	struct IncludeRecord
+	{
+		std::filesystem::file_time_type writeTime;
+		std::unordered_set<std::string> dependents;
+	};
+
+	static void Tokenize(const std::string& source, Tokens& tokens, bool splitIncludes);
+	static void Expand(const Tokens& tokens, std::string& out, std::unordered_set<std::string>& includes);
+	static const CachedInclude* GetInclude(const std::string& includeName);
+	static std::filesystem::file_time_type GetWriteTime(const std::string& path);
+
+	static std::unordered_map<std::string, CachedInclude> includeCache;
+	static std::unordered_map<std::string, ProgramRecord> programDependencies;
+	static std::unordered_map<std::string, IncludeRecord> includeDependents;
+};
@@ -0,0 +1,161 @@
+#include "JobSystem.h"
+
+static thread_local unsigned int currentThreadIndex = 0;
+
+JobSystem::JobSystem()
+{
+	stopping = false;
+	pendingJobs = 0;
+	nextSubmitQueue = 0;
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	unsigned int workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	for (unsigned int i = 0; i < workerCount + 1; i++)
+	{
+		queues.push_back(std::make_unique<JobQueue>());
+	}
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::scoped_lock<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	sleepCondition.notify_all();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+JobSystem* JobSystem::Instance()
+{
+	static JobSystem instance;
+
+	return &instance;
+}
+
+void JobSystem::WorkerLoop(unsigned int threadIndex)
+{
+	currentThreadIndex = threadIndex;
+	while (true)
+	{
+		std::function<void()> job;
+		if (Pop(threadIndex, job))
+		{
+			job();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCondition.wait(lock, [this] { return stopping || pendingJobs.load() > 0; });
+		if (stopping && pendingJobs.load() == 0) return;
+	}
+}
+
+void JobSystem::Push(unsigned int queueIndex, std::function<void()> job)
+{
+	JobQueue& queue = *queues[queueIndex];
+	{
+		std::scoped_lock<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	pendingJobs.fetch_add(1);
+	//taking the sleep mutex makes sure a worker that just saw no jobs is already waiting before we notify
+	{
+		std::scoped_lock<std::mutex> lock(sleepMutex);
+	}
+	sleepCondition.notify_one();
+}
+
+bool JobSystem::Pop(unsigned int threadIndex, std::function<void()>& job)
+{
+	unsigned int queueCount = (unsigned int)queues.size();
+	for (unsigned int i = 0; i < queueCount; i++)
+	{
+		unsigned int queueIndex = (threadIndex + i) % queueCount;
+		JobQueue& queue = *queues[queueIndex];
+		std::scoped_lock<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty()) continue;
+		if (i == 0)
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+		else
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+		pendingJobs.fetch_sub(1);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t, unsigned int)>& job)
+{
+	if (count == 0) return;
+	if (chunkSize == 0) chunkSize = 1;
+	size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	if (workers.empty() || chunkCount == 1)
+	{
+		job(0, count, currentThreadIndex);
+		return;
+	}
+
+	//shared so a helper that wakes up after all chunks are done does not touch a dead stack frame
+	struct ForState
+	{
+		std::atomic<size_t> nextChunk{ 0 };
+		std::atomic<size_t> doneChunks{ 0 };
+	};
+	auto state = std::make_shared<ForState>();
+
+	auto runChunks = [state, chunkCount, chunkSize, count, &job]()
+	{
+		size_t chunk;
+		while ((chunk = state->nextChunk.fetch_add(1)) < chunkCount)
+		{
+			size_t begin = chunk * chunkSize;
+			size_t end = std::min(begin + chunkSize, count);
+			job(begin, end, currentThreadIndex);
+			state->doneChunks.fetch_add(1, std::memory_order_release);
+		}
+	};
+
+	//one helper per worker queue, idle workers steal helpers queued on busy ones
+	size_t helpers = std::min((size_t)workers.size(), chunkCount - 1);
+	unsigned int callerIndex = currentThreadIndex;
+	for (size_t i = 0; i < helpers; i++)
+	{
+		//helpers only capture the shared state, job is referenced only while chunks remain
+		unsigned int queueIndex = 1 + (unsigned int)((callerIndex + i) % workers.size());
+		Push(queueIndex, [state, runChunks]() { runChunks(); });
+	}
+
+	runChunks();
+	while (state->doneChunks.load(std::memory_order_acquire) < chunkCount)
+	{
+		std::this_thread::yield();
+	}
+}
+
+unsigned int JobSystem::GetWorkerCount()
+{
+	return (unsigned int)workers.size();
+}
+
+unsigned int JobSystem::GetThreadCount()
+{
+	return (unsigned int)workers.size() + 1;
+}
+
+unsigned int JobSystem::GetThreadIndex()
+{
+	return currentThreadIndex;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <future>
+#include <type_traits>
+#include <chrono>
+
+//fixed size pool of worker threads, created once and reused every frame
+//work is handed out either as chunks of a parallel for or as single jobs returning a future
+//thread index 0 is the thread calling into the job system, workers are 1..GetWorkerCount()
+//every thread owns a queue, a thread pops from the front of its own queue and steals from the back of the others when it runs dry
+class JobSystem
+{
+public:
+	static JobSystem* Instance();
+
+	//splits [0, count) into chunks of chunkSize and runs job(begin, end, threadIndex) on the workers and the calling thread
+	//returns when all chunks are done
+	void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t, unsigned int)>& job);
+
+	//queues function on a worker and returns a future for its result, runs it right away when there are no workers
+	template <typename Function>
+	std::future<std::invoke_result_t<Function>> Submit(Function&& function)
+	{
+		using Result = std::invoke_result_t<Function>;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+		std::future<Result> future = task->get_future();
+		if (workers.empty())
+		{
+			(*task)();
+			return future;
+		}
+		unsigned int queueIndex = 1 + nextSubmitQueue.fetch_add(1) % (unsigned int)workers.size();
+		Push(queueIndex, [task]() { (*task)(); });
+		return future;
+	}
+
+	//runs queued jobs on the calling thread until the future is ready so waiting never leaves a core idle
+	template <typename Result>
+	void Wait(std::future<Result>& future)
+	{
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			std::function<void()> job;
+			if (Pop(GetThreadIndex(), job))
+			{
+				job();
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	unsigned int GetWorkerCount();
+	unsigned int GetThreadCount();
+	static unsigned int GetThreadIndex();
+private:
+	JobSystem();
+	~JobSystem();
+	//copy
+	JobSystem(const JobSystem&);
+	//assign
+	JobSystem& operator=(const JobSystem&);
+
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> jobs;
+	};
+
+	void WorkerLoop(unsigned int threadIndex);
+	void Push(unsigned int queueIndex, std::function<void()> job);
+	bool Pop(unsigned int threadIndex, std::function<void()>& job);
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<JobQueue>> queues;
+	std::atomic<unsigned int> pendingJobs;
+	std::atomic<unsigned int> nextSubmitQueue;
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	bool stopping;
+};
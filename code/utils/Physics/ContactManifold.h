@@ -0,0 +1,42 @@
+#pragma once
+#include "MyMathLib.h"
+#include <vector>
+
+class RigidBody;
+
+//contact point kept between frames so the solver can warm start from last frame's impulses
+//localPoint is the contact point in the box space of the first body of the pair
+struct CachedContact
+{
+	glm::vec3 localPoint;
+	float normalImpulse = 0.f;
+	float tangentImpulse1 = 0.f;
+	float tangentImpulse2 = 0.f;
+};
+
+struct ContactManifold
+{
+	std::vector<CachedContact> points;
+	unsigned int frame = 0;
+};
+
+//one contact prepared for the sequential impulse solver
+struct SolverContact
+{
+	RigidBody* one;
+	RigidBody* two;
+	glm::vec3 rA;
+	glm::vec3 rB;
+	glm::vec3 normal;
+	glm::vec3 tangent1;
+	glm::vec3 tangent2;
+	float normalMass;
+	float tangentMass1;
+	float tangentMass2;
+	float bias;
+	float friction;
+	float normalImpulse;
+	float tangentImpulse1;
+	float tangentImpulse2;
+	CachedContact* cached;
+};
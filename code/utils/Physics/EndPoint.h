@@ -0,0 +1,14 @@
+#pragma once
+
+//sweep and prune endpoint stored by value in contiguous per axis arrays
+//body index and min/max flag are packed together so the whole endpoint is 8 bytes
+struct EndPoint
+{
+	float value = 0.f;
+	unsigned int data = 0;
+	EndPoint(){}
+	EndPoint(unsigned int bodyIndex, bool min){ data = bodyIndex | (min ? minFlag : 0u); }
+	unsigned int GetBodyIndex() const { return data & ~minFlag; }
+	bool IsMin() const { return (data & minFlag) != 0; }
+	static const unsigned int minFlag = 0x80000000u;
+};
@@ -0,0 +1,44 @@
+#include "IslandBuilder.h"
+
+IslandBuilder::IslandBuilder()
+{
+}
+
+IslandBuilder::~IslandBuilder()
+{
+}
+
+void IslandBuilder::Reset(unsigned int bodyCount)
+{
+	parents.resize(bodyCount);
+	sizes.assign(bodyCount, 1);
+	for (unsigned int i = 0; i < bodyCount; i++)
+	{
+		parents[i] = i;
+	}
+}
+
+unsigned int IslandBuilder::Find(unsigned int body)
+{
+	while (parents[body] != body)
+	{
+		parents[body] = parents[parents[body]];
+		body = parents[body];
+	}
+	return body;
+}
+
+void IslandBuilder::Unite(unsigned int a, unsigned int b)
+{
+	unsigned int rootA = Find(a);
+	unsigned int rootB = Find(b);
+	if (rootA == rootB) return;
+	if (sizes[rootA] < sizes[rootB])
+	{
+		unsigned int temp = rootA;
+		rootA = rootB;
+		rootB = temp;
+	}
+	parents[rootB] = rootA;
+	sizes[rootA] += sizes[rootB];
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <vector>
+
+//union-find over body indices, bodies touching through overlap pairs end up in the same island
+//union by size and path halving keep every Find close to constant time
+class IslandBuilder
+{
+public:
+	IslandBuilder();
+	~IslandBuilder();
+	void Reset(unsigned int bodyCount);
+	void Unite(unsigned int a, unsigned int b);
+	unsigned int Find(unsigned int body);
+private:
+	std::vector<unsigned int> parents;
+	std::vector<unsigned int> sizes;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "Object.h"
 #include "RigidBody.h"
+#include "PairTable.h"
 /*
 //fast hash function for pointers
 template<typename Tval>
@@ -28,10 +29,9 @@ namespace std
 	{
 	public:
 		size_t operator()(const OverlapPair &overlapPair) const{
-			//Vector3* pos1 = &(overlapPair.ent1->GetPosition());
-			//Vector3* pos2 = &(overlapPair.ent2->GetPosition());
-			return overlapPair.rbody1->object->ID ^ overlapPair.rbody2->object->ID;//(pos1->a^pos1->b^pos1->c) + (pos2->a^pos2->b^pos2->c);
-			//return overlapPair.ent1->ID + overlapPair.ent2->ID;
+			//ID1 ^ ID2 sent (a,b) and (b,a) and any equal IDs to the same buckets
+			//ordered key keeps the symmetry equal_to needs and mixes both IDs
+			return PairTable::Hash(PairTable::Key(overlapPair.rbody1->object->ID, overlapPair.rbody2->object->ID));
 		}
 	};
 
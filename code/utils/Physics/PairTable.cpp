@@ -0,0 +1,103 @@
+#include "PairTable.h"
+
+PairTable::PairTable()
+{
+	mask = 0;
+	Rehash(64);
+}
+
+PairTable::~PairTable()
+{
+}
+
+//returns the slot holding the key or the empty slot where it would be inserted
+size_t PairTable::FindSlot(uint64_t key) const
+{
+	size_t slot = Hash(key) & mask;
+	while (slots[slot].key != emptyKey && slots[slot].key != key)
+	{
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+bool PairTable::Add(unsigned int a, unsigned int b)
+{
+	if (a == b) return false;
+	uint64_t key = Key(a, b);
+	size_t slot = FindSlot(key);
+	if (slots[slot].key == key) return false;
+
+	slots[slot].key = key;
+	slots[slot].pairIndex = (unsigned int)pairs.size();
+	pairs.emplace_back(a, b);
+
+	//keep load factor at or below one half so probe sequences stay short
+	if (pairs.size() * 2 > slots.size()) Rehash(slots.size() * 2);
+	return true;
+}
+
+bool PairTable::Remove(unsigned int a, unsigned int b)
+{
+	uint64_t key = Key(a, b);
+	size_t slot = FindSlot(key);
+	if (slots[slot].key != key) return false;
+
+	//move last pair into the hole of the dense array and repoint its slot
+	unsigned int pairIndex = slots[slot].pairIndex;
+	const BodyPair& last = pairs.back();
+	uint64_t lastKey = Key(last.minIndex, last.maxIndex);
+	if (lastKey != key)
+	{
+		slots[FindSlot(lastKey)].pairIndex = pairIndex;
+		pairs[pairIndex] = last;
+	}
+	pairs.pop_back();
+
+	//backward shift deletion
+	size_t hole = slot;
+	size_t next = slot;
+	while (true)
+	{
+		next = (next + 1) & mask;
+		if (slots[next].key == emptyKey) break;
+		size_t ideal = Hash(slots[next].key) & mask;
+		//entry can move into the hole if its ideal slot is not in (hole, next]
+		bool canMove = hole <= next ? (ideal <= hole || ideal > next) : (ideal <= hole && ideal > next);
+		if (canMove)
+		{
+			slots[hole] = slots[next];
+			hole = next;
+		}
+	}
+	slots[hole].key = emptyKey;
+	return true;
+}
+
+bool PairTable::Contains(unsigned int a, unsigned int b) const
+{
+	uint64_t key = Key(a, b);
+	return slots[FindSlot(key)].key == key;
+}
+
+void PairTable::Clear()
+{
+	pairs.clear();
+	for (auto& slot : slots)
+	{
+		slot.key = emptyKey;
+	}
+}
+
+void PairTable::Rehash(size_t newCapacity)
+{
+	slots.assign(newCapacity, Slot{ emptyKey, 0 });
+	mask = newCapacity - 1;
+	for (unsigned int i = 0; i < pairs.size(); i++)
+	{
+		uint64_t key = Key(pairs[i].minIndex, pairs[i].maxIndex);
+		size_t slot = FindSlot(key);
+		slots[slot].key = key;
+		slots[slot].pairIndex = i;
+	}
+}
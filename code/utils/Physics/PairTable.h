@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct BodyPair
+{
+	unsigned int minIndex;
+	unsigned int maxIndex;
+	BodyPair(unsigned int a, unsigned int b)
+	{
+		minIndex = a < b ? a : b;
+		maxIndex = a < b ? b : a;
+	}
+};
+
+//open addressing (linear probing) set of body pairs keyed by the ordered (minIndex, maxIndex)
+//every slot keeps the index of its pair in the dense pairs array
+//so the narrowphase can walk the pairs linearly without touching the hash slots
+//removal uses backward shift deletion, no tombstones are left behind
+class PairTable
+{
+public:
+	PairTable();
+	~PairTable();
+	bool Add(unsigned int a, unsigned int b);
+	bool Remove(unsigned int a, unsigned int b);
+	bool Contains(unsigned int a, unsigned int b) const;
+	void Clear();
+	size_t Size() const { return pairs.size(); }
+	const std::vector<BodyPair>& GetPairs() const { return pairs; }
+
+	static uint64_t Key(unsigned int a, unsigned int b);
+	static size_t Hash(uint64_t key);
+private:
+	struct Slot
+	{
+		uint64_t key;
+		unsigned int pairIndex;
+	};
+	static const uint64_t emptyKey = UINT64_MAX;
+	size_t FindSlot(uint64_t key) const;
+	void Rehash(size_t newCapacity);
+	std::vector<Slot> slots;
+	std::vector<BodyPair> pairs;
+	size_t mask;
+};
+
+inline uint64_t PairTable::Key(unsigned int a, unsigned int b)
+{
+	return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+inline size_t PairTable::Hash(uint64_t key)
+{
+	//murmur3 finalizer, spreads both indices over all bits
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return (size_t)key;
+}
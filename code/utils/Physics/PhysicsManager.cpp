@@ -7,6 +7,7 @@
 #include "Line.h"
 #include "Point.h"
 #include "GraphicsStorage.h"
+#include "JobSystem.h"
 
 using namespace std;
 
@@ -14,6 +15,16 @@ PhysicsManager::PhysicsManager()
 {
 	defObbColor = glm::vec3(0.f, 0.8f, 0.8f);
 	defAabbColor = glm::vec3(1.f, 0.54f, 0.f);
+	sweepSwaps = 0;
+	pairsAdded = 0;
+	pairsRemoved = 0;
+	islandCount = 0;
+	sleepingIslandCount = 0;
+	islandTime = 0.0;
+	solverIterationsUsed = 0;
+	solverResidual = 0.0;
+	solverFrame = 0;
+	contactBuffers.resize(JobSystem::Instance()->GetThreadCount());
 	GraphicsStorage::assetRegistry.RegisterType<ObjectPoint>();
 }
 
@@ -123,7 +134,7 @@ void PhysicsManager::SortAxis(std::vector<ObjectPoint*>& axisList, axis axis)
 						if (CheckBoundingBoxes(objToSwap->body, currentObject->body))
 						{
 							//fullOverlaps.insert(op);
-							fullOverlaps.insert(OverlapPair(objToSwap->body, currentObject->body));
+							if (fullOverlaps.insert(OverlapPair(objToSwap->body, currentObject->body)).second) pairsAdded++;
 						}
 					}
 				//}
@@ -131,7 +142,7 @@ void PhysicsManager::SortAxis(std::vector<ObjectPoint*>& axisList, axis axis)
 
 			else if (!currentObject->isMin && objToSwap->isMin) //separation
 			{
-				fullOverlaps.erase(OverlapPair(objToSwap->body, currentObject->body));
+				pairsRemoved += (int)fullOverlaps.erase(OverlapPair(objToSwap->body, currentObject->body));
 				//satOverlaps.erase(OverlapPair(objToSwap->body, currentObject->body));
 				//currentObject->body->aabb.color = defAabbColor;
 				//objToSwap->body->aabb.color = defAabbColor;
@@ -139,11 +150,77 @@ void PhysicsManager::SortAxis(std::vector<ObjectPoint*>& axisList, axis axis)
 
 			axisList[i + 1] = objToSwap;
 			i = i - 1;
+			sweepSwaps++;
 		}
 		axisList[i + 1] = currentObject;
 	}
 }
 
+void PhysicsManager::RefreshEndPoints()
+{
+	//bounds are already updated for this frame, copy them once into contiguous storage
+	size_t bodyCount = bodies.size();
+	for (size_t i = 0; i < bodyCount; i++)
+	{
+		const Bounds* bounds = bodies[i]->object->bounds;
+		bodyBoundsChanged[i] = bounds->version != bodyBoundsVersions[i];
+		if (!bodyBoundsChanged[i]) continue;
+		bodyBoundsVersions[i] = bounds->version;
+		bodyBounds[i] = bounds->obb.mm;
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (auto& endPoint : endPoints[axis])
+		{
+			unsigned int bodyIndex = endPoint.GetBodyIndex();
+			if (!bodyBoundsChanged[bodyIndex]) continue;
+			const MinMax& mm = bodyBounds[bodyIndex];
+			endPoint.value = endPoint.IsMin() ? mm.min[axis] : mm.max[axis];
+		}
+	}
+}
+
+void PhysicsManager::SortEndPoints(std::vector<EndPoint>& axisList)
+{
+	//same insertion sort as SortAxis but on values stored in the endpoints
+	//frame to frame coherence keeps the number of swaps low
+	EndPoint* points = axisList.data();
+	int axisListLen = (int)axisList.size();
+	for (int j = 1; j < axisListLen; j++)
+	{
+		EndPoint currentPoint = points[j];
+
+		int i = j - 1;
+		while (i >= 0 && points[i].value > currentPoint.value)
+		{
+			EndPoint pointToSwap = points[i];
+
+			if (currentPoint.IsMin() && !pointToSwap.IsMin()) //penetration
+			{
+				unsigned int body1 = pointToSwap.GetBodyIndex();
+				unsigned int body2 = currentPoint.GetBodyIndex();
+				if (!bodies[body1]->GetIsKinematic() || !bodies[body2]->GetIsKinematic())
+				{
+					if (CheckBoundingBoxes(body1, body2))
+					{
+						if (pairTable.Add(body1, body2)) pairsAdded++;
+					}
+				}
+			}
+			else if (!currentPoint.IsMin() && pointToSwap.IsMin()) //separation
+			{
+				if (pairTable.Remove(pointToSwap.GetBodyIndex(), currentPoint.GetBodyIndex())) pairsRemoved++;
+			}
+
+			points[i + 1] = pointToSwap;
+			i = i - 1;
+			sweepSwaps++;
+		}
+		points[i + 1] = currentPoint;
+	}
+}
+
 bool PhysicsManager::CheckBoundingBoxes(RigidBody* body1, RigidBody* body2)
 {
 	MinMax& box1 = body1->object->bounds->obb.mm;
@@ -155,6 +232,17 @@ bool PhysicsManager::CheckBoundingBoxes(RigidBody* body1, RigidBody* body2)
 		((box1.max.x >= box2.min.x) && (box1.min.x <= box2.max.x)));
 }
 
+bool PhysicsManager::CheckBoundingBoxes(unsigned int body1, unsigned int body2)
+{
+	const MinMax& box1 = bodyBounds[body1];
+	const MinMax& box2 = bodyBounds[body2];
+
+	return ((
+		((box1.max.z >= box2.min.z) && (box1.min.z <= box2.max.z)) &&
+		((box1.max.y >= box2.min.y) && (box1.min.y <= box2.max.y))) &&
+		((box1.max.x >= box2.min.x) && (box1.min.x <= box2.max.x)));
+}
+
 void PhysicsManager::RegisterRigidBody(RigidBody* body)
 {	
 	ObjectPoint* objectPoint = GraphicsStorage::assetRegistry.AllocAsset<ObjectPoint>();
@@ -188,14 +276,39 @@ void PhysicsManager::RegisterRigidBody(RigidBody* body)
 	objectPoint->body = body;
 	objectPoint->isMin = false;
 	zAxis.push_back(objectPoint);
+
+	unsigned int bodyIndex = (unsigned int)bodies.size();
+	bodies.push_back(body);
+	bodyIndices[body] = bodyIndex;
+	bodyBounds.push_back(body->object->bounds->obb.mm);
+	//one behind so the first refresh writes the endpoints of the new body
+	bodyBoundsVersions.push_back(body->object->bounds->version - 1);
+	bodyBoundsChanged.push_back(1);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		endPoints[axis].emplace_back(bodyIndex, true);
+		endPoints[axis].emplace_back(bodyIndex, false);
+	}
 }
 
 void  PhysicsManager::SortAndSweep()
 {
-
-	SortAxis(xAxis, x);
-	SortAxis(yAxis, y);
-	SortAxis(zAxis, z);
+	sweepSwaps = 0;
+	pairsAdded = 0;
+	pairsRemoved = 0;
+	if (useEndPointArrays)
+	{
+		RefreshEndPoints();
+		SortEndPoints(endPoints[x]);
+		SortEndPoints(endPoints[y]);
+		SortEndPoints(endPoints[z]);
+	}
+	else
+	{
+		SortAxis(xAxis, x);
+		SortAxis(yAxis, y);
+		SortAxis(zAxis, z);
+	}
 	//printf("\nBroad: number of overlaps: %d\n", fullOverlaps.size());
 }
 
@@ -252,19 +365,19 @@ bool PhysicsManager::IntersectionTest(const RigidBody* oneObj, const RigidBody*
 }
 #undef TEST_OVERLAP
 
-void PhysicsManager::GenerateContacts(glm::vec3& MTV, const double& penetration, glm::vec3& toCentre, RigidBody* oneObj, RigidBody* twoObj, int axisNumRes, int& bestSingleAxis)
+void PhysicsManager::GenerateContacts(ContactBuffer& buffer, glm::vec3& MTV, const double& penetration, glm::vec3& toCentre, RigidBody* oneObj, RigidBody* twoObj, int axisNumRes, int& bestSingleAxis)
 {
 	if (axisNumRes < 3)
 	{
-		GenerateContactPointToFace(toCentre, MTV, penetration, oneObj, twoObj, axisNumRes);
+		GenerateContactPointToFace(buffer, toCentre, MTV, penetration, oneObj, twoObj, axisNumRes);
 	}
 	else if (axisNumRes < 6)
 	{
-		GenerateContactPointToFace(-1.0f*toCentre, MTV, penetration, twoObj, oneObj, axisNumRes - 3);
+		GenerateContactPointToFace(buffer, -1.0f*toCentre, MTV, penetration, twoObj, oneObj, axisNumRes - 3);
 	}
 	else
 	{
-		GenerateContactEdgeToEdge(toCentre, MTV, penetration, oneObj, twoObj, axisNumRes, bestSingleAxis);
+		GenerateContactEdgeToEdge(buffer, toCentre, MTV, penetration, oneObj, twoObj, axisNumRes, bestSingleAxis);
 	}
 }
 
@@ -278,105 +391,508 @@ void PhysicsManager::NarrowTestSAT(double dtInv)
 	//therefore i need to handle removal of the non colliding obbs by sat here too
 
 	//printf("\nnumber of AABB overlaps: %d", fullOverlaps.size());
+	bool parallel = useParallelNarrowPhase && JobSystem::Instance()->GetWorkerCount() > 0;
+	if (useIterativeSolver)
+	{
+		GeneratePairContacts(parallel);
+		SolveContacts(dtInv);
+		return;
+	}
+	if (parallel)
+	{
+		NarrowTestSATParallel(dtInv);
+		return;
+	}
+
+	ContactBuffer& buffer = contactBuffers[0];
+	buffer.iterCount = 0;
+	if (useEndPointArrays)
+	{
+		iterCount = (int)pairTable.Size();
+		for (auto& pair : pairTable.GetPairs())
+		{
+			if (IsPairSleeping(bodies[pair.minIndex], bodies[pair.maxIndex])) continue;
+			NarrowTestPair(bodies[pair.minIndex], bodies[pair.maxIndex], dtInv);
+		}
+	}
+	else
+	{
+		iterCount = (int)fullOverlaps.size();
+		for (auto& pair : fullOverlaps)
+		{
+			if (IsPairSleeping(pair.rbody1, pair.rbody2)) continue;
+			NarrowTestPair(pair.rbody1, pair.rbody2, dtInv);
+		}
+	}
+	iterCount += buffer.iterCount;
+	//printf("\nnumber of SAT overlaps: %d", satOverlaps.size());
+}
+
+bool PhysicsManager::IsPairSleeping(RigidBody* one, RigidBody* two)
+{
+	if (!useIslandSleeping) return false;
+	bool oneSleeping = !one->isAwake || one->GetIsKinematic();
+	bool twoSleeping = !two->isAwake || two->GetIsKinematic();
+	return oneSleeping && twoSleeping;
+}
+
+void PhysicsManager::UpdateIslands()
+{
+	islandCount = 0;
+	sleepingIslandCount = 0;
+	if (!useIslandSleeping) return;
+
+	unsigned int bodyCount = (unsigned int)bodies.size();
+	islandBuilder.Reset(bodyCount);
+
+	//kinematic bodies do not join islands, otherwise the ground would connect every pile in the scene
+	auto unite = [this](RigidBody* one, RigidBody* two, unsigned int a, unsigned int b)
+	{
+		if (!one->GetIsKinematic() && !two->GetIsKinematic()) islandBuilder.Unite(a, b);
+	};
+	if (useEndPointArrays)
+	{
+		for (auto& pair : pairTable.GetPairs())
+		{
+			unite(bodies[pair.minIndex], bodies[pair.maxIndex], pair.minIndex, pair.maxIndex);
+		}
+	}
+	else
+	{
+		for (auto& pair : fullOverlaps)
+		{
+			unite(pair.rbody1, pair.rbody2, bodyIndices[pair.rbody1], bodyIndices[pair.rbody2]);
+		}
+	}
+
+	//an island is restless when any of its bodies is awake and still moving or is not allowed to sleep
+	islandRestless.assign(bodyCount, 0);
+	for (unsigned int i = 0; i < bodyCount; i++)
+	{
+		RigidBody* body = bodies[i];
+		if (body->GetIsKinematic()) continue;
+		unsigned int root = islandBuilder.Find(i);
+		if (root == i) islandCount++;
+		if (body->isAwake && (!body->GetCanSleep() || !body->IsResting())) islandRestless[root] = 1;
+	}
+
+	for (unsigned int i = 0; i < bodyCount; i++)
+	{
+		RigidBody* body = bodies[i];
+		if (body->GetIsKinematic()) continue;
+		unsigned int root = islandBuilder.Find(i);
+		if (islandRestless[root])
+		{
+			if (!body->isAwake) body->SetAwake();
+		}
+		else
+		{
+			if (body->isAwake) body->SetAwake(false);
+			if (root == i) sleepingIslandCount++;
+		}
+	}
+}
+
+void PhysicsManager::NarrowTestPair(RigidBody* one, RigidBody* two, double dtInv)
+{
 	std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
 	std::chrono::duration<double> elapsed_seconds;
-	iterCount = fullOverlaps.size();
-	for (auto& pair : fullOverlaps)
-	{
-		glm::vec3 MTV = glm::vec3(0.0f);
-		double smallestPen = DBL_MAX;
-		glm::vec3 toCentre = glm::vec3(0.0f);
-		int axisNumRes = -1;
-		int bestSingleAxis = -1;
-		//Vector3& oneHalfSize = pair.rbody1->object->bounds->obb.halfExtents;
-		//Vector3& twoHalfSize = pair.rbody2->object->bounds->obb.halfExtents;
 
-		
+	ContactBuffer& buffer = contactBuffers[0];
+	glm::vec3 MTV = glm::vec3(0.0f);
+	double smallestPen = DBL_MAX;
+	glm::vec3 toCentre = glm::vec3(0.0f);
+	int axisNumRes = -1;
+	int bestSingleAxis = -1;
+	//Vector3& oneHalfSize = one->object->bounds->obb.halfExtents;
+	//Vector3& twoHalfSize = two->object->bounds->obb.halfExtents;
 
+	start = std::chrono::high_resolution_clock::now();
+	bool intersection = IntersectionTest(one, two, smallestPen, MTV, toCentre, axisNumRes, bestSingleAxis);
+	end = std::chrono::high_resolution_clock::now();
+
+	elapsed_seconds = end - start;
+	intersectionTestTime = elapsed_seconds.count();
+
+	if (intersection)
+	{
+		//generate contacts based on the result
 		start = std::chrono::high_resolution_clock::now();
-		bool intersection = IntersectionTest(pair.rbody1, pair.rbody2, smallestPen, MTV, toCentre, axisNumRes, bestSingleAxis);
+		GenerateContacts(buffer, MTV, smallestPen, toCentre, one, two, axisNumRes, bestSingleAxis);
 		end = std::chrono::high_resolution_clock::now();
 
 		elapsed_seconds = end - start;
-		intersectionTestTime = elapsed_seconds.count();
+		generateContactsTime = elapsed_seconds.count();
 
+		ApplyContacts(one, two, buffer.contacts.data(), buffer.contacts.size(), smallestPen, dtInv);
+		buffer.contacts.clear();
+	}
+	else
+	{
+		//one->aabb.color = defAabbColor;
+		//two->aabb.color = defAabbColor;
+		//satOverlaps.erase(pair);
+	}
+}
 
-		if (intersection)
+void PhysicsManager::NarrowTestSATParallel(double dtInv)
+{
+	GeneratePairContacts(true);
+
+	//impulses change velocities of bodies shared between pairs, apply them in pair order on this thread
+	for (auto& result : pairContacts)
+	{
+		if (result.intersection)
 		{
-			if (!pair.rbody1->GetIsKinematic() && !pair.rbody2->GetIsKinematic())
+			const Contact* resultContacts = contactBuffers[result.bufferIndex].contacts.data() + result.contactsBegin;
+			ApplyContacts(result.one, result.two, resultContacts, result.contactsCount, result.smallestPen, dtInv);
+		}
+	}
+
+	for (auto& buffer : contactBuffers)
+	{
+		iterCount += buffer.iterCount;
+	}
+}
+
+void PhysicsManager::GeneratePairContacts(bool parallel)
+{
+	narrowPairs.clear();
+	if (useEndPointArrays)
+	{
+		for (auto& pair : pairTable.GetPairs())
+		{
+			narrowPairs.emplace_back(bodies[pair.minIndex], bodies[pair.maxIndex]);
+		}
+	}
+	else
+	{
+		narrowPairs.insert(narrowPairs.end(), fullOverlaps.begin(), fullOverlaps.end());
+	}
+	iterCount = (int)narrowPairs.size();
+	pairContacts.resize(narrowPairs.size());
+	for (auto& buffer : contactBuffers)
+	{
+		buffer.contacts.clear();
+		buffer.iterCount = 0;
+		buffer.intersectionTestTime = 0.0;
+		buffer.generateContactsTime = 0.0;
+	}
+
+	//intersection tests and contact generation only read the bounds, each thread writes its own buffer
+	auto generate = [this](size_t begin, size_t end, unsigned int threadIndex)
+	{
+		ContactBuffer& buffer = contactBuffers[threadIndex];
+		for (size_t i = begin; i < end; i++)
+		{
+			RigidBody* one = narrowPairs[i].rbody1;
+			RigidBody* two = narrowPairs[i].rbody2;
+			PairContacts& result = pairContacts[i];
+			result.one = one;
+			result.two = two;
+			result.bufferIndex = threadIndex;
+			result.contactsBegin = (unsigned int)buffer.contacts.size();
+			result.smallestPen = DBL_MAX;
+			result.contactsCount = 0;
+			if (IsPairSleeping(one, two))
 			{
-				pair.rbody1->SetAwake();
-				pair.rbody2->SetAwake();
+				result.intersection = false;
+				continue;
 			}
-			
-			//generate contacts based on the result
-			start = std::chrono::high_resolution_clock::now();
-			GenerateContacts(MTV, smallestPen, toCentre, pair.rbody1, pair.rbody2, axisNumRes, bestSingleAxis);
-			end = std::chrono::high_resolution_clock::now();
-
-			elapsed_seconds = end - start;
-			generateContactsTime = elapsed_seconds.count();
-			
-			//satOverlaps.insert(pair);
-			glm::vec3 changeInVel1 = glm::vec3(0.0f);
-			glm::vec3 changeInAng_Vel1 = glm::vec3(0.0f);
-			glm::vec3 changeInVel2 = glm::vec3(0.0f);
-			glm::vec3 changeInAng_Vel2 = glm::vec3(0.0f);
-
-			start = std::chrono::high_resolution_clock::now();
-			for (auto& contact : contacts)
+
+			glm::vec3 MTV = glm::vec3(0.0f);
+			glm::vec3 toCentre = glm::vec3(0.0f);
+			int axisNumRes = -1;
+			int bestSingleAxis = -1;
+			auto testStart = std::chrono::high_resolution_clock::now();
+			result.intersection = IntersectionTest(one, two, result.smallestPen, MTV, toCentre, axisNumRes, bestSingleAxis);
+			auto testEnd = std::chrono::high_resolution_clock::now();
+			buffer.intersectionTestTime += std::chrono::duration<double>(testEnd - testStart).count();
+			if (result.intersection)
 			{
-				iterCount++;
-				/*
-				if (DebugDraw::Instance()->debug)
-				{
-					//draw final contact points
-					DebugDraw::Instance()->line.mat->SetColor(0, 1, 1);
-					DebugDraw::Instance()->point.mat->SetColor(0, 1, 1);
-					DebugDraw::Instance()->DrawNormal(contact->contactNormal, contact->contactPoint);
-				}
-				*/
-				ProcessContact(contact, changeInVel1, changeInAng_Vel1, changeInVel2, changeInAng_Vel2, dtInv);
+				GenerateContacts(buffer, MTV, result.smallestPen, toCentre, one, two, axisNumRes, bestSingleAxis);
+				buffer.generateContactsTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - testEnd).count();
 			}
-			end = std::chrono::high_resolution_clock::now();
-			elapsed_seconds = end - start;
-			processContactTime = elapsed_seconds.count();
+			result.contactsCount = (unsigned int)buffer.contacts.size() - result.contactsBegin;
+		}
+	};
 
-			start = std::chrono::high_resolution_clock::now();
-			
-			if (contacts.size() > 0) //if we have at least one contact then we add the cumulated change in velocity to both objects
-			{
-				Contact& contact = contacts[0];
-				if (!contact.one->GetIsKinematic())
-				{
-					contact.one->velocity += changeInVel1;
-					contact.one->angular_velocity += changeInAng_Vel1;
-				}
-				if (!contact.two->GetIsKinematic())
-				{
-					contact.two->velocity += changeInVel2;
-					contact.two->angular_velocity += changeInAng_Vel2;
-				}
-				PositionalCorrection(contact.one, contact.two, smallestPen, contact.contactNormal);
+	if (parallel) JobSystem::Instance()->ParallelFor(narrowPairs.size(), narrowPhaseChunkSize, generate);
+	else generate(0, narrowPairs.size(), 0);
+	intersectionTestTime = 0.0;
+	generateContactsTime = 0.0;
+	for (auto& buffer : contactBuffers)
+	{
+		intersectionTestTime += buffer.intersectionTestTime;
+		generateContactsTime += buffer.generateContactsTime;
+	}
+}
 
-				contacts.clear();
+void PhysicsManager::PrepareSolverContacts(const PairContacts& result, const Contact* resultContacts, double dtInv)
+{
+	//manifolds that survived eviction are either from last frame or from a sleeping island that did not move
+	ContactManifold& manifold = manifolds[OverlapPair(result.one, result.two)];
+	manifold.frame = solverFrame;
+
+	//anchors are kept in the box space of the first body so they survive both bodies moving together
+	const glm::vec3& anchorPosition = result.one->object->bounds->centeredPosition;
+	const glm::mat3& anchorRotation = result.one->object->bounds->obb.rot;
+	glm::mat3 anchorInverse = glm::transpose(anchorRotation);
+	float matchToleranceSquared = (float)(contactMatchTolerance * contactMatchTolerance);
+
+	std::vector<CachedContact> previousPoints;
+	previousPoints.swap(manifold.points);
+	manifold.points.clear();
+	manifold.points.resize(result.contactsCount);
+
+	for (unsigned int i = 0; i < result.contactsCount; i++)
+	{
+		const Contact& contact = resultContacts[i];
+		CachedContact& cached = manifold.points[i];
+		cached.localPoint = anchorInverse * (contact.contactPoint - anchorPosition);
+		for (auto& previous : previousPoints)
+		{
+			glm::vec3 offset = previous.localPoint - cached.localPoint;
+			if (glm::dot(offset, offset) < matchToleranceSquared)
+			{
+				cached.normalImpulse = previous.normalImpulse;
+				cached.tangentImpulse1 = previous.tangentImpulse1;
+				cached.tangentImpulse2 = previous.tangentImpulse2;
+				break;
 			}
-			end = std::chrono::high_resolution_clock::now();
+		}
 
-			elapsed_seconds = end - start;
-			positionalCorrectionTime = elapsed_seconds.count();
+		RigidBody* ent1 = contact.one;
+		RigidBody* ent2 = contact.two;
+		bool kinematic1 = ent1->GetIsKinematic();
+		bool kinematic2 = ent2->GetIsKinematic();
+		float invMass1 = kinematic1 ? 0.f : (float)ent1->massInverse;
+		float invMass2 = kinematic2 ? 0.f : (float)ent2->massInverse;
+		glm::mat3 invInertia1 = kinematic1 ? glm::mat3(0.f) : ent1->inverse_inertia_tensor_world;
+		glm::mat3 invInertia2 = kinematic2 ? glm::mat3(0.f) : ent2->inverse_inertia_tensor_world;
+
+		SolverContact solverContact;
+		solverContact.one = ent1;
+		solverContact.two = ent2;
+		solverContact.rA = contact.contactPoint - ent1->object->bounds->centeredPosition;
+		solverContact.rB = contact.contactPoint - ent2->object->bounds->centeredPosition;
+		solverContact.normal = contact.contactNormal;
+
+		//fixed tangent basis from the normal so warm started friction impulses keep their meaning
+		const glm::vec3& n = solverContact.normal;
+		if (abs(n.x) >= 0.57735f) solverContact.tangent1 = glm::normalize(glm::vec3(n.y, -n.x, 0.f));
+		else solverContact.tangent1 = glm::normalize(glm::vec3(0.f, n.z, -n.y));
+		solverContact.tangent2 = glm::cross(n, solverContact.tangent1);
+
+		auto effectiveMass = [&](const glm::vec3& axis)
+		{
+			glm::vec3 kA = glm::cross(solverContact.rA, axis);
+			glm::vec3 kB = glm::cross(solverContact.rB, axis);
+			float k = invMass1 + invMass2 + glm::dot(kA, invInertia1 * kA) + glm::dot(kB, invInertia2 * kB);
+			return k > 0.f ? 1.f / k : 0.f;
+		};
+		solverContact.normalMass = effectiveMass(solverContact.normal);
+		solverContact.tangentMass1 = effectiveMass(solverContact.tangent1);
+		solverContact.tangentMass2 = effectiveMass(solverContact.tangent2);
+
+		//BAUMGARTE plus restitution for fast approaching contacts
+		const glm::vec3& relativeVel = (ent2->velocity + glm::cross(ent2->angular_velocity, solverContact.rB)) - (ent1->velocity + glm::cross(ent1->angular_velocity, solverContact.rA));
+		double approachVel = glm::dot(relativeVel, solverContact.normal);
+		double bias = -BAUMGARTE * dtInv * std::min(0.0, -contact.penetration + k_allowedPenetration);
+		if (approachVel < -restitutionThreshold)
+		{
+			bias += -std::min(ent1->restitution, ent2->restitution) * approachVel;
 		}
-		else
+		solverContact.bias = (float)bias;
+		solverContact.friction = (float)sqrt(ent1->friction * ent2->friction);
+
+		solverContact.normalImpulse = cached.normalImpulse;
+		solverContact.tangentImpulse1 = cached.tangentImpulse1;
+		solverContact.tangentImpulse2 = cached.tangentImpulse2;
+		solverContact.cached = &cached;
+		solverContacts.push_back(solverContact);
+	}
+}
+
+static inline void ApplySolverImpulse(SolverContact& contact, const glm::vec3& impulse)
+{
+	if (!contact.one->GetIsKinematic())
+	{
+		contact.one->velocity -= impulse * (float)contact.one->massInverse;
+		contact.one->angular_velocity -= contact.one->inverse_inertia_tensor_world * glm::cross(contact.rA, impulse);
+	}
+	if (!contact.two->GetIsKinematic())
+	{
+		contact.two->velocity += impulse * (float)contact.two->massInverse;
+		contact.two->angular_velocity += contact.two->inverse_inertia_tensor_world * glm::cross(contact.rB, impulse);
+	}
+}
+
+void PhysicsManager::SolveContacts(double dtInv)
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+	std::chrono::duration<double> elapsed_seconds;
+
+	start = std::chrono::high_resolution_clock::now();
+	solverFrame++;
+	solverContacts.clear();
+	for (auto& result : pairContacts)
+	{
+		if (!result.intersection) continue;
+		if (!result.one->GetIsKinematic() && !result.two->GetIsKinematic())
 		{
-			//pair.rbody1->aabb.color = defAabbColor;
-			//pair.rbody2->aabb.color = defAabbColor;
-			//satOverlaps.erase(pair);
+			result.one->SetAwake();
+			result.two->SetAwake();
 		}
+		const Contact* resultContacts = contactBuffers[result.bufferIndex].contacts.data() + result.contactsBegin;
+		PrepareSolverContacts(result, resultContacts, dtInv);
 	}
-	//printf("\nnumber of SAT overlaps: %d", satOverlaps.size());
+
+	//pairs that stopped touching lose their cached impulses, sleeping pairs keep them for when they wake up
+	std::erase_if(manifolds, [this](const auto& manifold) { return manifold.second.frame != solverFrame && !IsPairSleeping(manifold.first.rbody1, manifold.first.rbody2); });
+
+	//warm start
+	for (auto& contact : solverContacts)
+	{
+		glm::vec3 impulse = contact.normalImpulse * contact.normal + contact.tangentImpulse1 * contact.tangent1 + contact.tangentImpulse2 * contact.tangent2;
+		ApplySolverImpulse(contact, impulse);
+	}
+
+	solverIterationsUsed = 0;
+	solverResidual = 0.0;
+	for (int iteration = 0; iteration < solverIterations; iteration++)
+	{
+		double residual = 0.0;
+		for (auto& contact : solverContacts)
+		{
+			RigidBody* ent1 = contact.one;
+			RigidBody* ent2 = contact.two;
+
+			//friction first, clamped by the normal impulse from the previous iteration
+			float maxFriction = contact.friction * contact.normalImpulse;
+			glm::vec3 relativeVel = (ent2->velocity + glm::cross(ent2->angular_velocity, contact.rB)) - (ent1->velocity + glm::cross(ent1->angular_velocity, contact.rA));
+			float lambda = -glm::dot(relativeVel, contact.tangent1) * contact.tangentMass1;
+			float newImpulse = std::clamp(contact.tangentImpulse1 + lambda, -maxFriction, maxFriction);
+			lambda = newImpulse - contact.tangentImpulse1;
+			contact.tangentImpulse1 = newImpulse;
+			ApplySolverImpulse(contact, lambda * contact.tangent1);
+			residual = std::max(residual, (double)abs(lambda));
+
+			relativeVel = (ent2->velocity + glm::cross(ent2->angular_velocity, contact.rB)) - (ent1->velocity + glm::cross(ent1->angular_velocity, contact.rA));
+			lambda = -glm::dot(relativeVel, contact.tangent2) * contact.tangentMass2;
+			newImpulse = std::clamp(contact.tangentImpulse2 + lambda, -maxFriction, maxFriction);
+			lambda = newImpulse - contact.tangentImpulse2;
+			contact.tangentImpulse2 = newImpulse;
+			ApplySolverImpulse(contact, lambda * contact.tangent2);
+			residual = std::max(residual, (double)abs(lambda));
+
+			//normal, accumulated impulse can only push
+			relativeVel = (ent2->velocity + glm::cross(ent2->angular_velocity, contact.rB)) - (ent1->velocity + glm::cross(ent1->angular_velocity, contact.rA));
+			lambda = (-glm::dot(relativeVel, contact.normal) + contact.bias) * contact.normalMass;
+			newImpulse = std::max(contact.normalImpulse + lambda, 0.f);
+			lambda = newImpulse - contact.normalImpulse;
+			contact.normalImpulse = newImpulse;
+			ApplySolverImpulse(contact, lambda * contact.normal);
+			residual = std::max(residual, (double)abs(lambda));
+		}
+		iterCount += (int)solverContacts.size();
+		solverIterationsUsed = iteration + 1;
+		solverResidual = residual;
+		if (residual < solverTolerance) break;
+	}
+
+	for (auto& contact : solverContacts)
+	{
+		contact.cached->normalImpulse = contact.normalImpulse;
+		contact.cached->tangentImpulse1 = contact.tangentImpulse1;
+		contact.cached->tangentImpulse2 = contact.tangentImpulse2;
+	}
+	end = std::chrono::high_resolution_clock::now();
+	elapsed_seconds = end - start;
+	processContactTime = elapsed_seconds.count();
+
+	start = std::chrono::high_resolution_clock::now();
+	for (auto& result : pairContacts)
+	{
+		if (result.intersection && result.contactsCount > 0)
+		{
+			const Contact& contact = contactBuffers[result.bufferIndex].contacts[result.contactsBegin];
+			glm::vec3 normal = contact.contactNormal;
+			PositionalCorrection(contact.one, contact.two, result.smallestPen, normal);
+		}
+	}
+	end = std::chrono::high_resolution_clock::now();
+	elapsed_seconds = end - start;
+	positionalCorrectionTime = elapsed_seconds.count();
+
+	for (auto& buffer : contactBuffers)
+	{
+		iterCount += buffer.iterCount;
+	}
+}
+
+void PhysicsManager::ApplyContacts(RigidBody* one, RigidBody* two, const Contact* pairContacts, size_t contactCount, double smallestPen, double dtInv)
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+	std::chrono::duration<double> elapsed_seconds;
+
+	if (!one->GetIsKinematic() && !two->GetIsKinematic())
+	{
+		one->SetAwake();
+		two->SetAwake();
+	}
+
+	//satOverlaps.insert(pair);
+	glm::vec3 changeInVel1 = glm::vec3(0.0f);
+	glm::vec3 changeInAng_Vel1 = glm::vec3(0.0f);
+	glm::vec3 changeInVel2 = glm::vec3(0.0f);
+	glm::vec3 changeInAng_Vel2 = glm::vec3(0.0f);
+
+	start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < contactCount; i++)
+	{
+		iterCount++;
+		/*
+		if (DebugDraw::Instance()->debug)
+		{
+			//draw final contact points
+			DebugDraw::Instance()->line.mat->SetColor(0, 1, 1);
+			DebugDraw::Instance()->point.mat->SetColor(0, 1, 1);
+			DebugDraw::Instance()->DrawNormal(contact->contactNormal, contact->contactPoint);
+		}
+		*/
+		ProcessContact(pairContacts[i], changeInVel1, changeInAng_Vel1, changeInVel2, changeInAng_Vel2, dtInv);
+	}
+	end = std::chrono::high_resolution_clock::now();
+	elapsed_seconds = end - start;
+	processContactTime = elapsed_seconds.count();
+
+	start = std::chrono::high_resolution_clock::now();
+	
+	if (contactCount > 0) //if we have at least one contact then we add the cumulated change in velocity to both objects
+	{
+		const Contact& contact = pairContacts[0];
+		if (!contact.one->GetIsKinematic())
+		{
+			contact.one->velocity += changeInVel1;
+			contact.one->angular_velocity += changeInAng_Vel1;
+		}
+		if (!contact.two->GetIsKinematic())
+		{
+			contact.two->velocity += changeInVel2;
+			contact.two->angular_velocity += changeInAng_Vel2;
+		}
+		glm::vec3 normal = contact.contactNormal;
+		PositionalCorrection(contact.one, contact.two, smallestPen, normal);
+	}
+	end = std::chrono::high_resolution_clock::now();
+
+	elapsed_seconds = end - start;
+	positionalCorrectionTime = elapsed_seconds.count();
 }
 
 void PhysicsManager::GenerateContactPointToFace(
+	ContactBuffer& buffer,
 	const glm::vec3&toCentre,
 	glm::vec3& mtv,
 	double smallestPen,
@@ -390,7 +906,7 @@ void PhysicsManager::GenerateContactPointToFace(
 	
 	FlipMTVTest(mtv, toCentre); //this will calculate correct reference normal pointing from box one to box two just like for edge to edge
 	glm::vec3 incident_axis = glm::vec3(); //correct incident axis is not the mtv it's the most opposite axis to the mtv(in fact reference normal) of the object that collided with face 
-	ClaculateIncidentAxis(incident_axis, twoObj->object->bounds->obb.rot, mtv);
+	ClaculateIncidentAxis(incident_axis, twoObj->object->bounds->obb.rot, mtv, buffer.iterCount);
 
 	//plane is 
 	//normal and point on plane
@@ -440,6 +956,8 @@ void PhysicsManager::GenerateContactPointToFace(
 	const glm::vec3& normal1Neg = -1.0f*normal1;
 	const glm::vec3& normal2Neg = -1.0f*normal2;
 
+	std::vector<glm::vec3>& clipPolygon = buffer.clipPolygon;
+	std::vector<glm::vec3>& newClipPolygon = buffer.newClipPolygon;
 	clipPolygon.clear();
 
 	clipPolygon.push_back(incident_face[0]);
@@ -448,13 +966,13 @@ void PhysicsManager::GenerateContactPointToFace(
 	clipPolygon.push_back(incident_face[3]);
 
 	//incident face is sent then
-	ClipFaceToSidePlane(clipPolygon, newClipPolygon, normal1Neg, neg_offset1); //red
+	ClipFaceToSidePlane(clipPolygon, newClipPolygon, normal1Neg, neg_offset1, buffer.iterCount); //red
 	//if (DebugDraw::Instance()->debug) vertCount = DrawPlaneClipContacts(contacts, -1.f*normal1, vertCount, Vector3(1, 0, 0));
-	ClipFaceToSidePlane(newClipPolygon, clipPolygon, normal1, pos_offset1); //green
+	ClipFaceToSidePlane(newClipPolygon, clipPolygon, normal1, pos_offset1, buffer.iterCount); //green
 	//if (DebugDraw::Instance()->debug) vertCount = DrawPlaneClipContacts(contacts, normal1, vertCount, Vector3(0, 1, 0));
-	ClipFaceToSidePlane(clipPolygon, newClipPolygon, normal2Neg, neg_offset2); //blue
+	ClipFaceToSidePlane(clipPolygon, newClipPolygon, normal2Neg, neg_offset2, buffer.iterCount); //blue
 	//if (DebugDraw::Instance()->debug) vertCount = DrawPlaneClipContacts(contacts, -1.f*normal2, vertCount, Vector3(0, 0, 1));
-	ClipFaceToSidePlane(newClipPolygon, clipPolygon, normal2, pos_offset2); //yellow
+	ClipFaceToSidePlane(newClipPolygon, clipPolygon, normal2, pos_offset2, buffer.iterCount); //yellow
 	//if (DebugDraw::Instance()->debug) vertCount = DrawPlaneClipContacts(contacts, normal2, vertCount, Vector3(1, 1, 0));
 
 	//ref normal is mtv
@@ -469,11 +987,11 @@ void PhysicsManager::GenerateContactPointToFace(
 	//Vector3 centerPointOfRefFace = oneObj->node->position + mtv*oneObj->obb.halfExtent[typeOfCollision];
 	//float pos_offsettT = centerPointOfRefFace.dot(mtv); 
 
-	FilterContactsAgainstReferenceFace(mtv, refPlaneOffset, smallestPen, oneObj, twoObj);
+	FilterContactsAgainstReferenceFace(buffer, mtv, refPlaneOffset, smallestPen, oneObj, twoObj);
 	//if (DebugDraw::Instance()->debug) DrawFaceDebug(contact_points_out, reference_face, incident_face, typeOfCollision);
 }
 
-void PhysicsManager::GenerateContactEdgeToEdge(const glm::vec3&toCentre, glm::vec3& mtv, double smallestPen, RigidBody* oneObj, RigidBody* twoObj, int axisNumRes, int& bestSingleAxis)
+void PhysicsManager::GenerateContactEdgeToEdge(ContactBuffer& buffer, const glm::vec3&toCentre, glm::vec3& mtv, double smallestPen, RigidBody* oneObj, RigidBody* twoObj, int axisNumRes, int& bestSingleAxis)
 {
 	// We've got an edge-edge contact. Find out which axes
 	
@@ -530,7 +1048,7 @@ void PhysicsManager::GenerateContactEdgeToEdge(const glm::vec3&toCentre, glm::ve
 	//contact.one = twoObj;
 	//contact.two = oneObj;
 
-	contacts.emplace_back(vertex, mtv, smallestPen, twoObj, oneObj);
+	buffer.contacts.emplace_back(vertex, mtv, smallestPen, twoObj, oneObj);
 }
 
 void PhysicsManager::PositionalCorrection(RigidBody* one, RigidBody* two, double penetration, glm::vec3& normal)
@@ -598,14 +1116,14 @@ void PhysicsManager::CalcFaceVertices(const glm::vec3& pos, glm::vec3* vertices,
 	}
 }
 
-void PhysicsManager::ClipFaceToSidePlane(vector<glm::vec3>& clipPolygon, std::vector<glm::vec3>& newClipPolygon, const glm::vec3& normal, double plane_offset)
+void PhysicsManager::ClipFaceToSidePlane(vector<glm::vec3>& clipPolygon, std::vector<glm::vec3>& newClipPolygon, const glm::vec3& normal, double plane_offset, int& iterations)
 {
 	glm::vec3 Vertex1 = clipPolygon.back();
 	double Distance1 = glm::dot(Vertex1, normal) - plane_offset;//rnDistance(Plane, Vertex1.Position);
 	newClipPolygon.clear();
 	for (auto & Vertex2 : clipPolygon)
 	{
-		iterCount++;
+		iterations++;
 		double Distance2 = glm::dot(Vertex2, normal) - plane_offset;//rnDistance(Plane, Vertex2.Position);
 
 		if (Distance1 <= 0.0 && Distance2 <= 0.0)
@@ -704,13 +1222,13 @@ inline void PhysicsManager::CreateSidePlanesOffsetsAndNormals(const glm::vec3& o
 	}
 }
 
-inline void PhysicsManager::ClaculateIncidentAxis(glm::vec3& incident_axis, const glm::mat3 &two, glm::vec3& smallestAxis)
+inline void PhysicsManager::ClaculateIncidentAxis(glm::vec3& incident_axis, const glm::mat3 &two, glm::vec3& smallestAxis, int& iterations)
 {
 	double incident_tracker = DBL_MAX;
 	//get incident face vertices by dotting all axis with mtv
 	for (int i = 0; i < 3; i++)
 	{
-		iterCount++;
+		iterations++;
 		double most_neg = glm::dot(MathUtils::GetAxis(two, i), smallestAxis);
 		if (most_neg < incident_tracker){
 			incident_tracker = most_neg;
@@ -724,13 +1242,13 @@ inline void PhysicsManager::ClaculateIncidentAxis(glm::vec3& incident_axis, cons
 	}
 }
 
-inline void PhysicsManager::FilterContactsAgainstReferenceFace(const glm::vec3& refNormal, double pos_offsett, double penetration, RigidBody* one, RigidBody* two)
+inline void PhysicsManager::FilterContactsAgainstReferenceFace(ContactBuffer& buffer, const glm::vec3& refNormal, double pos_offsett, double /*penetration*/, RigidBody* one, RigidBody* two)
 {
 	//this step is supposed to test against the reference plane all the contact points and we keep only the points inside or at the cube
 	//this is to clean up contacts 
-	for (auto & contactPoint : clipPolygon)
+	for (auto & contactPoint : buffer.clipPolygon)
 	{
-		iterCount++;
+		buffer.iterCount++;
 		//float Distance1 = Vector3::Dot(contacts[i], -1 * refNormal) - neg_offsett;
 		//if (Distance1 <= 0){
 		//	//keep point
@@ -746,7 +1264,7 @@ inline void PhysicsManager::FilterContactsAgainstReferenceFace(const glm::vec3&
 			//contact.contactNormal = refNormal;
 			//contact.one = one;
 			//contact.two = two;
-			contacts.emplace_back(contactPoint, refNormal, Distance2, one, two);
+			buffer.contacts.emplace_back(contactPoint, refNormal, Distance2, one, two);
 		}
 	}
 }
@@ -821,17 +1339,18 @@ void PhysicsManager::DrawReferenceNormal(Contact& contact, int typeOfCollision)
 	DebugDraw::Instance()->DrawNormal(contact.contactNormal, centerPointOfRefFace); //draw reference normal
 }
 
-void PhysicsManager::DrawFaceDebug(glm::vec3* reference_face, glm::vec3* incident_face, int typeOfCollision)
+void PhysicsManager::DrawFaceDebug(const std::vector<Contact>& contacts, glm::vec3* reference_face, glm::vec3* incident_face, int typeOfCollision)
 {
 	if (contacts.size() > 0)
 	{
-		DrawCollisionNormal(contacts[0]);
-		DrawReferenceNormal(contacts[0], typeOfCollision);
+		Contact contact = contacts[0];
+		DrawCollisionNormal(contact);
+		DrawReferenceNormal(contact, typeOfCollision);
 		DrawReferenceAndIncidentFace(reference_face, incident_face);
 	}
 }
 
-size_t PhysicsManager::DrawPlaneClipContacts(std::vector<glm::vec3> &contactPoints, const glm::vec3& normal, size_t vertCount, const glm::vec3& normalColor)
+size_t PhysicsManager::DrawPlaneClipContacts(const std::vector<Contact>& contacts, std::vector<glm::vec3> &contactPoints, const glm::vec3& normal, size_t vertCount, const glm::vec3& /*normalColor*/)
 {
 	for (size_t i = vertCount; i < contacts.size(); i++)
 	{
@@ -859,10 +1378,28 @@ void PhysicsManager::Clear()
 	zAxis.clear();
 	satOverlaps.clear();
 	fullOverlaps.clear();
+	bodies.clear();
+	bodyBounds.clear();
+	bodyBoundsVersions.clear();
+	bodyBoundsChanged.clear();
+	endPoints[x].clear();
+	endPoints[y].clear();
+	endPoints[z].clear();
+	pairTable.Clear();
+	bodyIndices.clear();
+	islandCount = 0;
+	sleepingIslandCount = 0;
 	gravity = glm::vec3(0.0, -9.0, 0.0);
-	contacts.clear();
-	clipPolygon.clear();
-	newClipPolygon.clear();
+	for (auto& buffer : contactBuffers)
+	{
+		buffer.contacts.clear();
+		buffer.clipPolygon.clear();
+		buffer.newClipPolygon.clear();
+	}
+	narrowPairs.clear();
+	pairContacts.clear();
+	manifolds.clear();
+	solverContacts.clear();
 }
 
 void PhysicsManager::Update(double deltaTime)
@@ -876,6 +1413,12 @@ void PhysicsManager::Update(double deltaTime)
 	elapsed_seconds = end - start;
 	pruneAndSweepTime = elapsed_seconds.count();
 
+	start = std::chrono::high_resolution_clock::now();
+	UpdateIslands();
+	end = std::chrono::high_resolution_clock::now();
+	elapsed_seconds = end - start;
+	islandTime = elapsed_seconds.count();
+
 	start = std::chrono::high_resolution_clock::now();
 	NarrowTestSAT(deltaTime);
 	end = std::chrono::high_resolution_clock::now();
@@ -3,6 +3,11 @@
 #include <unordered_set>
 #include "OverlapPair.h"
 #include "ObjectPoint.h"
+#include "EndPoint.h"
+#include "PairTable.h"
+#include "ContactManifold.h"
+#include "IslandBuilder.h"
+#include <unordered_map>
 #include "Vector3.h"
 
 struct Contact
@@ -23,6 +28,30 @@ public:
 		: contactPoint(cp),contactNormal(cn),penetration(p), one(oneb), two(twob) {}
 };
 
+//scratch buffers owned by one thread while it tests pairs and generates contacts
+struct ContactBuffer
+{
+	std::vector<Contact> contacts;
+	std::vector<glm::vec3> clipPolygon;
+	std::vector<glm::vec3> newClipPolygon;
+	int iterCount = 0;
+	//time this thread spent in each phase, summed over threads into the manager's stats
+	double intersectionTestTime = 0.0;
+	double generateContactsTime = 0.0;
+};
+
+//result of the parallel contact generation for one pair, contacts live in contactBuffers[bufferIndex]
+struct PairContacts
+{
+	RigidBody* one;
+	RigidBody* two;
+	bool intersection;
+	double smallestPen;
+	unsigned int bufferIndex;
+	unsigned int contactsBegin;
+	unsigned int contactsCount;
+};
+
 /*
 //std specialization
 namespace std
@@ -75,23 +104,64 @@ public:
 	std::unordered_set<OverlapPair> fullOverlaps;
 	std::unordered_set<OverlapPair> satOverlaps;
 
+	//sweep and prune over endpoint values copied once per frame from bounds
+	//instead of chasing body->object->bounds for every comparison
+	bool useEndPointArrays = true;
+	std::vector<RigidBody*> bodies;
+	std::vector<MinMax> bodyBounds;
+	//bounds version copied last, endpoints of bodies whose bounds did not change are left alone
+	std::vector<unsigned int> bodyBoundsVersions;
+	std::vector<unsigned char> bodyBoundsChanged;
+	std::vector<EndPoint> endPoints[3];
+	PairTable pairTable;
+	std::unordered_map<RigidBody*, unsigned int> bodyIndices;
+
+	//bodies connected through overlap pairs form islands that fall asleep and wake up together
+	//pairs inside sleeping islands skip the narrowphase
+	bool useIslandSleeping = true;
+	IslandBuilder islandBuilder;
+	std::vector<unsigned char> islandRestless;
+	int islandCount;
+	int sleepingIslandCount;
+	double islandTime;
+
 	glm::vec3 gravity = glm::vec3(0.0, -9.0, 0.0);
 
 	void Update(double deltaTime);
 	void Clear();
 	double satTime;
 	double pruneAndSweepTime;
+	int sweepSwaps;
+	int pairsAdded;
+	int pairsRemoved;
 	double intersectionTestTime;
 	double generateContactsTime;
 	double processContactTime;
 	double positionalCorrectionTime;
 	int iterCount;
-	std::vector<Contact> contacts;
-	std::vector<glm::vec3> clipPolygon;
-	std::vector<glm::vec3> newClipPolygon;
+	//contact generation runs on the job system workers, impulses are applied afterwards in pair order
+	//so the result is identical to the single threaded path
+	bool useParallelNarrowPhase = true;
+	int narrowPhaseChunkSize = 64;
+	std::vector<ContactBuffer> contactBuffers;
+	std::vector<OverlapPair> narrowPairs;
+	std::vector<PairContacts> pairContacts;
+
+	//iterative sequential impulse solver with friction
+	//warm started from the impulses kept in the contact manifold of each pair from the previous frame
+	bool useIterativeSolver = true;
+	int solverIterations = 8;
+	double solverTolerance = 0.0001;
+	double contactMatchTolerance = 0.05;
+	double restitutionThreshold = 1.0;
+	std::unordered_map<OverlapPair, ContactManifold> manifolds;
+	std::vector<SolverContact> solverContacts;
+	int solverIterationsUsed;
+	double solverResidual;
 	const double k_allowedPenetration = 0.01;
 	double BAUMGARTE = 0.2;
 private:
+	unsigned int solverFrame;
 	PhysicsManager();
 	~PhysicsManager();
 	//copy
@@ -102,19 +172,30 @@ private:
 	void CalcFaceVertices(const glm::vec3& pos, glm::vec3* vertices, const glm::vec3& axis, const glm::mat3& model, const glm::vec3& halfExtents, bool counterClockwise = true);
 	
 
-	size_t DrawPlaneClipContacts(std::vector<glm::vec3> &contacts, const glm::vec3& normal, size_t vertCount, const glm::vec3& normalColor);
+	size_t DrawPlaneClipContacts(const std::vector<Contact>& contacts, std::vector<glm::vec3> &contactPoints, const glm::vec3& normal, size_t vertCount, const glm::vec3& normalColor);
 
 	void SortAxis(std::vector<ObjectPoint*>& axisList, axis axisToSort);
 	bool CheckBoundingBoxes(RigidBody* body1, RigidBody* body2);
+	void RefreshEndPoints();
+	void SortEndPoints(std::vector<EndPoint>& axisList);
+	bool CheckBoundingBoxes(unsigned int body1, unsigned int body2);
+	void NarrowTestPair(RigidBody* one, RigidBody* two, double dtInv);
+	void NarrowTestSATParallel(double dtInv);
+	void GeneratePairContacts(bool parallel);
+	void PrepareSolverContacts(const PairContacts& result, const Contact* resultContacts, double dtInv);
+	void SolveContacts(double dtInv);
+	void UpdateIslands();
+	bool IsPairSleeping(RigidBody* one, RigidBody* two);
+	void ApplyContacts(RigidBody* one, RigidBody* two, const Contact* pairContacts, size_t contactCount, double smallestPen, double dtInv);
 	void FlipMTVTest(glm::vec3&mtv, const glm::vec3 &toCentre);
 
-	void FilterContactsAgainstReferenceFace(const glm::vec3& refNormal, double pos_offsett, double penetration, RigidBody* one, RigidBody* two);
+	void FilterContactsAgainstReferenceFace(ContactBuffer& buffer, const glm::vec3& refNormal, double pos_offsett, double penetration, RigidBody* one, RigidBody* two);
 	
-	void ClaculateIncidentAxis(glm::vec3& incident_axis, const glm::mat3 &two, glm::vec3& smallestAxis);
+	void ClaculateIncidentAxis(glm::vec3& incident_axis, const glm::mat3 &two, glm::vec3& smallestAxis, int& iterations);
 
 	void CreateSidePlanesOffsetsAndNormals(const glm::vec3& onePosition, int typeOfCollision, glm::vec3& normal1, const glm::mat3& one, glm::vec3& normal2, double &neg_offset1, glm::vec3 oneHalfSize, double &pos_offset1, double &neg_offset2, double &pos_offset2);
 
-	void ClipFaceToSidePlane(std::vector<glm::vec3>& clipPolygon, std::vector<glm::vec3>& newClipPolygon, const glm::vec3& normal, double plane_offset);
+	void ClipFaceToSidePlane(std::vector<glm::vec3>& clipPolygon, std::vector<glm::vec3>& newClipPolygon, const glm::vec3& normal, double plane_offset, int& iterations);
 	void DrawCollisionNormal(Contact& contact);
 	void DrawReferenceNormal(Contact& contact, int typeOfCollision);
 	void DrawSidePlanes(const glm::vec3& normal1, const glm::vec3& normal2, const glm::vec3& onePosition, int index1, int index2, const glm::vec3& oneHalfSize);
@@ -124,14 +205,14 @@ private:
 	bool overlapOnAxis(const RigidBody* oneObj, const RigidBody* twoObj, const glm::vec3 &axis, const int axisNum, int& resAxisNum, const glm::vec3&toCentre, double& smallestPenetration, glm::vec3& smallestAxis);
 	double penetrationOnAxis(const RigidBody* oneObj, const RigidBody* twoObj, const glm::vec3 &axis, const glm::vec3&toCentre);
 	double transformToAxis(const glm::mat3 &boxModel, const glm::vec3 &axis, const glm::vec3 &boxHalfSize);
-	void GenerateContacts(glm::vec3& MTV, const double& penetration, glm::vec3& toCentre, RigidBody* oneObj, RigidBody* twoObj, int axisNumRes, int& bestSingleAxis);
+	void GenerateContacts(ContactBuffer& buffer, glm::vec3& MTV, const double& penetration, glm::vec3& toCentre, RigidBody* oneObj, RigidBody* twoObj, int axisNumRes, int& bestSingleAxis);
 
-	void DrawFaceDebug(glm::vec3 * reference_face, glm::vec3 * incident_face, int typeOfCollision);
+	void DrawFaceDebug(const std::vector<Contact>& contacts, glm::vec3 * reference_face, glm::vec3 * incident_face, int typeOfCollision);
 
 	void DrawReferenceAndIncidentFace(glm::vec3 * reference_face, glm::vec3 * incident_face);
 
-	void GenerateContactPointToFace(const glm::vec3& toCentre, glm::vec3& smallestAxis, double smallestPen, RigidBody* oneObj, RigidBody* twoObj, int typeOfCollision);
-	void GenerateContactEdgeToEdge(const glm::vec3& toCentre, glm::vec3& smallestAxis, double smallestPen, RigidBody* oneObj, RigidBody* twoObj, int axisNumRes, int& bestSingleAxis);
+	void GenerateContactPointToFace(ContactBuffer& buffer, const glm::vec3& toCentre, glm::vec3& smallestAxis, double smallestPen, RigidBody* oneObj, RigidBody* twoObj, int typeOfCollision);
+	void GenerateContactEdgeToEdge(ContactBuffer& buffer, const glm::vec3& toCentre, glm::vec3& smallestAxis, double smallestPen, RigidBody* oneObj, RigidBody* twoObj, int axisNumRes, int& bestSingleAxis);
 	glm::vec3 contactPoint(const glm::vec3& pOne, const glm::vec3& dOne, double oneSize, const glm::vec3& pTwo, const glm::vec3& dTwo, double twoSize, bool useOne) const;
 
 };
@@ -63,6 +63,140 @@ Render::~Render()
 {
 }
 
+inline unsigned int Render::GetSortId(RenderElement* element, MaterialElements field)
+{
+	if (element == nullptr) return 0;
+	if (element->sortId == 0) element->sortId = ++nextSortIds[(int)field];
+	return element->sortId;
+}
+
+//most expensive state in the highest bits so sorting groups by shader first and object profile last
+//ids wider than their field wrap around which only makes the order worse, the emitted elements are still compared by pointer
+inline uint64_t Render::MakeSortKey(const Material* mat)
+{
+	uint64_t key = 0;
+	key |= (uint64_t)(GetSortId(mat->elements[(int)MaterialElements::EShader], MaterialElements::EShader) & 0xFFF) << 52;
+	key |= (uint64_t)(GetSortId(mat->elements[(int)MaterialElements::ERenderProfile], MaterialElements::ERenderProfile) & 0x3FF) << 42;
+	key |= (uint64_t)(GetSortId(mat->elements[(int)MaterialElements::ETextureProfile], MaterialElements::ETextureProfile) & 0xFFF) << 30;
+	key |= (uint64_t)(GetSortId(mat->elements[(int)MaterialElements::EMaterialProfile], MaterialElements::EMaterialProfile) & 0x3FF) << 20;
+	key |= (uint64_t)(GetSortId(mat->elements[(int)MaterialElements::EVao], MaterialElements::EVao) & 0x3FF) << 10;
+	key |= (uint64_t)(GetSortId(mat->elements[(int)MaterialElements::EObjectProfile], MaterialElements::EObjectProfile) & 0x3FF);
+	return key;
+}
+
+void Render::AppendSortedOrder(std::vector<std::vector<Material*>*>& passMaterialSequences, std::vector<RenderElement*>& renderList)
+{
+	sortPairs.resize(passMaterialSequences.size());
+	for (size_t i = 0; i < passMaterialSequences.size(); i++)
+	{
+		sortPairs[i].key = MakeSortKey((*passMaterialSequences[i])[0]);
+		sortPairs[i].value = (uint32_t)i;
+	}
+	RadixSort::Sort(sortPairs, sortScratch);
+
+	orderedSequences.clear();
+	for (auto& pair : sortPairs)
+	{
+		orderedSequences.push_back(passMaterialSequences[pair.value]);
+	}
+	EmitSequences(orderedSequences, renderList);
+}
+
+void Render::EmitSequences(const std::vector<std::vector<Material*>*>& sequencesInOrder, std::vector<RenderElement*>& renderList)
+{
+	std::vector<RenderElement*> activeElements(7, nullptr);
+	for (auto sequence : sequencesInOrder)
+	{
+		std::vector<Material*>& materialSequence = *sequence;
+		//same rule as the greedy order, a sequence whose first material matches the active state is a duplicate
+		if (std::equal(activeElements.begin(), activeElements.end(), materialSequence[0]->elements.begin())) continue;
+		UpdateCurrentMaterialAndRenderList(activeElements, renderList, materialSequence);
+	}
+}
+
+//runs the greedy ordering on a copy only to count its state changes
+unsigned int Render::CountGreedyStateChanges(const std::vector<std::vector<Material*>*>& passMaterialSequences)
+{
+	unsigned int stateChanges = stateChangeCount;
+	unsigned int drawCalls = totalNrOfDrawCalls;
+	greedyScratchSequences = passMaterialSequences;
+	greedyScratchList.clear();
+	AppendGreedyOrder(greedyScratchSequences, greedyScratchList);
+	unsigned int greedyStateChanges = stateChangeCount - stateChanges;
+	stateChangeCount = stateChanges;
+	totalNrOfDrawCalls = drawCalls;
+	return greedyStateChanges;
+}
+
+inline bool Render::IsSequenceVisible(Object* object, Material* mat)
+{
+	const std::vector<unsigned char>* visibleObjects = mat->rps->visibleObjects;
+	const Bounds* bounds = object->bounds;
+	//bounds set up from the same mesh give exactly the sphere computed below, so the shared tree result can be used
+	if (visibleObjects != nullptr && bounds != nullptr && object->ID < visibleObjects->size() && SceneGraph::Instance()->boundsTree.Contains(object)
+		&& bounds->centerOfMesh == mat->vao->center && bounds->dimensions == mat->vao->dimensions)
+	{
+		return (*visibleObjects)[object->ID] != 0;
+	}
+
+	glm::mat4 meshCenter(1);
+
+	MathUtils::SetPosition(meshCenter, mat->vao->center);
+	auto centerTransform = meshCenter * object->node->TopDownTransform;
+	auto centeredPosition = MathUtils::GetPosition(centerTransform);
+	auto halfExtents = (mat->vao->dimensions * object->node->totalScale) * 0.5f;
+
+	//auto radius = std::max(std::max(halfExtents.x, halfExtents.y), halfExtents.z); //perfect for sphere, radius around geometry
+	auto circumRadius = glm::length(halfExtents);
+	//per mesh frustum culling instead of per object
+	//currently we can do frustum culling per object but you can have multiple materials and draw same object with multiple shapes
+	//we can also create separate objects with one material for each mesh
+	//this way we can easily do the frustum check on the bounds
+	return mat->rps->frustum.isBoundingSphereInView(centeredPosition, circumRadius);
+}
+
+inline void Render::RegisterSequenceRegistries(Object* object, std::vector<Material*>& materialSequence)
+{
+	//we have to figure out how to avoid adding same materials
+	for (auto mat : materialSequence)
+	{
+		if (mat->op != nullptr)
+		{
+			if (mat->op->vbos.size() > 0) mat->op->registries.push_back(&object->registry); //only meant for instanced stuff
+			mat->op->SetDataRegistry(&object->registry);
+		}
+	}
+}
+
+void Render::AppendGreedyOrder(std::vector<std::vector<Material*>*>& passMaterialSequences, std::vector<RenderElement*>& renderList)
+{
+	auto& materialSequence = *passMaterialSequences[0];
+	std::vector<RenderElement*> activeElements(7, nullptr); //maybe we can keep it alive between passes so that if we do new pass we can compare stuff if they are different so we even optimize render pass bindings
+	//for each sequence order is determined
+	//this means we just want to push materials in order to the render list
+	//we just don't want to push same elements
+	UpdateCurrentMaterialAndRenderList(activeElements, renderList, materialSequence);
+
+	passMaterialSequences[0] = passMaterialSequences.back();
+	passMaterialSequences.pop_back();
+	//for current materialSequence in the pass
+	for (size_t i = 0; i < passMaterialSequences.size(); i++)
+	{
+		int foundDifferences = INT_MAX;
+		Material* foundMaterial = nullptr;
+		int foundMaterialIndex = -1;
+		//find the material with the least differences when compared to current material
+		FindLeastDifferentMaterial(activeElements, passMaterialSequences, i, foundDifferences, foundMaterial, foundMaterialIndex);
+		std::vector<Material*>& foundMaterialSequence = *passMaterialSequences[foundMaterialIndex];
+		if (foundDifferences > 0) //avoid all duplicates, I could avoid it entirely if I used the set instead of vector
+		{
+			UpdateCurrentMaterialAndRenderList(activeElements, renderList, foundMaterialSequence);
+		}
+		//if current material was not the found one then we put it in the index of the found one so that when we go to next material in next iteration we still have a chance to compare this material
+		passMaterialSequences[foundMaterialIndex] = passMaterialSequences[i];
+	}
+}
+
 inline void Render::FindLeastDifferentMaterial(std::vector<RenderElement*>& currentMaterial, std::vector<std::vector<Material*>*>& listOfMaterialSequences, int startFrom, int& outDifferencesCount, Material* outLeastDifferentMaterial, int& outLeastDifferentMaterialIndex)
 {
 	int foundDifferences = INT_MAX;
@@ -121,7 +255,11 @@ inline void Render::UpdateCurrentMaterialAndRenderList(std::vector<RenderElement
 			if (foundMatElement != activeElement)
 			{
 				currentMaterial[j] = foundMatElement;
-				if (foundMatElement != nullptr) renderList.push_back(foundMatElement);
+				if (foundMatElement != nullptr)
+				{
+					renderList.push_back(foundMatElement);
+					stateChangeCount++;
+				}
 			}
 		}
 
@@ -142,31 +280,19 @@ Render::Instance()
 	return &instance;
 }
 
-void Render::GenerateGraph()
+void Render::GenerateFullRenderList()
 {
-	std::chrono::time_point<std::chrono::high_resolution_clock> start, end, startGeneration, endGeneration;
+	std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
 	std::chrono::duration<double> elapsed_seconds;
 
 	start = std::chrono::high_resolution_clock::now();
-	startGeneration = start;
-	//we could say that material is an internal material structure for one object
-	//they are created and changed by the other user friendly material interface
-	//we should reserve the number of materials per pass by looking at how much it was in last frame and adding a bit 
-	uniqueMaterialSequencesPerPass.clear(); //they are not unique unless we use std::set instead of std::vector
-	int materialCount = 0;
-
-	for (auto pass : GraphicsStorage::renderingQueue)
+	//inner vectors are cleared instead of dropped so their capacity carries over to the next frame
+	materialSequencesPerPass.resize(GraphicsStorage::renderingQueue.size());
+	for (auto& passMaterialSequences : materialSequencesPerPass)
 	{
-		auto vpProperty = ((RenderPass*)pass)->registry.GetProperty("VP");
-		if (vpProperty != nullptr)
-		{
-			((RenderPass*)pass)->frustum.ExtractPlanes(*(glm::mat4*)vpProperty->dataAddress);
-		}
-		else
-		{
-			((RenderPass*)pass)->frustum.ExtractPlanes(CameraManager::Instance()->ViewProjection);
-		}
+		passMaterialSequences.clear();
 	}
+	int materialCount = 0;
 
 	//is it really a good idea to check frustum per pass?
 	//we check all objects multiple times depending on the pass they are rendered in
@@ -205,50 +331,22 @@ void Render::GenerateGraph()
 		for (auto& materialSq : object->materials)
 		{
 			Material* mat = materialSq[0];
-			if (mat->unbound || materialSq[0]->vao == nullptr)
+			//passes that are not in the rendering queue would never be drawn
+			if (mat->rps == nullptr || mat->rps->queueStamp != graphStamp) continue;
+			if (mat->unbound || mat->vao == nullptr)
 			{
-				//we have to figure out how to avoid adding same materials
-				for (auto mat : materialSq)
-				{
-					if (mat->op != nullptr)
-					{
-						if (mat->op->vbos.size() > 0) mat->op->registries.push_back(&object->registry); //only meant for instanced stuff
-						mat->op->SetDataRegistry(&object->registry);
-					}
-				}
-				uniqueMaterialSequencesPerPass[materialSq[0]->rps].push_back(&materialSq);
+				RegisterSequenceRegistries(object, materialSq);
+				materialSequencesPerPass[mat->rps->queueIndex].push_back(&materialSq);
 				materialCount += materialSq.size();
 			}
 			else
 			{
-				glm::mat4 meshCenter(1);
-
-				MathUtils::SetPosition(meshCenter, materialSq[0]->vao->center);
-				auto centerTransform = meshCenter * object->node->TopDownTransform;
-				auto centeredPosition = MathUtils::GetPosition(centerTransform);
-				auto halfExtents = (materialSq[0]->vao->dimensions * object->node->totalScale) * 0.5f;
-
-				//auto radius = std::max(std::max(halfExtents.x, halfExtents.y), halfExtents.z); //perfect for sphere, radius around geometry
-				auto circumRadius = glm::length(halfExtents);
-				//per mesh frustum culling instead of per object
-				//currently we can do frustum culling per object but you can have multiple materials and draw same object with multiple shapes
-				//we can also create separate objects with one material for each mesh
-				//this way we can easily do the frustum check on the bounds
-				bool inFrustum = materialSq[0]->rps->frustum.isBoundingSphereInView(centeredPosition, circumRadius);
-				//bool inFrustum = materialSq[0]->rps->frustum.isBoundingSphereInView(boundsComp->centeredPosition, boundsComp->circumRadius);
+				bool inFrustum = IsSequenceVisible(object, mat);
 				object->inFrustum = inFrustum;
 				if (inFrustum)
 				{
-					//we have to figure out how to avoid adding same materials
-					for (auto mat : materialSq)
-					{
-						if (mat->op != nullptr)
-						{
-							if (mat->op->vbos.size() > 0) mat->op->registries.push_back(&object->registry); //only meant for instanced stuff
-							mat->op->SetDataRegistry(&object->registry);
-						}
-					}
-					uniqueMaterialSequencesPerPass[materialSq[0]->rps].push_back(&materialSq);
+					RegisterSequenceRegistries(object, materialSq);
+					materialSequencesPerPass[mat->rps->queueIndex].push_back(&materialSq);
 					materialCount += materialSq.size();
 				}
 			}
@@ -263,41 +361,218 @@ void Render::GenerateGraph()
 	finalRenderList.clear();
 	finalRenderList.reserve(materialCount * 7);
 	totalNrOfDrawCalls = 0;
+	stateChangeCount = 0;
+	greedyStateChangeCount = 0;
 
-	for (auto& pass : GraphicsStorage::renderingQueue) //render passes are in order
+	for (auto& passMaterialSequences : materialSequencesPerPass) //render passes are in order
 	{
-		auto passMaterialSequencesPairIt = uniqueMaterialSequencesPerPass.find(pass);
-		if (passMaterialSequencesPairIt != uniqueMaterialSequencesPerPass.end())
+		if (passMaterialSequences.empty()) continue;
+		if (compareWithGreedyOrder)
 		{
-			auto& passMaterialSequencesPair = (*passMaterialSequencesPairIt);
-			auto& passMaterialSequences = passMaterialSequencesPair.second;
-			auto& materialSequence = *passMaterialSequences[0];
-			std::vector<RenderElement*> activeElements(7, nullptr); //maybe we can keep it alive between passes so that if we do new pass we can compare stuff if they are different so we even optimize render pass bindings
-			//for each sequence order is determined
-			//this means we just want to push materials in order to the render list
-			//we just don't want to push same elements
-			UpdateCurrentMaterialAndRenderList(activeElements, finalRenderList, materialSequence);
-			
-			passMaterialSequences[0] = passMaterialSequences.back();
-			passMaterialSequences.pop_back();
-			//for current materialSequence in the pass
-			for (size_t i = 0; i < passMaterialSequences.size(); i++)
-			{
-				int foundDifferences = INT_MAX;
-				Material* foundMaterial = nullptr;
-				int foundMaterialIndex = -1;
-				//find the material with the least differences when compared to current material
-				FindLeastDifferentMaterial(activeElements, passMaterialSequences, i, foundDifferences, foundMaterial, foundMaterialIndex);
-				std::vector<Material*>& foundMaterialSequence = *passMaterialSequences[foundMaterialIndex];
-				if (foundDifferences > 0) //avoid all duplicates, I could avoid it entirely if I used the set instead of vector
-				{
-					UpdateCurrentMaterialAndRenderList(activeElements, finalRenderList, foundMaterialSequence);
-				}
-				//if current material was not the found one then we put it in the index of the found one so that when we go to next material in next iteration we still have a chance to compare this material
-				passMaterialSequences[foundMaterialIndex] = passMaterialSequences[i];
-			}
+			greedyStateChangeCount += CountGreedyStateChanges(passMaterialSequences);
+		}
+		if (useSortKeyRenderList)
+		{
+			AppendSortedOrder(passMaterialSequences, finalRenderList);
+		}
+		else
+		{
+			AppendGreedyOrder(passMaterialSequences, finalRenderList);
 		}
 	}
+
+	end = std::chrono::high_resolution_clock::now();
+	elapsed_seconds = end - start;
+	treeGenerationTime = elapsed_seconds.count();
+}
+
+void Render::RebuildRetainedRenderList()
+{
+	retainedSequences.clear();
+	retainedPasses.clear();
+	retainedPasses.resize(GraphicsStorage::renderingQueue.size());
+
+	SceneGraph* sceneGraph = SceneGraph::Instance();
+	for (auto& object : sceneGraph->allObjects)
+	{
+		for (auto& materialSq : object->materials)
+		{
+			Material* mat = materialSq[0];
+			if (mat->rps == nullptr || mat->rps->queueStamp != graphStamp) continue;
+			RetainedSequence retained;
+			retained.object = object;
+			retained.sequence = &materialSq;
+			retained.passIndex = mat->rps->queueIndex;
+			retained.alwaysVisible = mat->unbound || mat->vao == nullptr;
+			retained.visible = false;
+			retainedSequences.push_back(retained);
+		}
+	}
+
+	//one stable sort over every sequence, handing them out in sorted order keeps each pass sorted
+	sortPairs.resize(retainedSequences.size());
+	for (size_t i = 0; i < retainedSequences.size(); i++)
+	{
+		sortPairs[i].key = MakeSortKey((*retainedSequences[i].sequence)[0]);
+		sortPairs[i].value = (uint32_t)i;
+	}
+	RadixSort::Sort(sortPairs, sortScratch);
+	for (auto& pair : sortPairs)
+	{
+		retainedPasses[retainedSequences[pair.value].passIndex].order.push_back(pair.value);
+	}
+
+	retainedQueue = GraphicsStorage::renderingQueue;
+	retainedObjectCount = sceneGraph->allObjects.size();
+	retainedHierarchyVersion = Node::hierarchyVersion;
+	retainedMaterialsVersion = Object::materialsVersion;
+	retainedElementsVersion = Material::elementsVersion;
+	retainedCompareWithGreedyOrder = compareWithGreedyOrder;
+	retainedValid = true;
+	retainedRebuildCount++;
+}
+
+void Render::UpdateRetainedRenderList()
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+	std::chrono::duration<double> elapsed_seconds;
+
+	start = std::chrono::high_resolution_clock::now();
+	//object profiles drop their instance registries after every upload so visible sequences register again each frame
+	//the pass lists only change when a sequence goes in or out of view
+	for (auto& retained : retainedSequences)
+	{
+		bool visible = true;
+		if (!retained.alwaysVisible)
+		{
+			visible = IsSequenceVisible(retained.object, (*retained.sequence)[0]);
+			retained.object->inFrustum = visible;
+		}
+		if (visible) RegisterSequenceRegistries(retained.object, *retained.sequence);
+		if (visible != retained.visible)
+		{
+			retained.visible = visible;
+			retainedPasses[retained.passIndex].dirty = true;
+		}
+	}
+	if (retainedCompareWithGreedyOrder != compareWithGreedyOrder)
+	{
+		retainedCompareWithGreedyOrder = compareWithGreedyOrder;
+		for (auto& pass : retainedPasses) pass.dirty = true;
+	}
+	end = std::chrono::high_resolution_clock::now();
+	elapsed_seconds = end - start;
+	countingElementsTime = elapsed_seconds.count();
+
+	start = std::chrono::high_resolution_clock::now();
+	patchedPassCount = 0;
+	for (auto& pass : retainedPasses)
+	{
+		if (!pass.dirty) continue;
+		orderedSequences.clear();
+		for (auto index : pass.order)
+		{
+			if (retainedSequences[index].visible) orderedSequences.push_back(retainedSequences[index].sequence);
+		}
+		unsigned int drawCalls = totalNrOfDrawCalls;
+		unsigned int stateChanges = stateChangeCount;
+		pass.renderList.clear();
+		EmitSequences(orderedSequences, pass.renderList);
+		pass.drawCalls = totalNrOfDrawCalls - drawCalls;
+		pass.stateChanges = stateChangeCount - stateChanges;
+		pass.greedyStateChanges = compareWithGreedyOrder && !orderedSequences.empty() ? CountGreedyStateChanges(orderedSequences) : 0;
+		pass.dirty = false;
+		patchedPassCount++;
+	}
+
+	if (patchedPassCount > 0)
+	{
+		size_t elementCount = 0;
+		for (auto& pass : retainedPasses) elementCount += pass.renderList.size();
+		finalRenderList.clear();
+		finalRenderList.reserve(elementCount);
+		totalNrOfDrawCalls = 0;
+		stateChangeCount = 0;
+		greedyStateChangeCount = 0;
+		for (auto& pass : retainedPasses)
+		{
+			finalRenderList.insert(finalRenderList.end(), pass.renderList.begin(), pass.renderList.end());
+			totalNrOfDrawCalls += pass.drawCalls;
+			stateChangeCount += pass.stateChanges;
+			greedyStateChangeCount += pass.greedyStateChanges;
+		}
+	}
+	end = std::chrono::high_resolution_clock::now();
+	elapsed_seconds = end - start;
+	treeGenerationTime = elapsed_seconds.count();
+}
+
+void Render::GenerateGraph()
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start, end, startGeneration, endGeneration;
+	std::chrono::duration<double> elapsed_seconds;
+
+	start = std::chrono::high_resolution_clock::now();
+	startGeneration = start;
+	//we could say that material is an internal material structure for one object
+	//they are created and changed by the other user friendly material interface
+	//we should reserve the number of materials per pass by looking at how much it was in last frame and adding a bit 
+	//they are not unique unless we use std::set instead of std::vector
+	graphStamp++;
+
+	for (size_t i = 0; i < GraphicsStorage::renderingQueue.size(); i++)
+	{
+		RenderPass* renderPass = (RenderPass*)GraphicsStorage::renderingQueue[i];
+		renderPass->queueIndex = (unsigned int)i;
+		renderPass->queueStamp = graphStamp;
+	}
+
+	for (auto pass : GraphicsStorage::renderingQueue)
+	{
+		auto vpProperty = ((RenderPass*)pass)->registry.GetProperty("VP");
+		if (vpProperty != nullptr)
+		{
+			((RenderPass*)pass)->frustum.ExtractPlanes(*(glm::mat4*)vpProperty->dataAddress);
+		}
+		else
+		{
+			((RenderPass*)pass)->frustum.ExtractPlanes(CameraManager::Instance()->ViewProjection);
+		}
+	}
+
+	SceneGraph* sceneGraph = SceneGraph::Instance();
+	if (sceneGraph->useBoundsTree)
+	{
+		sceneGraph->UpdateBoundsTree();
+		for (auto pass : GraphicsStorage::renderingQueue)
+		{
+			RenderPass* renderPass = (RenderPass*)pass;
+			renderPass->visibleObjects = &sceneGraph->CullBoundsTree(renderPass->frustum).visible;
+		}
+	}
+	else
+	{
+		for (auto pass : GraphicsStorage::renderingQueue)
+		{
+			((RenderPass*)pass)->visibleObjects = nullptr;
+		}
+	}
+
+	if (useRetainedRenderList && useSortKeyRenderList)
+	{
+		if (!retainedValid || retainedObjectCount != sceneGraph->allObjects.size() || retainedHierarchyVersion != Node::hierarchyVersion
+			|| retainedMaterialsVersion != Object::materialsVersion || retainedElementsVersion != Material::elementsVersion || retainedQueue != GraphicsStorage::renderingQueue)
+		{
+			RebuildRetainedRenderList();
+		}
+		UpdateRetainedRenderList();
+	}
+	else
+	{
+		retainedValid = false;
+		GenerateFullRenderList();
+	}
+	end = std::chrono::high_resolution_clock::now();
 	//if (currentVao != nullptr) // because last pass could have been without the actual draw, like blit pass, we should really fix this in the UpdateCurrentMaterialAndRenderList function above
 	//{
 	//	//have to push the last draw of the last material, for now this works
@@ -306,9 +581,6 @@ void Render::GenerateGraph()
 	//}
 	
 
-	end = std::chrono::high_resolution_clock::now();
-	elapsed_seconds = end - start;
-	treeGenerationTime = elapsed_seconds.count();
 	endGeneration = end;
 	elapsed_seconds = endGeneration - startGeneration;
 	totalGenerationTime = elapsed_seconds.count();
@@ -316,7 +588,18 @@ void Render::GenerateGraph()
 	if (showRenderList)
 	{
 		ImGui::Begin("Generated Render List", &showRenderList);
+		ImGui::Checkbox("Sort Key Order", &useSortKeyRenderList);
+		ImGui::Checkbox("Compare With Greedy Order", &compareWithGreedyOrder);
+		ImGui::Checkbox("Retained Render List", &useRetainedRenderList);
+		ImGui::Text("Patched Passes: %d", patchedPassCount);
+		ImGui::Text("Render List Rebuilds: %d", retainedRebuildCount);
 		ImGui::Text("Draw Calls: %d", totalNrOfDrawCalls);
+		ImGui::Text("State Changes: %d", stateChangeCount);
+		if (compareWithGreedyOrder)
+		{
+			ImGui::Text("Greedy State Changes: %d", greedyStateChangeCount);
+			ImGui::Text("State Changes Removed: %d", (int)greedyStateChangeCount - (int)stateChangeCount);
+		}
 		ImGui::Text("Render List Elements: %d", finalRenderList.size());
 		ImGui::Text("Render List Size: %d bytes", finalRenderList.size() * sizeof(RenderElement*));
 		for (auto& element : finalRenderList)
@@ -492,7 +775,7 @@ Render::drawGeometry(const GLuint shaderID, const std::vector<Object*>& objects,
 	{
 		if (object->inFrustum)
 		{
-			o_gbd->SetData("M", &object->node->TopDownTransformF, sizeof(Matrix4F));
+			o_gbd->SetData("M", &object->node->TopDownTransform, sizeof(Matrix4F));
 			o_gbd->SetData("objectID", &object->ID, sizeof(unsigned int));
 			m_gbd->SetData("tiling", &tiling, sizeof(Vector2F));
 			m_gbd->SetData("MaterialColorShininess", &matColShininess, sizeof(Vector4F));
@@ -622,7 +905,7 @@ Render::drawSingle(const GLuint shaderID, const Object* object, const glm::mat4
 {
 	Vector2F tiling(1, 1);
 	Vector4F matColShininess(0, 0, 0, 40);
-	o_gbd->SetData("M", &object->node->TopDownTransformF, sizeof(Matrix4F));
+	o_gbd->SetData("M", &object->node->TopDownTransform, sizeof(Matrix4F));
 	o_gbd->SetData("objectID", &object->ID, sizeof(unsigned int));
 	m_gbd->SetData("tiling", &tiling, sizeof(Vector2F));
 	m_gbd->SetData("MaterialColorShininess", &matColShininess, sizeof(Vector4F));
@@ -653,7 +936,7 @@ Render::drawPicking(const GLuint shaderID, std::unordered_map<unsigned int, Obje
 		object = objectPair.second;
 		if (object->inFrustum)
 		{
-			o_gbd->SetData("M", &object->node->TopDownTransformF, sizeof(Matrix4F));
+			o_gbd->SetData("M", &object->node->TopDownTransform, sizeof(Matrix4F));
 			o_gbd->SetData("objectID", &object->ID, sizeof(unsigned int));
 			o_gbd->Submit();
 
@@ -677,7 +960,7 @@ Render::drawDepth(const const GLuint shaderID, const std::vector<Object*>& objec
 	for (auto object : objects)
 	{
 		m_lvpbd->SetData("lightVP", &ViewProjection, sizeof(Matrix4F));
-		o_gbd->SetData("M", &object->node->TopDownTransformF, sizeof(Matrix4F));
+		o_gbd->SetData("M", &object->node->TopDownTransform, sizeof(Matrix4F));
 		
 		m_lvpbd->Submit();
 		o_gbd->Submit();
@@ -718,7 +1001,7 @@ Render::drawCubeDepth(const GLuint shaderID, const std::vector<Object*>& objects
 		centerDistance = glm::length(light->bounds->centeredPosition - object->bounds->centeredPosition);
 		if (centerDistance < radiusDistance)
 		{
-			glUniformMatrix4fv(ModelHandle, 1, GL_FALSE, &object->node->TopDownTransformF[0][0]);
+			glUniformMatrix4fv(ModelHandle, 1, GL_FALSE, &object->node->TopDownTransform[0][0]);
 
 			object->materials[0][0]->vao->Bind();
 			object->materials[0][0]->vao->Draw();
@@ -1049,7 +1332,7 @@ Render::drawPointLights(const GLuint shaderID, const GLuint shadowShaderID, Pool
 
 			float lightRadius = (float)light.object->bounds->radius;
 
-			o_lpbd->SetData("lightPosition", &light.object->node->TopDownTransformF[3], sizeof(glm::vec3));
+			o_lpbd->SetData("lightPosition", &light.object->node->TopDownTransform[3], sizeof(glm::vec3));
 			o_lpbd->SetData("lightRadius", &lightRadius, sizeof(float));
 			o_lpbd->SetData("constant", &light.attenuation.Constant, sizeof(float));
 			o_lpbd->SetData("linear", &light.attenuation.Linear, sizeof(float));
@@ -1061,7 +1344,7 @@ Render::drawPointLights(const GLuint shaderID, const GLuint shadowShaderID, Pool
 			m_lbd->SetData("diffuse", &light.properties.diffuse, sizeof(float));
 			m_lbd->SetData("specular", &light.properties.specular, sizeof(float));
 
-			o_gbd->SetData("M", &light.object->node->TopDownTransformF, sizeof(Matrix4F));
+			o_gbd->SetData("M", &light.object->node->TopDownTransform, sizeof(Matrix4F));
 
 			o_lpbd->Submit();
 			m_lbd->Submit();
@@ -1172,7 +1455,7 @@ Render::drawSpotLights(const GLuint shaderID, const GLuint shadowShaderID, PoolP
 				}
 				float lightRadius = (float)light.object->bounds->radius;
 				o_lssbd->SetData("depthBiasMVP", &light.BiasedLightMatrixVP, sizeof(glm::mat4));
-				o_lssbd->SetData("lightPosition", &light.object->node->TopDownTransformF[3], sizeof(glm::vec3));
+				o_lssbd->SetData("lightPosition", &light.object->node->TopDownTransform[3], sizeof(glm::vec3));
 				o_lssbd->SetData("lightInvDir", &light.LightInvDir, sizeof(glm::vec3));
 				o_lssbd->SetData("outerCutOff", &light.cosOuterCutOff, sizeof(float));
 				o_lssbd->SetData("innerCutOff", &light.cosInnerCutOff, sizeof(float));
@@ -1186,7 +1469,7 @@ Render::drawSpotLights(const GLuint shaderID, const GLuint shadowShaderID, PoolP
 			{
 				lightShader = lightShaderNoShadows;
 				float lightRadius = (float)light.object->bounds->radius;
-				o_lsbd->SetData("lightPosition", &light.object->node->TopDownTransformF[3], sizeof(glm::vec3));
+				o_lsbd->SetData("lightPosition", &light.object->node->TopDownTransform[3], sizeof(glm::vec3));
 				o_lsbd->SetData("lightInvDir", &light.LightInvDir, sizeof(glm::vec3));
 				o_lsbd->SetData("outerCutOff", &light.cosOuterCutOff, sizeof(float));
 				o_lsbd->SetData("innerCutOff", &light.cosInnerCutOff, sizeof(float));
@@ -1222,7 +1505,7 @@ Render::drawSpotLights(const GLuint shaderID, const GLuint shadowShaderID, PoolP
 			m_lbd->SetData("diffuse", &light.properties.diffuse, sizeof(float));
 			m_lbd->SetData("specular", &light.properties.specular, sizeof(float));
 
-			o_gbd->SetData("M", &light.object->node->TopDownTransformF, sizeof(glm::mat4));
+			o_gbd->SetData("M", &light.object->node->TopDownTransform, sizeof(glm::mat4));
 
 			m_lbd->Submit();
 			o_gbd->Submit();
@@ -1536,7 +1819,18 @@ void Render::RenderGraph()
 	if (showRenderList)
 	{
 		ImGui::Begin("Render List", &showRenderList);
+		ImGui::Checkbox("Sort Key Order", &useSortKeyRenderList);
+		ImGui::Checkbox("Compare With Greedy Order", &compareWithGreedyOrder);
+		ImGui::Checkbox("Retained Render List", &useRetainedRenderList);
+		ImGui::Text("Patched Passes: %d", patchedPassCount);
+		ImGui::Text("Render List Rebuilds: %d", retainedRebuildCount);
 		ImGui::Text("Draw Calls: %d", totalNrOfDrawCalls);
+		ImGui::Text("State Changes: %d", stateChangeCount);
+		if (compareWithGreedyOrder)
+		{
+			ImGui::Text("Greedy State Changes: %d", greedyStateChangeCount);
+			ImGui::Text("State Changes Removed: %d", (int)greedyStateChangeCount - (int)stateChangeCount);
+		}
 		for (auto& element : finalRenderList)
 		{
 			if (dynamic_cast<RenderProfile*>(element) != nullptr)
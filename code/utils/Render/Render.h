@@ -9,6 +9,7 @@
 #include "MaterialProfile.h"
 #include <array>
 #include "GraphicsStorage.h"
+#include "RadixSort.h"
 
 class Matrix4;
 class Object;
@@ -22,6 +23,7 @@ class InstanceSystem;
 class FastInstanceSystem;
 class RenderPass;
 struct RenderNode;
+enum class MaterialElements;
 
 class Render
 {
@@ -84,6 +86,16 @@ public:
 	double executingGraphTime;
 	double totalGenerationTime;
 	unsigned int totalNrOfDrawCalls;
+	//state elements pushed to the render list, draws not included
+	unsigned int stateChangeCount = 0;
+	//what the greedy least different ordering would have pushed, only counted when compareWithGreedyOrder is on
+	unsigned int greedyStateChangeCount = 0;
+	bool useSortKeyRenderList = true;
+	bool compareWithGreedyOrder = false;
+	//keeps the per pass lists between frames, they are patched when visibility changes and rebuilt when objects, materials or passes change
+	bool useRetainedRenderList = true;
+	unsigned int patchedPassCount = 0;
+	unsigned int retainedRebuildCount = 0;
 	bool showRenderList = false;
 private:
 	void BlurOnOneAxis(Texture* sourceTexture, FrameBuffer* destinationFbo, float offsetxVal, float offsetyVal, GLuint offsetHandle);
@@ -93,7 +105,49 @@ private:
     ~Render();
 	VertexArray* previousVao;
 	VertexArray* currentVao;
-	std::unordered_map<RenderElement*, std::vector<std::vector<Material*>*>> uniqueMaterialSequencesPerPass;
+	//material sequences per pass, indexed by the pass position in the rendering queue
+	std::vector<std::vector<std::vector<Material*>*>> materialSequencesPerPass;
+	std::vector<std::vector<Material*>*> greedyScratchSequences;
+	std::vector<RenderElement*> greedyScratchList;
+	std::vector<std::vector<Material*>*> orderedSequences;
+	std::vector<SortPair> sortPairs;
+	std::vector<SortPair> sortScratch;
+	unsigned int graphStamp = 0;
+	unsigned int nextSortIds[7] = {};
+
+	struct RetainedSequence
+	{
+		Object* object;
+		std::vector<Material*>* sequence;
+		unsigned int passIndex;
+		bool alwaysVisible;
+		bool visible;
+	};
+	struct RetainedPass
+	{
+		std::vector<unsigned int> order; //retained sequence indices sorted by state key
+		std::vector<RenderElement*> renderList;
+		unsigned int drawCalls = 0;
+		unsigned int stateChanges = 0;
+		unsigned int greedyStateChanges = 0;
+		bool dirty = true;
+	};
+	std::vector<RetainedSequence> retainedSequences;
+	std::vector<RetainedPass> retainedPasses;
+	std::vector<RenderElement*> retainedQueue;
+	size_t retainedObjectCount = 0;
+	unsigned int retainedHierarchyVersion = 0;
+	unsigned int retainedMaterialsVersion = 0;
+	unsigned int retainedElementsVersion = 0;
+	bool retainedCompareWithGreedyOrder = false;
+	bool retainedValid = false;
+	void GenerateFullRenderList();
+	void RebuildRetainedRenderList();
+	void UpdateRetainedRenderList();
+	inline bool IsSequenceVisible(Object* object, Material* mat);
+	inline void RegisterSequenceRegistries(Object* object, std::vector<Material*>& materialSequence);
+	void EmitSequences(const std::vector<std::vector<Material*>*>& sequencesInOrder, std::vector<RenderElement*>& renderList);
+	unsigned int CountGreedyStateChanges(const std::vector<std::vector<Material*>*>& passMaterialSequences);
 	FrameBuffer* pingPongBuffers[2];
 	std::vector<FrameBuffer*> multiBlurBufferStart;
 	std::vector<FrameBuffer*> multiBlurBufferTarget;
@@ -119,5 +173,9 @@ private:
 	//depth
 	ShaderBlockData* m_lvpbd;
 	inline void FindLeastDifferentMaterial(std::vector<RenderElement*>& currentMaterial, std::vector<std::vector<Material*>*>& listOfMaterialSequences, int startFrom, int& outDifferencesCount, Material* outLeastDifferentMaterial, int& outLeastDifferentMaterialIndex);
+	inline uint64_t MakeSortKey(const Material* mat);
+	inline unsigned int GetSortId(RenderElement* element, MaterialElements field);
+	void AppendGreedyOrder(std::vector<std::vector<Material*>*>& passMaterialSequences, std::vector<RenderElement*>& renderList);
+	void AppendSortedOrder(std::vector<std::vector<Material*>*>& passMaterialSequences, std::vector<RenderElement*>& renderList);
 	inline void UpdateCurrentMaterialAndRenderList(std::vector<RenderElement*>& currentMaterial, std::vector<RenderElement*>& renderList, std::vector<Material*>& materialSequence);
 };
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "BoundsTree.h"
+#include "Object.h"
+#include "Bounds.h"
+#include "Frustum.h"
+#include <algorithm>
+#include <cfloat>
+
+static const unsigned int noParent = 0xFFFFFFFFu;
+
+BoundsTree::BoundsTree()
+{
+	version = 0;
+	testedTreeNodes = 0;
+	testedLeaves = 0;
+}
+
+BoundsTree::~BoundsTree()
+{
+}
+
+void BoundsTree::Clear()
+{
+	nodes.clear();
+	itemX.clear();
+	itemY.clear();
+	itemZ.clear();
+	itemRadius.clear();
+	itemObjects.clear();
+	itemLeaves.clear();
+	dynamicItems.clear();
+	dynamicItemVersions.clear();
+	containedObjects.clear();
+}
+
+bool BoundsTree::Contains(const Object* object) const
+{
+	return object->ID < containedObjects.size() && containedObjects[object->ID] != 0;
+}
+
+void BoundsTree::Build(const std::vector<Object*>& objects)
+{
+	Clear();
+	version++;
+
+	std::vector<BuildItem> buildItems;
+	buildItems.reserve(objects.size());
+	for (auto object : objects)
+	{
+		if (object->bounds != nullptr)
+		{
+			buildItems.push_back({ object->bounds->centeredPosition, (float)object->bounds->circumRadius, object });
+		}
+	}
+	if (buildItems.empty()) return;
+	containedObjects.assign(Object::Count(), 0);
+	for (auto& item : buildItems)
+	{
+		if (item.object->ID < containedObjects.size()) containedObjects[item.object->ID] = 1;
+	}
+
+	nodes.reserve(2 * (buildItems.size() / leafSize + 1));
+	nodes.emplace_back();
+	BuildNode(buildItems, 0, buildItems.size(), noParent, 0);
+
+	for (unsigned int i = 0; i < itemObjects.size(); i++)
+	{
+		Object* object = itemObjects[i];
+		if (object != nullptr && object->node->GetTotalMovable())
+		{
+			dynamicItems.push_back(i);
+			dynamicItemVersions.push_back(object->bounds->version);
+		}
+	}
+}
+
+void BoundsTree::BuildNode(std::vector<BuildItem>& buildItems, size_t begin, size_t end, unsigned int parent, unsigned int nodeIndex)
+{
+	nodes[nodeIndex].parent = parent;
+	size_t count = end - begin;
+	if (count <= leafSize)
+	{
+		unsigned int first = (unsigned int)itemObjects.size();
+		for (size_t i = 0; i < leafSize; i++)
+		{
+			bool used = i < count;
+			const BuildItem* item = used ? &buildItems[begin + i] : nullptr;
+			itemX.push_back(used ? item->center.x : 0.f);
+			itemY.push_back(used ? item->center.y : 0.f);
+			itemZ.push_back(used ? item->center.z : 0.f);
+			itemRadius.push_back(used ? item->radius : -FLT_MAX);
+			itemObjects.push_back(used ? item->object : nullptr);
+			itemLeaves.push_back(nodeIndex);
+		}
+		nodes[nodeIndex].first = first;
+		nodes[nodeIndex].count = (unsigned int)count;
+		FitLeaf(nodes[nodeIndex]);
+		return;
+	}
+
+	//median split along the widest axis of the sphere centers
+	glm::vec3 centerMin = buildItems[begin].center;
+	glm::vec3 centerMax = centerMin;
+	for (size_t i = begin + 1; i < end; i++)
+	{
+		centerMin = glm::min(centerMin, buildItems[i].center);
+		centerMax = glm::max(centerMax, buildItems[i].center);
+	}
+	glm::vec3 spread = centerMax - centerMin;
+	int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+	size_t middle = begin + count / 2;
+	std::nth_element(buildItems.begin() + begin, buildItems.begin() + middle, buildItems.begin() + end,
+		[axis](const BuildItem& a, const BuildItem& b) { return a.center[axis] < b.center[axis]; });
+
+	unsigned int children = (unsigned int)nodes.size();
+	nodes.emplace_back();
+	nodes.emplace_back();
+	BuildNode(buildItems, begin, middle, nodeIndex, children);
+	BuildNode(buildItems, middle, end, nodeIndex, children + 1);
+
+	TreeNode& node = nodes[nodeIndex];
+	node.first = children;
+	node.count = 0;
+	node.min = glm::min(nodes[children].min, nodes[children + 1].min);
+	node.max = glm::max(nodes[children].max, nodes[children + 1].max);
+}
+
+void BoundsTree::FitLeaf(TreeNode& leaf)
+{
+	leaf.min = glm::vec3(FLT_MAX);
+	leaf.max = glm::vec3(-FLT_MAX);
+	for (unsigned int i = leaf.first; i < leaf.first + leaf.count; i++)
+	{
+		glm::vec3 center(itemX[i], itemY[i], itemZ[i]);
+		glm::vec3 radius(itemRadius[i]);
+		leaf.min = glm::min(leaf.min, center - radius);
+		leaf.max = glm::max(leaf.max, center + radius);
+	}
+}
+
+bool BoundsTree::Refit()
+{
+	bool changed = false;
+	for (size_t i = 0; i < dynamicItems.size(); i++)
+	{
+		unsigned int item = dynamicItems[i];
+		const Bounds* bounds = itemObjects[item]->bounds;
+		if (bounds->version == dynamicItemVersions[i]) continue;
+		dynamicItemVersions[i] = bounds->version;
+		itemX[item] = bounds->centeredPosition.x;
+		itemY[item] = bounds->centeredPosition.y;
+		itemZ[item] = bounds->centeredPosition.z;
+		itemRadius[item] = (float)bounds->circumRadius;
+		changed = true;
+
+		//refit the leaf and walk up until an ancestor box does not change
+		unsigned int nodeIndex = itemLeaves[item];
+		FitLeaf(nodes[nodeIndex]);
+		nodeIndex = nodes[nodeIndex].parent;
+		while (nodeIndex != noParent)
+		{
+			TreeNode& node = nodes[nodeIndex];
+			glm::vec3 newMin = glm::min(nodes[node.first].min, nodes[node.first + 1].min);
+			glm::vec3 newMax = glm::max(nodes[node.first].max, nodes[node.first + 1].max);
+			if (newMin == node.min && newMax == node.max) break;
+			node.min = newMin;
+			node.max = newMax;
+			nodeIndex = node.parent;
+		}
+	}
+	if (changed) version++;
+	return changed;
+}
+
+void BoundsTree::Cull(const Frustum& frustum, std::vector<Object*>& visibleObjects)
+{
+	testedTreeNodes = 0;
+	testedLeaves = 0;
+	if (nodes.empty()) return;
+
+	stack.clear();
+	stack.emplace_back(0, Frustum::allPlanes);
+	while (!stack.empty())
+	{
+		unsigned int nodeIndex = stack.back().first;
+		unsigned int planeMask = stack.back().second;
+		stack.pop_back();
+		const TreeNode& node = nodes[nodeIndex];
+		testedTreeNodes++;
+
+		glm::vec3 center = (node.min + node.max) * 0.5f;
+		glm::vec3 extents = (node.max - node.min) * 0.5f;
+		if (frustum.IsBoxOutside(center, extents, planeMask)) continue;
+		if (planeMask == 0)
+		{
+			AcceptSubtree(nodeIndex, visibleObjects);
+			continue;
+		}
+		if (node.count > 0)
+		{
+			testedLeaves++;
+			unsigned int inView = frustum.AreSpheresInView4(&itemX[node.first], &itemY[node.first], &itemZ[node.first], &itemRadius[node.first], planeMask);
+			for (unsigned int i = 0; i < node.count; i++)
+			{
+				if (inView & (1u << i)) visibleObjects.push_back(itemObjects[node.first + i]);
+			}
+		}
+		else
+		{
+			stack.emplace_back(node.first + 1, planeMask);
+			stack.emplace_back(node.first, planeMask);
+		}
+	}
+}
+
+void BoundsTree::AcceptSubtree(unsigned int nodeIndex, std::vector<Object*>& visibleObjects)
+{
+	const TreeNode& node = nodes[nodeIndex];
+	if (node.count > 0)
+	{
+		for (unsigned int i = node.first; i < node.first + node.count; i++)
+		{
+			visibleObjects.push_back(itemObjects[i]);
+		}
+		return;
+	}
+	AcceptSubtree(node.first, visibleObjects);
+	AcceptSubtree(node.first + 1, visibleObjects);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include "MyMathLib.h"
+
+class Object;
+class Frustum;
+
+//bounding volume hierarchy over the bounding spheres of the scene objects
+//leaves hold up to four spheres stored side by side so one leaf is tested against a plane in one go
+//static objects are placed once on build, dynamic objects are refit when their bounds version changes
+class BoundsTree
+{
+public:
+	BoundsTree();
+	~BoundsTree();
+	void Build(const std::vector<Object*>& objects);
+	//returns true when any dynamic sphere changed
+	bool Refit();
+	//appends visible objects, subtrees fully inside the frustum are accepted without testing their spheres
+	void Cull(const Frustum& frustum, std::vector<Object*>& visibleObjects);
+	void Clear();
+	size_t Size() const { return itemObjects.size(); }
+	bool Contains(const Object* object) const;
+
+	//incremented on every build and on every refit that moved something
+	unsigned int version;
+	int testedTreeNodes;
+	int testedLeaves;
+
+	static const unsigned int leafSize = 4;
+private:
+	struct TreeNode
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+		unsigned int parent;
+		//index of the first child, children are stored next to each other, or first item slot for leaves
+		unsigned int first;
+		//number of items, zero for inner nodes
+		unsigned int count;
+	};
+	struct BuildItem
+	{
+		glm::vec3 center;
+		float radius;
+		Object* object;
+	};
+	void BuildNode(std::vector<BuildItem>& buildItems, size_t begin, size_t end, unsigned int parent, unsigned int nodeIndex);
+	void FitLeaf(TreeNode& leaf);
+	void AcceptSubtree(unsigned int nodeIndex, std::vector<Object*>& visibleObjects);
+
+	std::vector<TreeNode> nodes;
+	//spheres in leaf order, every leaf owns leafSize slots, unused slots have no object and never pass the test
+	std::vector<float> itemX;
+	std::vector<float> itemY;
+	std::vector<float> itemZ;
+	std::vector<float> itemRadius;
+	std::vector<Object*> itemObjects;
+	std::vector<unsigned int> itemLeaves;
+	std::vector<unsigned int> dynamicItems;
+	std::vector<unsigned int> dynamicItemVersions;
+	//indexed by object ID
+	std::vector<unsigned char> containedObjects;
+	std::vector<std::pair<unsigned int, unsigned int>> stack;
+};
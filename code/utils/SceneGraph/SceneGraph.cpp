@@ -12,6 +12,7 @@
 #include "InstanceSystem.h"
 #include "FastInstanceSystem.h"
 #include <chrono>
+#include <algorithm>
 #include "Frustum.h"
 #include "TextureProfile.h"
 #include "ScriptsComponent.h"
@@ -26,11 +27,21 @@
 #include "CircleSystem.h"
 #include "OBJ.h"
 #include "Script.h"
+#include "JobSystem.h"
 
 SceneGraph::SceneGraph()
 {
 	//SceneObject = nullptr;
-	dirtyDynamicArray = false;
+	dirtyDynamicArray = true;
+	transformHierarchyVersion = 0;
+	dirtyBoundsTree = true;
+	boundsTreeObjectCount = 0;
+	boundsTreeHierarchyVersion = 0;
+	nextCullResult = 0;
+	boundsTreeTime = 0.0;
+	cullTime = 0.0;
+	//entries are handed out by reference, never grow past the reserved size
+	cullResults.reserve(maxCullResults);
 	SceneRoot.name = "root";
 	SceneRoot.SetMovable(false);
 	ReInit();
@@ -291,6 +302,87 @@ void SceneGraph::unregisterForPicking(Object * object)
 	pickingList.erase(object->ID);
 }
 
+void SceneGraph::registerForPicking(InstanceSystem* system)
+{
+	if (std::find(pickableInstanceSystems.begin(), pickableInstanceSystems.end(), system) == pickableInstanceSystems.end()) pickableInstanceSystems.push_back(system);
+}
+
+void SceneGraph::registerForPicking(FastInstanceSystem* system)
+{
+	if (std::find(pickableFastInstanceSystems.begin(), pickableFastInstanceSystems.end(), system) == pickableFastInstanceSystems.end()) pickableFastInstanceSystems.push_back(system);
+}
+
+void SceneGraph::unregisterForPicking(InstanceSystem* system)
+{
+	auto it = std::find(pickableInstanceSystems.begin(), pickableInstanceSystems.end(), system);
+	if (it != pickableInstanceSystems.end()) pickableInstanceSystems.erase(it);
+	if (viewedInstanceSystem == system)
+	{
+		viewedInstanceSystem = nullptr;
+		pickedView = nullptr;
+	}
+}
+
+void SceneGraph::unregisterForPicking(FastInstanceSystem* system)
+{
+	auto it = std::find(pickableFastInstanceSystems.begin(), pickableFastInstanceSystems.end(), system);
+	if (it != pickableFastInstanceSystems.end()) pickableFastInstanceSystems.erase(it);
+	if (viewedFastInstanceSystem == system)
+	{
+		viewedFastInstanceSystem = nullptr;
+		pickedView = nullptr;
+	}
+}
+
+void SceneGraph::unregisterComponentForPicking(Component* component)
+{
+	if (InstanceSystem* system = dynamic_cast<InstanceSystem*>(component)) unregisterForPicking(system);
+	else if (FastInstanceSystem* fastSystem = dynamic_cast<FastInstanceSystem*>(component)) unregisterForPicking(fastSystem);
+}
+
+Object* SceneGraph::findPickedObject(unsigned int id)
+{
+	auto it = pickingList.find(id);
+	if (it != pickingList.end()) return it->second;
+
+	commitPickedView();
+	pickedView = nullptr;
+	viewedInstanceSystem = nullptr;
+	viewedFastInstanceSystem = nullptr;
+	for (auto system : pickableInstanceSystems)
+	{
+		int index = system->FindInstance(id);
+		if (index != -1)
+		{
+			viewedInstanceSystem = system;
+			pickedView = system->GetView(index);
+			pickedView->node->localDirty = false;
+			return pickedView;
+		}
+	}
+	for (auto system : pickableFastInstanceSystems)
+	{
+		int handle = system->FindInstance(id);
+		if (handle != -1)
+		{
+			viewedFastInstanceSystem = system;
+			pickedView = system->GetView(handle);
+			pickedView->node->localDirty = false;
+			return pickedView;
+		}
+	}
+	return nullptr;
+}
+
+void SceneGraph::commitPickedView()
+{
+	//the view node is outside the transform arrays, so its dirty flag is only cleared here
+	if (pickedView == nullptr || !pickedView->node->localDirty) return;
+	if (viewedInstanceSystem != nullptr) viewedInstanceSystem->CommitView();
+	else if (viewedFastInstanceSystem != nullptr) viewedFastInstanceSystem->CommitView();
+	pickedView->node->localDirty = false;
+}
+
 Object* SceneGraph::addObject(const char* name, const glm::vec3& pos)
 {
 	return addObjectTo(&SceneRoot, name, pos);
@@ -359,11 +451,24 @@ void SceneGraph::Clear()
 {
 	Object::ResetIDs();
 	dynamicNodeArray.clear();
+	transformHierarchy.Clear();
+	dirtyDynamicArray = true;
+	boundsTree.Clear();
+	unboundedObjects.clear();
+	objectsInFrustum.clear();
+	cullResults.clear();
+	nextCullResult = 0;
+	dirtyBoundsTree = true;
 	dirtyDynamicNodes.clear();
 	dirtyStaticNodes.clear();
 	allObjects.clear();
 	renderList.clear();
 	pickingList.clear();
+	pickableInstanceSystems.clear();
+	pickableFastInstanceSystems.clear();
+	pickedView = nullptr;
+	viewedInstanceSystem = nullptr;
+	viewedFastInstanceSystem = nullptr;
 
 	pointLights.clear();
 	spotLights.clear();
@@ -594,7 +699,6 @@ glm::vec3 SceneGraph::generateRandomIntervallVectorFlat(int min, int max, axis a
 // generalize frustum culling so that we can reuse it for different things
 void SceneGraph::FrustumCulling()
 {
-	objectsInFrustum.clear();
 	//problem with this now is that
 	// 1 by default inFrustum is false
 	// 2 objects that don't have bounds are not added to objectsInFrustum
@@ -609,6 +713,25 @@ void SceneGraph::FrustumCulling()
 	}
 	*/
 	
+	if (useBoundsTree)
+	{
+		for (auto* object : objectsInFrustum)
+		{
+			object->inFrustum = false;
+		}
+		objectsInFrustum.clear();
+		UpdateBoundsTree();
+		const CullResult& result = CullBoundsTree(frustum);
+		objectsInFrustum.insert(objectsInFrustum.end(), unboundedObjects.begin(), unboundedObjects.end());
+		objectsInFrustum.insert(objectsInFrustum.end(), result.objects.begin(), result.objects.end());
+		for (auto* object : objectsInFrustum)
+		{
+			object->inFrustum = true;
+		}
+		return;
+	}
+
+	objectsInFrustum.clear();
 	for (auto* object : allObjects)
 	{
 		Bounds* bounds = object->GetComponent<Bounds>(); // we should have list of all bounds components
@@ -625,6 +748,81 @@ void SceneGraph::FrustumCulling()
 	}
 }
 
+void SceneGraph::UpdateBoundsTree()
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+	std::chrono::duration<double> elapsed_seconds;
+
+	start = std::chrono::high_resolution_clock::now();
+	//components like bounds are usually added right after the object so a new node or object is the signal to rebuild
+	if (dirtyBoundsTree || boundsTreeObjectCount != allObjects.size() || boundsTreeHierarchyVersion != Node::hierarchyVersion)
+	{
+		boundsTree.Build(allObjects);
+		unboundedObjects.clear();
+		for (auto* object : allObjects)
+		{
+			if (object->bounds == nullptr) unboundedObjects.push_back(object);
+		}
+		dirtyBoundsTree = false;
+		boundsTreeObjectCount = allObjects.size();
+		boundsTreeHierarchyVersion = Node::hierarchyVersion;
+	}
+	else
+	{
+		boundsTree.Refit();
+	}
+	end = std::chrono::high_resolution_clock::now();
+	elapsed_seconds = end - start;
+	boundsTreeTime = elapsed_seconds.count();
+}
+
+void SceneGraph::RebuildBoundsTree()
+{
+	dirtyBoundsTree = true;
+}
+
+const SceneGraph::CullResult& SceneGraph::CullBoundsTree(const Frustum& cullFrustum)
+{
+	for (auto& result : cullResults)
+	{
+		if (result.treeVersion == boundsTree.version && result.frustum.HasSamePlanes(cullFrustum)) return result;
+	}
+
+	std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+	std::chrono::duration<double> elapsed_seconds;
+	start = std::chrono::high_resolution_clock::now();
+
+	CullResult* result;
+	if (cullResults.size() < maxCullResults)
+	{
+		cullResults.emplace_back();
+		result = &cullResults.back();
+	}
+	else
+	{
+		result = &cullResults[nextCullResult];
+		nextCullResult = (nextCullResult + 1) % maxCullResults;
+	}
+	for (auto* object : result->objects)
+	{
+		if (object->ID < result->visible.size()) result->visible[object->ID] = 0;
+	}
+	result->objects.clear();
+	result->frustum = cullFrustum;
+	result->treeVersion = boundsTree.version;
+	boundsTree.Cull(cullFrustum, result->objects);
+	result->visible.resize(Object::Count(), 0);
+	for (auto* object : result->objects)
+	{
+		result->visible[object->ID] = 1;
+	}
+
+	end = std::chrono::high_resolution_clock::now();
+	elapsed_seconds = end - start;
+	cullTime = elapsed_seconds.count();
+	return *result;
+}
+
 void SceneGraph::BuildDynamicNodeArray()
 {
 	//we could first search for all root nodes
@@ -638,6 +836,7 @@ void SceneGraph::BuildDynamicNodeArray()
 	}
 	*/
 	dynamicNodeArray.clear();
+	dirtyDynamicArray = true;
 	if (SceneRoot.GetMovable())
 		dynamicNodeArray.push_back(&SceneRoot);
 	else
@@ -678,6 +877,7 @@ void SceneGraph::SwitchNodeMovableMode(Node* node, bool movable)
 {
 	bool stateChanged = node->SetMovable(movable);
 	UpdateDynamicAndStaticArrays(node, movable, stateChanged);
+	if (stateChanged) dirtyBoundsTree = true;
 }
 
 void SceneGraph::UpdateDynamicAndStaticArrays(Node* node, bool movable, bool stateChanged)
@@ -709,6 +909,7 @@ void SceneGraph::UpdateDynamicAndStaticArrays(Node* node, bool movable, bool sta
 		{
 			dynamicNodeArray[dynamicNodeIndex] = dynamicNodeArray.back();
 			dynamicNodeArray.pop_back();
+			dirtyDynamicArray = true;
 		}
 	}
 }
@@ -744,6 +945,8 @@ void SceneGraph::Update()
 	std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
 	std::chrono::duration<double> elapsed_seconds;
 
+	commitPickedView();
+
 	start = std::chrono::high_resolution_clock::now();
 	//this is already so complex it might not actually save performance and
 	//building new dynamic array on a change might be better, it does not require handling of any edge cases, bug free
@@ -769,6 +972,7 @@ void SceneGraph::Update()
 			dynamicNodeArray.push_back(node);
 		}
 	}
+	if (!dirtyDynamicNodes.empty() || !dirtyStaticNodes.empty()) dirtyDynamicArray = true;
 	dirtyDynamicNodes.clear();
 	for (auto node : dirtyStaticNodes)
 	{
@@ -790,9 +994,22 @@ void SceneGraph::Update()
 	updateDynamicArrayTime = elapsed_seconds.count();
 
 	start = std::chrono::high_resolution_clock::now();
-	for (auto node : dynamicNodeArray)
+	if (useTransformHierarchy)
 	{
-		node->UpdateNode(*node->parent);
+		if (dirtyDynamicArray || transformHierarchyVersion != Node::hierarchyVersion)
+		{
+			transformHierarchy.Build(dynamicNodeArray);
+			transformHierarchyVersion = Node::hierarchyVersion;
+			dirtyDynamicArray = false;
+		}
+		transformHierarchy.Update(useParallelUpdate && JobSystem::Instance()->GetWorkerCount() > 0);
+	}
+	else
+	{
+		for (auto node : dynamicNodeArray)
+		{
+			node->UpdateNode(*node->parent);
+		}
 	}
 	end = std::chrono::high_resolution_clock::now();
 	elapsed_seconds = end - start;
@@ -800,10 +1017,29 @@ void SceneGraph::Update()
 
 	start = std::chrono::high_resolution_clock::now();
 	
-	for (auto object : allObjects)
+	if (useParallelUpdate && JobSystem::Instance()->GetWorkerCount() > 0)
+	{
+		JobSystem::Instance()->ParallelFor(allObjects.size(), componentChunkSize, [this](size_t begin, size_t end, unsigned int)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				allObjects[i]->UpdateComponents(true);
+			}
+		});
+		//scripts and components touching gl or other singletons
+		for (auto object : allObjects)
+		{
+			object->Update();
+			object->UpdateComponents(false);
+		}
+	}
+	else
 	{
-		object->Update();
-		object->UpdateComponents();
+		for (auto object : allObjects)
+		{
+			object->Update();
+			object->UpdateComponents();
+		}
 	}
 	end = std::chrono::high_resolution_clock::now();
 	elapsed_seconds = end - start;
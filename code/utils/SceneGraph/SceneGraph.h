@@ -8,6 +8,8 @@
 #include "GraphicsStorage.h"
 #include "Node.h"
 #include "Frustum.h"
+#include "TransformHierarchy.h"
+#include "BoundsTree.h"
 
 class Object;
 class DirectionalLight;
@@ -17,6 +19,7 @@ class InstanceSystem;
 class FastInstanceSystem;
 class Node;
 class Material;
+class Component;
 
 class SceneGraph
 {
@@ -36,6 +39,18 @@ public:
 	void registerForPicking(Object* object); //helper function for registering objects for picking
 	void unregisterForPicking(Object* object);
 	std::unordered_map<unsigned int, Object*> pickingList; //picking list, only for look-ups
+	void registerForPicking(InstanceSystem* system); //instance ids are resolved by the system that reserved them
+	void registerForPicking(FastInstanceSystem* system);
+	void unregisterForPicking(InstanceSystem* system);
+	void unregisterForPicking(FastInstanceSystem* system);
+	//call before a component is removed from its object, instance systems stop resolving their ids
+	void unregisterComponentForPicking(Component* component);
+	//looks the id up in the picking list and then in the instance systems, a picked instance comes back as its system's shared view
+	//moving the view writes it back to the instance on the next update or pick
+	Object* findPickedObject(unsigned int id);
+	void commitPickedView();
+	std::vector<InstanceSystem*> pickableInstanceSystems;
+	std::vector<FastInstanceSystem*> pickableFastInstanceSystems;
 	std::vector<Object*> renderList; //render list
 	std::vector<Object*> pointLights; //render list
 	std::vector<Object*> spotLights; //render list
@@ -50,6 +65,12 @@ public:
 	Frustum frustum;
 	int count = 0;
 	std::vector<Node*> dynamicNodeArray;
+	//flat copy of the subtrees in dynamicNodeArray, rebuilt when the array or any children list changes
+	bool useTransformHierarchy = true;
+	TransformHierarchy transformHierarchy;
+	//transforms and thread safe components are updated on the job system, the rest stays on the main thread
+	bool useParallelUpdate = true;
+	size_t componentChunkSize = 64;
 	void BuildDynamicNodeArray();
 	void SearchNodeForMovables(Node* nodeToSearch);
 	void SwitchObjectMovableMode(Object* object, bool movable);
@@ -91,6 +112,24 @@ public:
 	void UnparentInPlace(Node* child, Node* newParent);
 
 	void FrustumCulling();
+	//bounding volume hierarchy over the object bounds, rebuilt when objects are added or switch movable mode and refit otherwise
+	bool useBoundsTree = true;
+	BoundsTree boundsTree;
+	std::vector<Object*> unboundedObjects;
+	void UpdateBoundsTree();
+	void RebuildBoundsTree();
+	//cull result per distinct frustum, reused by every pass with the same planes until the tree changes
+	struct CullResult
+	{
+		Frustum frustum;
+		unsigned int treeVersion;
+		std::vector<Object*> objects;
+		//indexed by object ID
+		std::vector<unsigned char> visible;
+	};
+	const CullResult& CullBoundsTree(const Frustum& frustum);
+	double boundsTreeTime;
+	double cullTime;
 	void InitializeSceneTree();
 	void Update();
 	void Clear();
@@ -106,5 +145,15 @@ private:
     SceneGraph(const SceneGraph&);
     //assign
     SceneGraph& operator=(const SceneGraph&);
+	Object* pickedView = nullptr;
+	InstanceSystem* viewedInstanceSystem = nullptr;
+	FastInstanceSystem* viewedFastInstanceSystem = nullptr;
 	bool dirtyDynamicArray;
+	unsigned int transformHierarchyVersion;
+	bool dirtyBoundsTree;
+	size_t boundsTreeObjectCount;
+	unsigned int boundsTreeHierarchyVersion;
+	std::vector<CullResult> cullResults;
+	size_t nextCullResult;
+	static const size_t maxCullResults = 8;
 };
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "TransformHierarchy.h"
+#include "Node.h"
+#include "JobSystem.h"
+
+TransformHierarchy::TransformHierarchy()
+{
+	rebuilt = false;
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+}
+
+void TransformHierarchy::Build(const std::vector<Node*>& roots)
+{
+	Clear();
+	for (auto root : roots)
+	{
+		nodes.push_back(root);
+		parents.push_back(noParent);
+		rootParentVersions.push_back(root->parent->worldVersion);
+	}
+
+	//breadth first over all roots at once, children are appended after the whole level of their parents
+	size_t levelBegin = 0;
+	while (levelBegin < nodes.size())
+	{
+		size_t levelEnd = nodes.size();
+		levelOffsets.push_back((unsigned int)levelBegin);
+		for (size_t i = levelBegin; i < levelEnd; i++)
+		{
+			for (auto child : nodes[i]->children)
+			{
+				nodes.push_back(child);
+				parents.push_back((unsigned int)i);
+			}
+		}
+		levelBegin = levelEnd;
+	}
+	levelOffsets.push_back((unsigned int)nodes.size());
+
+	localPositions.resize(nodes.size());
+	localRotationScales.resize(nodes.size());
+	localScales.resize(nodes.size());
+	worldTransforms.resize(nodes.size());
+	totalScales.resize(nodes.size());
+	changed.resize(nodes.size());
+	//every node is gathered and composed on the first update after a rebuild
+	rebuilt = true;
+}
+
+void TransformHierarchy::Update(bool parallel)
+{
+	if (!parallel)
+	{
+		GatherLocals(0, nodes.size());
+		ComposeWorld(0, nodes.size());
+		WriteBack(0, nodes.size());
+		rebuilt = false;
+		return;
+	}
+
+	JobSystem* jobSystem = JobSystem::Instance();
+	jobSystem->ParallelFor(nodes.size(), chunkSize, [this](size_t begin, size_t end, unsigned int) { GatherLocals(begin, end); });
+	//nodes of one level only read world transforms of the level above, so each level is split over the threads
+	for (size_t level = 0; level + 1 < levelOffsets.size(); level++)
+	{
+		size_t levelBegin = levelOffsets[level];
+		size_t levelSize = levelOffsets[level + 1] - levelBegin;
+		jobSystem->ParallelFor(levelSize, chunkSize, [this, levelBegin](size_t begin, size_t end, unsigned int) { ComposeWorld(levelBegin + begin, levelBegin + end); });
+	}
+	jobSystem->ParallelFor(nodes.size(), chunkSize, [this](size_t begin, size_t end, unsigned int) { WriteBack(begin, end); });
+	rebuilt = false;
+}
+
+void TransformHierarchy::Clear()
+{
+	nodes.clear();
+	parents.clear();
+	levelOffsets.clear();
+	localPositions.clear();
+	localRotationScales.clear();
+	localScales.clear();
+	worldTransforms.clear();
+	totalScales.clear();
+	changed.clear();
+	rootParentVersions.clear();
+}
+
+void TransformHierarchy::GatherLocals(size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		Node* node = nodes[i];
+		if (!rebuilt && !node->localDirty)
+		{
+			changed[i] = 0;
+			continue;
+		}
+		localPositions[i] = glm::vec3(node->LocalPositionM[3]);
+		localRotationScales[i] = node->GetLocalRotationScale();
+		localScales[i] = node->localScale;
+		node->localDirty = false;
+		changed[i] = 1;
+	}
+}
+
+void TransformHierarchy::ComposeWorld(size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		unsigned int parent = parents[i];
+		if (parent == noParent)
+		{
+			//roots hang under static nodes whose transforms are not part of the arrays
+			const Node* parentNode = nodes[i]->parent;
+			if (parentNode->worldVersion != rootParentVersions[i])
+			{
+				rootParentVersions[i] = parentNode->worldVersion;
+				changed[i] = 1;
+			}
+			if (!changed[i]) continue;
+			Node::ComposeTransform(localPositions[i], localRotationScales[i], parentNode->TopDownTransform, worldTransforms[i]);
+			totalScales[i] = localScales[i] * parentNode->totalScale;
+		}
+		else
+		{
+			if (changed[parent]) changed[i] = 1;
+			if (!changed[i]) continue;
+			Node::ComposeTransform(localPositions[i], localRotationScales[i], worldTransforms[parent], worldTransforms[i]);
+			totalScales[i] = localScales[i] * totalScales[parent];
+		}
+	}
+}
+
+void TransformHierarchy::WriteBack(size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		if (!changed[i]) continue;
+		Node* node = nodes[i];
+		node->TopDownTransform = worldTransforms[i];
+		node->totalScale = totalScales[i];
+		node->worldVersion++;
+	}
+}
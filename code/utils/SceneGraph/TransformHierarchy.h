@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include "MyMathLib.h"
+
+class Node;
+
+//flattened copy of the dynamic subtrees, nodes are stored level by level so every parent comes before its children
+//local and world transforms live in separate tightly packed arrays and are updated in one linear pass
+class TransformHierarchy
+{
+public:
+	TransformHierarchy();
+	~TransformHierarchy();
+	void Build(const std::vector<Node*>& roots);
+	void Update(bool parallel = false);
+	void Clear();
+	size_t Size() const { return nodes.size(); }
+
+	static const unsigned int noParent = 0xFFFFFFFFu;
+	std::vector<Node*> nodes;
+	std::vector<unsigned int> parents;
+	//nodes of depth d are in [levelOffsets[d], levelOffsets[d + 1])
+	std::vector<unsigned int> levelOffsets;
+	std::vector<glm::vec3> localPositions;
+	std::vector<glm::mat3> localRotationScales;
+	std::vector<glm::vec3> localScales;
+	std::vector<glm::mat4> worldTransforms;
+	std::vector<glm::vec3> totalScales;
+	//nodes whose local transform or any ancestor changed this update, only those are composed and written back
+	std::vector<unsigned char> changed;
+	//last seen worldVersion of the static parent of every root
+	std::vector<unsigned int> rootParentVersions;
+	size_t chunkSize = 1024;
+private:
+	void GatherLocals(size_t begin, size_t end);
+	void ComposeWorld(size_t begin, size_t end);
+	void WriteBack(size_t begin, size_t end);
+	bool rebuilt;
+};